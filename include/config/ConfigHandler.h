@@ -11,8 +11,35 @@ namespace fs = std::filesystem;
 
 struct Config {
     int maxSizeMB;
+    // RAM snapshots for warm restarts (optional "ram.snapshot" section).
+    bool ramSnapshotEnabled;
+    std::string ramSnapshotFile;
+    int ramSnapshotIntervalSeconds;
+    int ramSnapshotLoadThreads;
+    // Append-only log of RAM writes (optional "ram.appendLog" section).
+    bool ramAppendLogEnabled;
+    std::string ramAppendLogFile;
+    // "always", "everysec" or "never".
+    std::string ramAppendLogFsync;
+    long long ramAppendLogRewriteMinBytes;
+    int ramAppendLogRewriteGrowthPercent;
     std::string dbFile;
+    // Persistent backend: "sqlite" (default), "bitcask", "lsm" or "mmap".
+    std::string diskBackend;
+    // Number of key-hash shards of the persistent backend (must not change for an existing store).
+    int diskShards;
     std::string socketPath;
+    // Write-behind for persistent SETs (optional "disk.writeBehind" section).
+    bool writeBehindEnabled;
+    int writeBehindMaxLagMs;
+    int writeBehindMaxPending;
+    // Background space reclamation (optional "disk.compaction" section).
+    bool compactionEnabled;
+    int compactionIntervalMs;
+    int compactionStepPauseMs;
+    int compactionMaxBytesPerStep;
+    // Converts an existing SQLite store to incremental auto_vacuum at startup (full, blocking VACUUM).
+    bool compactionConvertExisting;
 };
 
 class ConfigHandler {
@@ -29,8 +56,43 @@ public:
         ifs >> j;
 
         config_.maxSizeMB = j.at("ram").at("maxSizeMB").get<int>();
+        const nlohmann::json snapshot = j.at("ram").value("snapshot", nlohmann::json::object());
+        config_.ramSnapshotEnabled = snapshot.value("enabled", false);
+        config_.ramSnapshotFile = fs::absolute(snapshot.value("file", "db/ram_snapshot.acmdump")).string();
+        config_.ramSnapshotIntervalSeconds = snapshot.value("intervalSeconds", 300);
+        config_.ramSnapshotLoadThreads = snapshot.value("loadThreads", 4);
+        if (config_.ramSnapshotLoadThreads < 1) {
+            throw std::runtime_error("ram.snapshot.loadThreads must be at least 1.");
+        }
+        const nlohmann::json appendLog = j.at("ram").value("appendLog", nlohmann::json::object());
+        config_.ramAppendLogEnabled = appendLog.value("enabled", false);
+        config_.ramAppendLogFile = fs::absolute(appendLog.value("file", "db/ram_oplog.aof")).string();
+        config_.ramAppendLogFsync = appendLog.value("fsync", "everysec");
+        if (config_.ramAppendLogFsync != "always" && config_.ramAppendLogFsync != "everysec" &&
+            config_.ramAppendLogFsync != "never") {
+            throw std::runtime_error("ram.appendLog.fsync must be \"always\", \"everysec\" or \"never\".");
+        }
+        config_.ramAppendLogRewriteMinBytes = appendLog.value("rewriteMinBytes", 64LL * 1024 * 1024);
+        config_.ramAppendLogRewriteGrowthPercent = appendLog.value("rewriteGrowthPercent", 100);
         config_.dbFile = fs::absolute(j.at("disk").at("dbFile").get<std::string>()).string();
+        config_.diskBackend = j.at("disk").value("backend", "sqlite");
+        config_.diskShards = j.at("disk").value("shards", 1);
+        if (config_.diskShards < 1) {
+            throw std::runtime_error("disk.shards must be at least 1.");
+        }
         config_.socketPath = fs::absolute(j.at("socket").at("socketPath").get<std::string>()).string();
+
+        const nlohmann::json writeBehind = j.at("disk").value("writeBehind", nlohmann::json::object());
+        config_.writeBehindEnabled = writeBehind.value("enabled", false);
+        config_.writeBehindMaxLagMs = writeBehind.value("maxLagMs", 100);
+        config_.writeBehindMaxPending = writeBehind.value("maxPendingEntries", 10000);
+
+        const nlohmann::json compaction = j.at("disk").value("compaction", nlohmann::json::object());
+        config_.compactionEnabled = compaction.value("enabled", true);
+        config_.compactionIntervalMs = compaction.value("intervalMs", 1000);
+        config_.compactionStepPauseMs = compaction.value("stepPauseMs", 10);
+        config_.compactionMaxBytesPerStep = compaction.value("maxBytesPerStep", 262144);
+        config_.compactionConvertExisting = compaction.value("convertExisting", false);
     }
 
     const Config& getConfig() const {
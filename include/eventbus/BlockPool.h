@@ -0,0 +1,170 @@
+#ifndef BLOCKPOOL_H
+#define BLOCKPOOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+// =========================
+// Recycling pool for fixed-size blocks
+// =========================
+// Every send() creates one result state, which the sender and a worker share and which
+// is usually released on another thread than the one that created it. Freed blocks go
+// to a per-thread cache; a full cache hands half of its blocks to a shared list, and an
+// empty cache refills from there. After a short warm-up, a steady stream of requests
+// therefore reuses the same blocks instead of calling the heap for each one.
+template <size_t Size>
+class BlockPool {
+public:
+    static void* allocate() {
+        Cache& cache = localCache();
+        if (!cache.head) {
+            refill(cache);
+        }
+        if (Node* node = cache.head) {
+            cache.head = node->next;
+            --cache.size;
+            return node;
+        }
+        return ::operator new(kBlockSize);
+    }
+
+    static void deallocate(void* block) {
+        Cache& cache = localCache();
+        if (cache.size == kCacheSize) {
+            spill(cache, kCacheSize / 2);
+        }
+        Node* node = static_cast<Node*>(block);
+        node->next = cache.head;
+        cache.head = node;
+        ++cache.size;
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    static constexpr size_t kBlockSize = std::max(Size, sizeof(Node));
+    static constexpr size_t kCacheSize = 64;
+    // Blocks kept in the shared list beyond this are returned to the heap.
+    static constexpr size_t kSharedLimit = 4096;
+
+    struct Cache {
+        Node* head = nullptr;
+        size_t size = 0;
+
+        ~Cache() {
+            spill(*this, size);
+        }
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        Node* head = nullptr;
+        size_t size = 0;
+
+        ~Shared() {
+            while (head) {
+                Node* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+
+    static Cache& localCache() {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    static Shared& shared() {
+        static Shared list;
+        return list;
+    }
+
+    static void refill(Cache& cache) {
+        Shared& list = shared();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        while (list.head && cache.size < kCacheSize / 2) {
+            Node* node = list.head;
+            list.head = node->next;
+            --list.size;
+            node->next = cache.head;
+            cache.head = node;
+            ++cache.size;
+        }
+    }
+
+    static void spill(Cache& cache, size_t count) {
+        Shared& list = shared();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        for (; count > 0 && cache.head; --count) {
+            Node* node = cache.head;
+            cache.head = node->next;
+            --cache.size;
+            if (list.size < kSharedLimit) {
+                node->next = list.head;
+                list.head = node;
+                ++list.size;
+            } else {
+                ::operator delete(node);
+            }
+        }
+    }
+};
+
+// Blocks for requests whose size is only known at run time (e.g. coroutine frames):
+// each request is served by the smallest of the ascending Sizes that fits, larger
+// requests go to the heap.
+template <size_t... Sizes>
+class SizeClassPool {
+public:
+    static void* allocate(size_t size) {
+        void* block = nullptr;
+        ((size <= Sizes && (block = BlockPool<Sizes>::allocate()) != nullptr) || ...);
+        return block ? block : ::operator new(size);
+    }
+
+    static void deallocate(void* block, size_t size) {
+        if (!((size <= Sizes && (BlockPool<Sizes>::deallocate(block), true)) || ...)) {
+            ::operator delete(block);
+        }
+    }
+};
+
+// Standard allocator over BlockPool, e.g. for std::allocate_shared. Only single objects
+// are pooled; arrays go to the heap.
+template <typename T>
+class BlockPoolAllocator {
+public:
+    using value_type = T;
+
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "BlockPool blocks use the default alignment");
+
+    BlockPoolAllocator() noexcept = default;
+
+    template <typename U>
+    BlockPoolAllocator(const BlockPoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(BlockPool<sizeof(T)>::allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, size_t n) noexcept {
+        if (n == 1) {
+            BlockPool<sizeof(T)>::deallocate(block);
+        } else {
+            ::operator delete(block);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const BlockPoolAllocator<U>&) const noexcept { return true; }
+};
+
+#endif // BLOCKPOOL_H
@@ -3,21 +3,30 @@
 
 #include <functional>
 #include <future>
-#include <shared_mutex>   // Für std::shared_mutex, std::shared_lock
-#include <typeindex>
-#include <unordered_map>
+#include <array>
+#include <string_view>
 #include <stdexcept>
 #include <iostream>
 #include <chrono>
 #include <ctime>
-#include <queue>
 #include <thread>
 #include <condition_variable>
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <optional>
+#include <variant>
+#include <tuple>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <coroutine>
+#include <span>
 
 #include <eventbus/Message.h>
+#include <eventbus/MpmcQueue.h>
+#include <eventbus/TaskFunction.h>
+#include <eventbus/BlockPool.h>
 
 // Logging macros with a consistent layout.
 #define LOG_INFO(component, message) \
@@ -29,27 +38,48 @@
 // =========================
 // Simple ThreadPool class
 // =========================
+// Work-stealing pool. Tasks posted from outside go to a bounded lock-free MpmcQueue;
+// tasks posted by a worker go to that worker's own deque, which it drains LIFO, so a
+// handler's follow-up work (continuations, nested sends) runs next on the same thread
+// while its data is still in cache. Idle workers steal the oldest task from other
+// workers' deques. An idle worker spins for a short while before it parks on a
+// condition variable, and producers only touch the park mutex when a worker is parked.
+// Outside producers that find the shared queue full do the same: they retry for a short
+// while, then park until a worker has taken a task from it.
+// Tasks are TaskFunctions and both queues keep their slots, so posting a small task
+// does not allocate.
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t numThreads) : stop(false) {
+    static constexpr size_t kDefaultQueueCapacity = 8192;
+
+    explicit ThreadPool(size_t numThreads, size_t queueCapacity = kDefaultQueueCapacity)
+        : tasks(queueCapacity), stop(false) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            locals.push_back(std::make_unique<LocalQueue>());
+        }
         // Create worker threads.
         for (size_t i = 0; i < numThreads; ++i) {
-            workers.emplace_back([this] {
-                for (;;) {
-                    std::function<void()> task;
-
-                    {
-                        std::unique_lock<std::mutex> lock(queueMutex);
-                        condition.wait(lock, [this] { return stop || !tasks.empty(); });
-                        if (stop && tasks.empty())
-                            return;
-                        task = std::move(tasks.front());
-                        tasks.pop();
-                    }
-                    task();
-                }
-            });
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    // Runs task on a worker; no future is created (exceptions must be handled by task).
+    // If the shared queue is full, an outside caller waits for a free slot (see pushWhenFree).
+    void post(TaskFunction task) {
+        if (stop.load())
+            throw std::runtime_error("post on stopped ThreadPool");
+        const WorkerSlot& slot = currentWorker();
+        if (slot.pool == this) {
+            LocalQueue& local = *locals[slot.index];
+            {
+                std::lock_guard<std::mutex> lock(local.mutex);
+                local.pushBack(std::move(task));
+                localPending.fetch_add(1);
+            }
+        } else if (!tasks.tryPush(std::move(task))) {
+            pushWhenFree(task);
         }
+        wakeOne();
     }
 
     // Enqueue a new task.
@@ -63,33 +93,182 @@ public:
         );
 
         std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            if (stop)
-                throw std::runtime_error("enqueue on stopped ThreadPool");
-            tasks.emplace([task]() { (*task)(); });
-        }
-        condition.notify_one();
+        if (stop.load())
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        post([task]() { (*task)(); });
         return res;
     }
 
     ~ThreadPool() {
         {
-            std::unique_lock<std::mutex> lock(queueMutex);
+            std::unique_lock<std::mutex> lock(parkMutex);
             stop = true;
         }
-        condition.notify_all();
+        parkCondition.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(spaceMutex);
+        }
+        spaceCondition.notify_all();
         for (std::thread &worker : workers)
             worker.join();
     }
 
 private:
+    // Polls before parking; a burst of requests then rarely pays for a wakeup.
+    static constexpr int kSpinRounds = 64;
+
+    // Deque of one worker: the owner pushes and pops at the back, thieves take the front.
+    // A ring that only grows, so a busy worker stops allocating once it is large enough.
+    struct LocalQueue {
+        std::mutex mutex;
+        std::vector<TaskFunction> ring = std::vector<TaskFunction>(64);
+        size_t head = 0;
+        size_t count = 0;
+
+        void pushBack(TaskFunction task) {
+            if (count == ring.size()) {
+                std::vector<TaskFunction> grown(ring.size() * 2);
+                for (size_t i = 0; i < count; ++i) {
+                    grown[i] = std::move(ring[(head + i) % ring.size()]);
+                }
+                ring = std::move(grown);
+                head = 0;
+            }
+            ring[(head + count) % ring.size()] = std::move(task);
+            ++count;
+        }
+
+        TaskFunction popBack() {
+            --count;
+            return std::move(ring[(head + count) % ring.size()]);
+        }
+
+        TaskFunction popFront() {
+            TaskFunction task = std::move(ring[head]);
+            head = (head + 1) % ring.size();
+            --count;
+            return task;
+        }
+    };
+
+    // Identifies the pool and worker that runs on the current thread.
+    struct WorkerSlot {
+        ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    std::vector<std::unique_ptr<LocalQueue>> locals;
+    MpmcQueue<TaskFunction> tasks;
+    // Tasks waiting in the local deques (lets parked workers see stealable work).
+    std::atomic<size_t> localPending{0};
 
-    std::mutex queueMutex;
-    std::condition_variable condition;
-    bool stop;
+    std::atomic<bool> stop;
+    std::atomic<int> parked{0};
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+    // Outside producers parked until the shared queue has a free slot.
+    std::atomic<int> waitingProducers{0};
+    std::mutex spaceMutex;
+    std::condition_variable spaceCondition;
+
+    static WorkerSlot& currentWorker() {
+        thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    void workerLoop(size_t index) {
+        currentWorker() = WorkerSlot{ this, index };
+        TaskFunction task;
+        for (;;) {
+            if (findTask(index, task) || spinFind(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(parkMutex);
+            // Announce the park before the final check; wakeOne() reads parked after its push.
+            parked.fetch_add(1);
+            parkCondition.wait(lock, [this] { return stop.load() || hasWork(); });
+            parked.fetch_sub(1);
+            if (stop.load() && !hasWork())
+                return;
+        }
+    }
+
+    bool hasWork() const {
+        return localPending.load() > 0 || !tasks.empty();
+    }
+
+    // Own deque (newest first), then the shared queue, then the other workers' deques (oldest first).
+    bool findTask(size_t index, TaskFunction& task) {
+        if (takeLocal(*locals[index], task, true))
+            return true;
+        if (tasks.tryPop(task)) {
+            wakeProducer();
+            return true;
+        }
+        for (size_t k = 1; k < locals.size(); ++k) {
+            if (takeLocal(*locals[(index + k) % locals.size()], task, false))
+                return true;
+        }
+        return false;
+    }
+
+    bool takeLocal(LocalQueue& local, TaskFunction& task, bool newest) {
+        std::lock_guard<std::mutex> lock(local.mutex);
+        if (local.count == 0)
+            return false;
+        task = newest ? local.popBack() : local.popFront();
+        localPending.fetch_sub(1);
+        return true;
+    }
+
+    bool spinFind(size_t index, TaskFunction& task) {
+        for (int i = 0; i < kSpinRounds; ++i) {
+            std::this_thread::yield();
+            if (findTask(index, task))
+                return true;
+        }
+        return false;
+    }
+
+    // Slow path of post(): spins like an idle worker, then parks until a worker pops a task
+    // from the shared queue, so blocked callers do not burn a core while the pool is overloaded.
+    void pushWhenFree(TaskFunction& task) {
+        for (int i = 0; i < kSpinRounds; ++i) {
+            std::this_thread::yield();
+            if (tasks.tryPush(std::move(task)))
+                return;
+        }
+
+        std::unique_lock<std::mutex> lock(spaceMutex);
+        // Announce the wait before retrying; wakeProducer() reads waitingProducers after its pop.
+        waitingProducers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool pushed = false;
+        spaceCondition.wait(lock, [&] { return (pushed = tasks.tryPush(std::move(task))) || stop.load(); });
+        waitingProducers.fetch_sub(1);
+        if (!pushed)
+            throw std::runtime_error("post on stopped ThreadPool");
+    }
+
+    void wakeProducer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waitingProducers.load() > 0) {
+            std::lock_guard<std::mutex> lock(spaceMutex);
+            spaceCondition.notify_one();
+        }
+    }
+
+    void wakeOne() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load() > 0) {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            parkCondition.notify_one();
+        }
+    }
 };
 
 // =========================
@@ -104,160 +283,880 @@ enum class HandlerID {
     DiskHandler = 5,
 };
 
-template <typename RetMsg>
+// Number of HandlerID values; handler tables are arrays indexed by the ID.
+constexpr size_t kHandlerIDCount = static_cast<size_t>(HandlerID::DiskHandler) + 1;
+
+// Dense index per type, handed out the first time the type is subscribed or sent, so the
+// EventBus routes on (HandlerID, index) with two array loads instead of hashing a
+// std::type_index. Also used for response types (including void).
+class TypeIndex {
+public:
+    template <typename T>
+    static size_t of() {
+        static const size_t index = next();
+        return index;
+    }
+
+    // Readable name of T for log output (taken from the compiler's function signature).
+    template <typename T>
+    static std::string_view name() {
+        const std::string_view signature = __PRETTY_FUNCTION__;
+        const size_t start = signature.find("T = ") + 4;
+        return signature.substr(start, signature.find_first_of(";]", start) - start);
+    }
+
+private:
+    static size_t next() {
+        static std::atomic<size_t> counter{0};
+        return counter.fetch_add(1);
+    }
+};
+
+// How send() runs the handler of a message type.
+enum class DispatchMode {
+    // On a ThreadPool worker; send() returns before the handler has run.
+    Pooled,
+    // On the caller's thread before send() returns. Only for handlers that never
+    // block (no I/O, no nested send().get(), short critical sections).
+    Inline,
+};
+
+// =========================
+// EventBusResult, EventBusPromise and whenAll
+// =========================
+// Shared state behind an EventBusResult: the value or the exception, plus at most one
+// callback that runs on the thread that completes the result. The response is built
+// directly in the state and moved out by get(); states come from a BlockPool.
+template <typename T>
+class EventBusState {
+public:
+    using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    static std::shared_ptr<EventBusState> create() {
+        return std::allocate_shared<EventBusState>(BlockPoolAllocator<EventBusState>());
+    }
+
+    template <typename... Args>
+    void setValue(Args&&... args) {
+        // Released after the callback has run.
+        std::shared_ptr<void> owner;
+        TaskFunction callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (done_) {
+                throw std::logic_error("EventBusResult already satisfied");
+            }
+            value_.emplace(std::forward<Args>(args)...);
+            done_ = true;
+            callback = std::move(callback_);
+            owner = std::move(owner_);
+        }
+        cv_.notify_all();
+        if (callback) {
+            callback();
+        }
+    }
+
+    void setException(std::exception_ptr error) {
+        std::shared_ptr<void> owner;
+        TaskFunction callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (done_) {
+                return;
+            }
+            error_ = std::move(error);
+            done_ = true;
+            callback = std::move(callback_);
+            owner = std::move(owner_);
+        }
+        cv_.notify_all();
+        if (callback) {
+            callback();
+        }
+    }
+
+    // Keeps owner (e.g. a message the EventBus took over) alive until the result is ready.
+    void holdUntilReady(std::shared_ptr<void> owner) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!done_) {
+            owner_ = std::move(owner);
+        }
+    }
+
+    // Stores callback unless the result is already ready; returns whether it was stored.
+    // co_await uses this to continue right away instead of resuming from inside itself.
+    bool deferUntilReady(TaskFunction& callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (done_) {
+            return false;
+        }
+        callback_ = std::move(callback);
+        return true;
+    }
+
+    // Runs callback once the result is ready; right away if it already is.
+    void onReady(TaskFunction callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!done_) {
+                callback_ = std::move(callback);
+                return;
+            }
+        }
+        callback();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return done_; });
+    }
+
+    bool ready() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return done_;
+    }
+
+    // Waits, then moves the value out or rethrows the handler's exception.
+    Value take() {
+        wait();
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return std::move(*value_);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    std::optional<Value> value_;
+    std::exception_ptr error_;
+    TaskFunction callback_;
+    std::shared_ptr<void> owner_;
+};
+
+template <typename T>
+class EventBusResult;
+
+template <typename T>
+class EventBusCoroutine;
+
+// Result type of a continuation F applied to a T; continuations returning an
+// EventBusResult<U> are flattened to U.
+template <typename F, typename T>
+struct ContinuationResult { using type = std::invoke_result_t<F, T>; };
+
+template <typename F>
+struct ContinuationResult<F, void> { using type = std::invoke_result_t<F>; };
+
+template <typename R>
+struct UnwrapResult {
+    using type = R;
+    static constexpr bool nested = false;
+};
+
+template <typename U>
+struct UnwrapResult<EventBusResult<U>> {
+    using type = U;
+    static constexpr bool nested = true;
+};
+
+// Outcome of EventBus::send(). get() blocks like std::future::get(); then() attaches a
+// continuation instead, so a handler that fans out to other handlers can return without
+// parking its thread. Continuations run on the thread that completes the result and
+// must not block. Like std::future, the value can be consumed only once (get() or then()).
+//
+// It is also a coroutine type: a function returning EventBusResult<T> may co_await other
+// results (e.g. co_await bus.send<Ret>(id, msg)) and co_return its value. It starts
+// right away on the caller's thread and, after a co_await, continues on the thread that
+// completes the awaited result, like a then() continuation; so it must not block either.
+template <typename T>
 class EventBusResult {
 public:
-    explicit EventBusResult(std::future<std::unique_ptr<RetMsg>> future)
-        : future(std::move(future)) {}
+    using promise_type = EventBusCoroutine<T>;
+
+    explicit EventBusResult(std::shared_ptr<EventBusState<T>> state)
+        : state_(std::move(state)) {}
 
-    RetMsg get() {
-        auto val = future.get();
-        return dynamic_cast<RetMsg&>(*val);
+    T get() {
+        if constexpr (std::is_void_v<T>) {
+            state_->take();
+        } else {
+            return state_->take();
+        }
+    }
+
+    void wait() {
+        state_->wait();
+    }
+
+    bool ready() const {
+        return state_->ready();
+    }
+
+    // Runs callback once the result is ready (get() then no longer blocks).
+    void onReady(TaskFunction callback) {
+        state_->onReady(std::move(callback));
+    }
+
+    bool await_ready() const {
+        return state_->ready();
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+        TaskFunction resume([awaiting] { awaiting.resume(); });
+        return state_->deferUntilReady(resume);
+    }
+
+    T await_resume() {
+        return get();
+    }
+
+    // Returns the result of fn(value). An exception of this result, or one thrown by fn,
+    // is passed on without calling fn.
+    template <typename F>
+    auto then(F fn) -> EventBusResult<typename UnwrapResult<typename ContinuationResult<F, T>::type>::type> {
+        using Raw = typename ContinuationResult<F, T>::type;
+        using U = typename UnwrapResult<Raw>::type;
+        auto next = EventBusState<U>::create();
+        auto state = state_;
+        state_->onReady([state, next, fn = std::move(fn)]() mutable {
+            try {
+                if constexpr (UnwrapResult<Raw>::nested) {
+                    invoke(fn, *state).forwardTo(next);
+                } else if constexpr (std::is_void_v<U>) {
+                    invoke(fn, *state);
+                    next->setValue();
+                } else {
+                    next->setValue(invoke(fn, *state));
+                }
+            } catch (...) {
+                next->setException(std::current_exception());
+            }
+        });
+        return EventBusResult<U>(next);
     }
 
 private:
-    std::future<std::unique_ptr<RetMsg>> future;
+    template <typename> friend class EventBusResult;
+    friend class EventBus;
+
+    std::shared_ptr<EventBusState<T>> state_;
+
+    template <typename F>
+    static decltype(auto) invoke(F& fn, EventBusState<T>& state) {
+        if constexpr (std::is_void_v<T>) {
+            state.take();
+            return fn();
+        } else {
+            return fn(state.take());
+        }
+    }
+
+    // Completes target with this result once it is ready.
+    void forwardTo(std::shared_ptr<EventBusState<T>> target) {
+        auto state = state_;
+        state_->onReady([state, target] {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    state->take();
+                    target->setValue();
+                } else {
+                    target->setValue(state->take());
+                }
+            } catch (...) {
+                target->setException(std::current_exception());
+            }
+        });
+    }
+};
+
+// Coroutine frames of EventBusResult functions are recycled like the result states.
+using CoroutineFramePool = SizeClassPool<256, 512, 1024, 2048, 4096>;
+
+// Promise of an EventBusResult coroutine: co_return completes the result, an escaping
+// exception fails it. The frame is freed as soon as the coroutine has finished.
+template <typename T>
+class EventBusCoroutineBase {
+public:
+    EventBusResult<T> get_return_object() {
+        return EventBusResult<T>(state_);
+    }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() {
+        state_->setException(std::current_exception());
+    }
+
+    static void* operator new(size_t size) {
+        return CoroutineFramePool::allocate(size);
+    }
+
+    static void operator delete(void* frame, size_t size) {
+        CoroutineFramePool::deallocate(frame, size);
+    }
+
+protected:
+    std::shared_ptr<EventBusState<T>> state_ = EventBusState<T>::create();
+};
+
+template <typename T>
+class EventBusCoroutine : public EventBusCoroutineBase<T> {
+public:
+    template <typename U>
+    void return_value(U&& value) {
+        this->state_->setValue(std::forward<U>(value));
+    }
 };
 
 template <>
-class EventBusResult<void> {
+class EventBusCoroutine<void> : public EventBusCoroutineBase<void> {
 public:
-    explicit EventBusResult(std::future<void> future)
-        : future(std::move(future)) {}
+    void return_void() {
+        state_->setValue();
+    }
+};
 
-    void wait() {
-        future.wait();
+// Producer side of an EventBusResult.
+template <typename T>
+class EventBusPromise {
+public:
+    EventBusPromise() : state_(EventBusState<T>::create()) {}
+
+    EventBusResult<T> result() const {
+        return EventBusResult<T>(state_);
+    }
+
+    template <typename... Args>
+    void setValue(Args&&... args) const {
+        state_->setValue(std::forward<Args>(args)...);
+    }
+
+    void setException(std::exception_ptr error) const {
+        state_->setException(std::move(error));
     }
 
 private:
-    std::future<void> future;
+    std::shared_ptr<EventBusState<T>> state_;
+};
+
+// An EventBusResult that is already satisfied.
+template <typename T>
+EventBusResult<std::decay_t<T>> makeReadyResult(T&& value) {
+    EventBusPromise<std::decay_t<T>> promise;
+    promise.setValue(std::forward<T>(value));
+    return promise.result();
+}
+
+// Collects the values of whenAll(); the last result to arrive completes the promise.
+template <typename... Ts>
+struct WhenAllState {
+    std::tuple<std::optional<Ts>...> values;
+    std::atomic<size_t> remaining{sizeof...(Ts)};
+    std::mutex mutex;
+    std::exception_ptr error;
+    EventBusPromise<std::tuple<Ts...>> promise;
+
+    void arrive() {
+        if (--remaining != 0) {
+            return;
+        }
+        if (error) {
+            promise.setException(error);
+            return;
+        }
+        std::apply([this](auto&... value) { promise.setValue(std::move(*value)...); }, values);
+    }
 };
 
+template <size_t I, typename State, typename T>
+void whenAllAttach(const std::shared_ptr<State>& join, EventBusResult<T> result) {
+    result.onReady([join, result]() mutable {
+        try {
+            std::get<I>(join->values).emplace(result.get());
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(join->mutex);
+            if (!join->error) {
+                join->error = std::current_exception();
+            }
+        }
+        join->arrive();
+    });
+}
+
+template <typename... Ts, size_t... Is>
+EventBusResult<std::tuple<Ts...>> whenAllImpl(std::index_sequence<Is...>, EventBusResult<Ts>... results) {
+    auto join = std::make_shared<WhenAllState<Ts...>>();
+    EventBusResult<std::tuple<Ts...>> combined = join->promise.result();
+    (whenAllAttach<Is>(join, std::move(results)), ...);
+    return combined;
+}
+
+// Completes once every result is ready, with all values, or with the first exception.
+template <typename... Ts>
+EventBusResult<std::tuple<Ts...>> whenAll(EventBusResult<Ts>... results) {
+    return whenAllImpl(std::index_sequence_for<Ts...>{}, std::move(results)...);
+}
+
+// Like WhenAllState, for a number of results only known at run time.
+template <typename T>
+struct WhenAllVectorState {
+    explicit WhenAllVectorState(size_t count) : values(count), remaining(count) {}
+
+    std::vector<std::optional<T>> values;
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::exception_ptr error;
+    EventBusPromise<std::vector<T>> promise;
+
+    void arrive() {
+        if (--remaining != 0) {
+            return;
+        }
+        if (error) {
+            promise.setException(error);
+            return;
+        }
+        std::vector<T> collected;
+        collected.reserve(values.size());
+        for (auto& value : values) {
+            collected.push_back(std::move(*value));
+        }
+        promise.setValue(std::move(collected));
+    }
+};
+
+// Completes once every result is ready, with the values in order, or with the first exception.
+template <typename T>
+EventBusResult<std::vector<T>> whenAll(std::vector<EventBusResult<T>> results) {
+    if (results.empty()) {
+        return makeReadyResult(std::vector<T>());
+    }
+    auto join = std::make_shared<WhenAllVectorState<T>>(results.size());
+    EventBusResult<std::vector<T>> combined = join->promise.result();
+    for (size_t i = 0; i < results.size(); ++i) {
+        results[i].onReady([join, i, result = results[i]]() mutable {
+            try {
+                join->values[i].emplace(result.get());
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(join->mutex);
+                if (!join->error) {
+                    join->error = std::current_exception();
+                }
+            }
+            join->arrive();
+        });
+    }
+    return combined;
+}
+
 // =========================
 // EventBus class
 // =========================
 class EventBus {
 public:
     // Constructor: initialize ThreadPool with a fixed number of threads (e.g., 20)
-    EventBus() : threadPool(20) { }
+    explicit EventBus(size_t threads = 20) : threadPool(threads) {
+        handlers_.tables.push_back(std::make_unique<HandlerTable>());
+        handlers_.current.store(handlers_.tables.back().get());
+    }
 
     template <typename TMsg, typename RetMsg>
-    bool subscribe(const HandlerID id, std::function<RetMsg(const TMsg&)> callback) {
+    bool subscribe(const HandlerID id, std::function<RetMsg(const TMsg&)> callback,
+                   DispatchMode mode = DispatchMode::Pooled) {
         static_assert(std::is_base_of_v<Message, TMsg>, "TMsg must inherit from Message!");
         if constexpr (!std::is_void_v<RetMsg>) {
             static_assert(std::is_base_of_v<Message, RetMsg>, "RetMsg must inherit from Message!");
         }
 
-        // Exklusiver Zugriff für Schreibzugriffe.
-        std::unique_lock<std::shared_mutex> lock(handlers_.mutex);
-        auto& handler = handlers_.map[id];
+        // Shared by the per-message and the default batch function.
+        auto shared = std::make_shared<std::function<RetMsg(const TMsg&)>>(std::move(callback));
+        auto fn = [shared](const Message& msg, const std::shared_ptr<void>& state) {
+            EventBusState<RetMsg>& target = *static_cast<EventBusState<RetMsg>*>(state.get());
+            try {
+                if constexpr (std::is_void_v<RetMsg>) {
+                    (*shared)(castMessage<TMsg>(msg));
+                    target.setValue();
+                } else {
+                    target.setValue((*shared)(castMessage<TMsg>(msg)));
+                }
+            } catch (...) {
+                target.setException(std::current_exception());
+            }
+        };
+        HandlerEntry entry{ std::move(fn), TypeIndex::of<RetMsg>(), mode, false, nullptr, false };
+        if constexpr (!std::is_void_v<RetMsg>) {
+            // Without a batch callback, a batch runs the handler once per message in the same task.
+            entry.batchFn = [shared](const void* msgs, size_t count, const std::shared_ptr<void>& state) {
+                EventBusState<std::vector<RetMsg>>& target = *static_cast<EventBusState<std::vector<RetMsg>>*>(state.get());
+                try {
+                    const TMsg* first = static_cast<const TMsg*>(msgs);
+                    std::vector<RetMsg> responses;
+                    responses.reserve(count);
+                    for (size_t i = 0; i < count; ++i) {
+                        responses.push_back((*shared)(first[i]));
+                    }
+                    target.setValue(std::move(responses));
+                } catch (...) {
+                    target.setException(std::current_exception());
+                }
+            };
+        }
+        return addHandler<TMsg>(id, std::move(entry));
+    }
 
-        // Check if already subscribed.
-        const auto it = handler.find(typeid(TMsg));
-        if (it != handler.end()) {
-            LOG_ERROR("EventBus", "Event handler already exists for message type: " << typeid(TMsg).name());
-            throw std::runtime_error("Event handler already exists");
+    // Subscribes a handler that returns an EventBusResult instead of a value, e.g. one that
+    // sends to other handlers and combines their results with then() / whenAll(). The
+    // handler itself must only start that work; it runs inline by default.
+    template <typename TMsg, typename RetMsg>
+    bool subscribeAsync(const HandlerID id, std::function<EventBusResult<RetMsg>(const TMsg&)> callback,
+                        DispatchMode mode = DispatchMode::Inline) {
+        static_assert(std::is_base_of_v<Message, TMsg>, "TMsg must inherit from Message!");
+        if constexpr (!std::is_void_v<RetMsg>) {
+            static_assert(std::is_base_of_v<Message, RetMsg>, "RetMsg must inherit from Message!");
         }
 
-        auto fn = [callback = std::move(callback)](const Message& msg) -> std::unique_ptr<Message> {
-            const TMsg* specificMsg = dynamic_cast<const TMsg*>(&msg);
-            if (!specificMsg) {
-                LOG_ERROR("EventBus", "Message type mismatch in subscribe for message type: " << typeid(TMsg).name());
-                throw std::runtime_error("Message type mismatch in subscribe!");
+        auto shared = std::make_shared<std::function<EventBusResult<RetMsg>(const TMsg&)>>(std::move(callback));
+        auto fn = [shared](const Message& msg, const std::shared_ptr<void>& state) {
+            auto target = std::static_pointer_cast<EventBusState<RetMsg>>(state);
+            try {
+                (*shared)(castMessage<TMsg>(msg)).forwardTo(target);
+            } catch (...) {
+                target->setException(std::current_exception());
             }
+        };
+        HandlerEntry entry{ std::move(fn), TypeIndex::of<RetMsg>(), mode, true, nullptr, false };
+        if constexpr (!std::is_void_v<RetMsg>) {
+            // Without a batch callback, a batch starts the handler for every message and joins the results.
+            entry.batchFn = [shared](const void* msgs, size_t count, const std::shared_ptr<void>& state) {
+                auto target = std::static_pointer_cast<EventBusState<std::vector<RetMsg>>>(state);
+                try {
+                    const TMsg* first = static_cast<const TMsg*>(msgs);
+                    std::vector<EventBusResult<RetMsg>> pending;
+                    pending.reserve(count);
+                    for (size_t i = 0; i < count; ++i) {
+                        pending.push_back((*shared)(first[i]));
+                    }
+                    whenAll(std::move(pending)).forwardTo(target);
+                } catch (...) {
+                    target->setException(std::current_exception());
+                }
+            };
+        }
+        return addHandler<TMsg>(id, std::move(entry));
+    }
+
+    // Delivers msg to the handler; msg must stay alive until the result is ready. Routing
+    // uses the static type TMsg, so pass the message itself, not a Message& to it.
+    template <typename RetMsg, typename TMsg>
+    EventBusResult<RetMsg> send(const HandlerID id, const TMsg& msg) {
+        return route<RetMsg>(id, msg, nullptr);
+    }
+
+    // Takes the message over: it is moved (not copied) into storage that the result owns
+    // and released once the handler has answered. The caller may drop the result right
+    // away (fire-and-forget) or pass it on without keeping the message around.
+    template <typename RetMsg, typename TMsg, typename = std::enable_if_t<!std::is_lvalue_reference_v<TMsg>>>
+    EventBusResult<RetMsg> send(const HandlerID id, TMsg&& msg) {
+        using Msg = std::remove_const_t<TMsg>;
+        auto owned = std::allocate_shared<Msg>(BlockPoolAllocator<Msg>(), std::move(msg));
+        const Msg& routed = *owned;
+        return route<RetMsg>(id, routed, std::move(owned));
+    }
+
+    // Adds a batch-aware callback to the subscription of TMsg on id (subscribe first).
+    // sendBatch() then hands it all messages in one call, so a storage tier can apply
+    // them under one lock or in one transaction. It returns one response per message,
+    // in message order. Plain send() keeps using the per-message callback.
+    template <typename TMsg, typename RetMsg>
+    bool subscribeBatch(const HandlerID id, std::function<std::vector<RetMsg>(std::span<const TMsg>)> callback) {
+        static_assert(std::is_base_of_v<Message, TMsg>, "TMsg must inherit from Message!");
+        static_assert(std::is_base_of_v<Message, RetMsg>, "RetMsg must inherit from Message!");
 
-            if constexpr (std::is_void_v<RetMsg>) {
-                callback(*specificMsg);
-                return nullptr;
-            } else {
-                return std::make_unique<RetMsg>(std::move(callback(*specificMsg)));
+        std::lock_guard<std::mutex> lock(handlers_.writeMutex);
+        const HandlerRow* row = handlers_.current.load()->row(id);
+        const size_t typeIdx = TypeIndex::of<TMsg>();
+        if (!row || typeIdx >= row->size() || !(*row)[typeIdx]) {
+            LOG_ERROR("EventBus", "No handler to add a batch callback to for message type: " << TypeIndex::name<TMsg>());
+            throw std::runtime_error("Event handler not found");
+        }
+        if ((*row)[typeIdx]->response != TypeIndex::of<RetMsg>()) {
+            LOG_ERROR("EventBus", "Batch callback for message type: " << TypeIndex::name<TMsg>()
+                      << " returns " << TypeIndex::name<RetMsg>() << ", the handler does not");
+            throw std::runtime_error("Response type mismatch!");
+        }
+
+        // Entries are immutable once published: the updated one replaces it in a new table.
+        HandlerEntry entry = *(*row)[typeIdx];
+        entry.batchFn = [callback = std::move(callback)](const void* msgs, size_t count, const std::shared_ptr<void>& state) {
+            EventBusState<std::vector<RetMsg>>& target = *static_cast<EventBusState<std::vector<RetMsg>>*>(state.get());
+            try {
+                std::vector<RetMsg> responses = callback(std::span<const TMsg>(static_cast<const TMsg*>(msgs), count));
+                if (responses.size() != count) {
+                    throw std::runtime_error("Batch callback returned " + std::to_string(responses.size())
+                                             + " responses for " + std::to_string(count) + " messages");
+                }
+                target.setValue(std::move(responses));
+            } catch (...) {
+                target.setException(std::current_exception());
             }
         };
+        entry.batchAware = true;
 
-        const std::type_index typeIdx(typeid(TMsg));
-        handler[typeIdx] = std::move(fn);
-
-        LOG_INFO("EventBus", "Subscribed handler for message type: " << typeid(TMsg).name()
+        auto next = std::make_unique<HandlerTable>(*handlers_.current.load());
+        next->rows[static_cast<size_t>(id)][typeIdx] = std::make_shared<const HandlerEntry>(std::move(entry));
+        publish(std::move(next));
+        LOG_INFO("EventBus", "Subscribed batch callback for message type: " << TypeIndex::name<TMsg>()
                  << " on handler ID: " << static_cast<int>(id));
         return true;
     }
 
-    template <typename RetMsg>
-    EventBusResult<RetMsg> send(const HandlerID id, const Message& msg) {
-        // Lesezugriffe werden mit shared_lock abgesichert.
-        std::shared_lock<std::shared_mutex> lock(handlers_.mutex);
+    // Delivers all msgs to the handler of TMsg as one unit: one pool task (or one inline
+    // call) for the whole batch instead of one per message. The responses come back in
+    // message order; if the handler fails, the whole batch fails. As with send(), the
+    // messages must stay alive until the result is ready.
+    template <typename RetMsg, typename TMsg>
+    EventBusResult<std::vector<RetMsg>> sendBatch(const HandlerID id, std::span<const TMsg> msgs) {
+        return routeBatch<RetMsg>(id, msgs, nullptr);
+    }
+
+    template <typename RetMsg, typename TMsg>
+    EventBusResult<std::vector<RetMsg>> sendBatch(const HandlerID id, const std::vector<TMsg>& msgs) {
+        return routeBatch<RetMsg>(id, std::span<const TMsg>(msgs), nullptr);
+    }
+
+    // Takes the messages over (the vector is moved, the messages are not copied).
+    template <typename RetMsg, typename TMsg>
+    EventBusResult<std::vector<RetMsg>> sendBatch(const HandlerID id, std::vector<TMsg>&& msgs) {
+        auto owned = std::make_shared<std::vector<TMsg>>(std::move(msgs));
+        const std::span<const TMsg> routed(*owned);
+        return routeBatch<RetMsg>(id, routed, std::move(owned));
+    }
+
+    template <typename TMsg>
+    bool unsubscribe(const HandlerID id) {
+        static_assert(std::is_base_of_v<Message, TMsg>, "TMsg must inherit from Message!");
+
+        std::lock_guard<std::mutex> lock(handlers_.writeMutex);
+
+        const HandlerRow* row = handlers_.current.load()->row(id);
+        if (!row || row->empty()) {
+            LOG_INFO("EventBus", "No handlers registered for handler ID: " << static_cast<int>(id));
+            return false;  // No entry exists.
+        }
+
+        const size_t typeIdx = TypeIndex::of<TMsg>();
+        if (typeIdx >= row->size() || !(*row)[typeIdx]) {
+            LOG_INFO("EventBus", "Handler for message type: " << TypeIndex::name<TMsg>()
+                     << " was not found under handler ID: " << static_cast<int>(id));
+            return false;
+        }
+
+        auto next = std::make_unique<HandlerTable>(*handlers_.current.load());
+        HandlerRow& nextRow = next->rows[static_cast<size_t>(id)];
+        nextRow[typeIdx].reset();
+        // Trim empty slots at the end; an empty row means the ID has no handlers left.
+        while (!nextRow.empty() && !nextRow.back()) {
+            nextRow.pop_back();
+        }
+        publish(std::move(next));
+        LOG_INFO("EventBus", "Unsubscribed handler for message type: " << TypeIndex::name<TMsg>()
+                 << " from handler ID: " << static_cast<int>(id));
+        return true;
+    }
+
+    // Removes every subscription of id, e.g. when the object behind the handlers is destroyed.
+    // Later sends fail with "Handler not found!" instead of reaching the destroyed object.
+    bool unsubscribeAll(const HandlerID id) {
+        std::lock_guard<std::mutex> lock(handlers_.writeMutex);
+
+        const HandlerRow* row = handlers_.current.load()->row(id);
+        if (!row || row->empty()) {
+            return false;
+        }
+
+        auto next = std::make_unique<HandlerTable>(*handlers_.current.load());
+        next->rows[static_cast<size_t>(id)].clear();
+        publish(std::move(next));
+        LOG_INFO("EventBus", "Unsubscribed all handlers from handler ID: " << static_cast<int>(id));
+        return true;
+    }
+
+private:
+    // Runs the handler on the current thread and completes the EventBusState<RetMsg> behind
+    // state with its response or exception; for an async handler once its result is ready.
+    using HandlerFunction = std::function<void(const Message&, const std::shared_ptr<void>& state)>;
+
+    // Runs the handler for count messages (an array of the subscribed TMsg) and completes
+    // the EventBusState<std::vector<RetMsg>> behind state with one response per message.
+    using BatchFunction = std::function<void(const void* msgs, size_t count, const std::shared_ptr<void>& state)>;
+
+    struct HandlerEntry {
+        HandlerFunction fn;
+        // TypeIndex of the subscription's RetMsg; send() must ask for the same type.
+        size_t response = 0;
+        DispatchMode mode = DispatchMode::Pooled;
+        bool async = false;
+        // Empty for handlers without a response (RetMsg void).
+        BatchFunction batchFn;
+        // Set by subscribeBatch().
+        bool batchAware = false;
+    };
+
+    // Looks up the handler of TMsg on id and runs or queues it; owner (if set) is held
+    // until the result is ready.
+    template <typename RetMsg, typename TMsg>
+    EventBusResult<RetMsg> route(const HandlerID id, const TMsg& msg, std::shared_ptr<void> owner) {
+        static_assert(std::is_base_of_v<Message, TMsg> && !std::is_same_v<TMsg, Message>,
+                      "send() needs the concrete message type!");
+
+        const HandlerEntry& entry = findHandler<RetMsg, TMsg>(id);
+        LOG_INFO("EventBus", "Sending message of type: " << TypeIndex::name<TMsg>()
+                 << " to handler ID: " << static_cast<int>(id));
+
+        // The handler writes its response straight into this state.
+        std::shared_ptr<EventBusState<RetMsg>> state = EventBusState<RetMsg>::create();
+        if (owner) {
+            state->holdUntilReady(std::move(owner));
+        }
+        EventBusResult<RetMsg> result(state);
+        if (entry.mode == DispatchMode::Inline) {
+            entry.fn(msg, state);
+        } else {
+            threadPool.post([&entry, &msg, state = std::move(state)]() {
+                entry.fn(msg, state);
+            });
+        }
+        return result;
+    }
+
+    // The subscription of TMsg on id; throws if there is none or it answers with another type.
+    template <typename RetMsg, typename TMsg>
+    const HandlerEntry& findHandler(const HandlerID id) const {
+        // Lesezugriffe brauchen keine Sperre: die Tabelle wird nach dem Veröffentlichen nie geändert.
+        const HandlerTable& table = *handlers_.current.load(std::memory_order_acquire);
 
-        const auto itHandler = handlers_.map.find(id);
-        if (itHandler == handlers_.map.end()) {
+        const HandlerRow* row = table.row(id);
+        if (!row || row->empty()) {
             LOG_ERROR("EventBus", "Handler not found for ID: " << static_cast<int>(id));
             throw std::runtime_error("Handler not found!");
         }
 
-        const std::type_index typeIdx(typeid(msg));
-        const auto itFunc = itHandler->second.find(typeIdx);
-        if (itFunc == itHandler->second.end()) {
-            LOG_ERROR("EventBus", "Event not found for message type: " << typeIdx.name());
+        const size_t typeIdx = TypeIndex::of<TMsg>();
+        if (typeIdx >= row->size() || !(*row)[typeIdx]) {
+            LOG_ERROR("EventBus", "Event not found for message type: " << TypeIndex::name<TMsg>());
             throw std::runtime_error("Event not found!");
         }
 
-        LOG_INFO("EventBus", "Sending message of type: " << typeIdx.name()
-                 << " to handler ID: " << static_cast<int>(id));
+        const HandlerEntry& entry = *(*row)[typeIdx];
+        if (entry.response != TypeIndex::of<RetMsg>()) {
+            LOG_ERROR("EventBus", "Response type mismatch for message type: " << TypeIndex::name<TMsg>()
+                      << " (requested " << TypeIndex::name<RetMsg>() << ")");
+            throw std::runtime_error("Response type mismatch!");
+        }
 
-        if constexpr (std::is_void_v<RetMsg>) {
-            auto future = threadPool.enqueue([itFunc, &msg]() {
-                itFunc->second(msg); // Call handler (result ignored)
-            });
-            return EventBusResult<void>(std::move(future));
+        // Before a pooled task runs, the entry may be replaced in a newer table; older
+        // tables are kept, so the task's reference stays valid.
+        return entry;
+    }
+
+    template <typename RetMsg, typename TMsg>
+    EventBusResult<std::vector<RetMsg>> routeBatch(const HandlerID id, std::span<const TMsg> msgs, std::shared_ptr<void> owner) {
+        static_assert(std::is_base_of_v<Message, TMsg> && !std::is_same_v<TMsg, Message>,
+                      "sendBatch() needs the concrete message type!");
+        static_assert(!std::is_void_v<RetMsg>, "Batches need handlers with a response!");
+
+        const HandlerEntry& entry = findHandler<RetMsg, TMsg>(id);
+        LOG_INFO("EventBus", "Sending batch of " << msgs.size() << " messages of type: " << TypeIndex::name<TMsg>()
+                 << " to handler ID: " << static_cast<int>(id) << (entry.batchAware ? " (batch callback)" : ""));
+
+        std::shared_ptr<EventBusState<std::vector<RetMsg>>> state = EventBusState<std::vector<RetMsg>>::create();
+        if (owner) {
+            state->holdUntilReady(std::move(owner));
+        }
+        EventBusResult<std::vector<RetMsg>> result(state);
+        if (entry.mode == DispatchMode::Inline) {
+            entry.batchFn(msgs.data(), msgs.size(), state);
         } else {
-            auto future = threadPool.enqueue([itFunc, &msg]() -> std::unique_ptr<RetMsg> {
-                auto result = itFunc->second(msg); // Get the result from the handler
-                return std::unique_ptr<RetMsg>(dynamic_cast<RetMsg*>(result.release()));
+            threadPool.post([&entry, msgs, state = std::move(state)]() {
+                entry.batchFn(msgs.data(), msgs.size(), state);
             });
-            return EventBusResult<RetMsg>(std::move(future));
         }
+        return result;
     }
 
+    // send() only reaches a handler through the slot of its own message type.
     template <typename TMsg>
-    bool unsubscribe(const HandlerID id) {
-        static_assert(std::is_base_of_v<Message, TMsg>, "TMsg must inherit from Message!");
+    static const TMsg& castMessage(const Message& msg) {
+        return static_cast<const TMsg&>(msg);
+    }
 
-        std::unique_lock<std::shared_mutex> lock(handlers_.mutex);
+    // The handler slots of one ID, indexed by TypeIndex; nullptr where nothing is subscribed.
+    using HandlerRow = std::vector<std::shared_ptr<const HandlerEntry>>;
 
-        auto it = handlers_.map.find(id);
-        if (it == handlers_.map.end()) {
-            LOG_INFO("EventBus", "No handlers registered for handler ID: " << static_cast<int>(id));
-            return false;  // No entry exists.
+    // Snapshot of all subscriptions. Never changed once published: subscribe() and
+    // unsubscribe() copy the current table, edit the copy and publish it.
+    struct HandlerTable {
+        std::array<HandlerRow, kHandlerIDCount> rows;
+
+        // nullptr for an unknown ID.
+        const HandlerRow* row(const HandlerID id) const {
+            const size_t idx = static_cast<size_t>(id);
+            return idx < kHandlerIDCount ? &rows[idx] : nullptr;
         }
+    };
 
-        auto& handlersMap = it->second;
-        const std::type_index typeIdx(typeid(TMsg));
-        size_t oldSize = handlersMap.size();
+    // Makes table the one send() sees. Callers hold handlers_.writeMutex.
+    void publish(std::unique_ptr<HandlerTable> table) {
+        handlers_.tables.push_back(std::move(table));
+        handlers_.current.store(handlers_.tables.back().get(), std::memory_order_release);
+    }
 
-        handlersMap.erase(typeIdx);
+    template <typename TMsg>
+    bool addHandler(const HandlerID id, HandlerEntry entry) {
+        // Schreibzugriffe werden untereinander serialisiert.
+        std::lock_guard<std::mutex> lock(handlers_.writeMutex);
+        const HandlerRow* row = handlers_.current.load()->row(id);
+        if (!row) {
+            LOG_ERROR("EventBus", "Unknown handler ID: " << static_cast<int>(id));
+            throw std::runtime_error("Unknown handler ID");
+        }
 
-        // If the handler map is now empty, remove the ID from the main map.
-        if (handlersMap.empty()) {
-            handlers_.map.erase(it);
+        // Check if already subscribed.
+        const size_t typeIdx = TypeIndex::of<TMsg>();
+        if (typeIdx < row->size() && (*row)[typeIdx]) {
+            LOG_ERROR("EventBus", "Event handler already exists for message type: " << TypeIndex::name<TMsg>());
+            throw std::runtime_error("Event handler already exists");
         }
 
-        bool removed = (oldSize != handlersMap.size());
-        if (removed) {
-            LOG_INFO("EventBus", "Unsubscribed handler for message type: " << typeid(TMsg).name()
-                     << " from handler ID: " << static_cast<int>(id));
-        } else {
-            LOG_INFO("EventBus", "Handler for message type: " << typeid(TMsg).name()
-                     << " was not found under handler ID: " << static_cast<int>(id));
+        const DispatchMode mode = entry.mode;
+        const bool async = entry.async;
+        auto next = std::make_unique<HandlerTable>(*handlers_.current.load());
+        HandlerRow& nextRow = next->rows[static_cast<size_t>(id)];
+        if (typeIdx >= nextRow.size()) {
+            nextRow.resize(typeIdx + 1);
         }
-        return removed;
-    }
+        nextRow[typeIdx] = std::make_shared<const HandlerEntry>(std::move(entry));
+        publish(std::move(next));
 
-private:
-    using HandlerFunction = std::function<std::unique_ptr<Message>(const Message&)>;
+        LOG_INFO("EventBus", "Subscribed " << (mode == DispatchMode::Inline ? "inline" : "pooled")
+                 << (async ? " async" : "") << " handler for message type: " << TypeIndex::name<TMsg>()
+                 << " on handler ID: " << static_cast<int>(id));
+        return true;
+    }
 
-    // Verwende einen shared_mutex, um zwischen Lese- und Schreibzugriffen zu unterscheiden.
+    // Read-copy-update: send() reads the current table with one atomic load and no lock.
+    // Subscriptions only change at startup, so old tables are simply kept until the
+    // EventBus is destroyed; a concurrent send() or a queued pooled task may still use
+    // one (or an entry that has been unsubscribed since).
     struct Handlers {
-        std::shared_mutex mutex;
-        std::unordered_map<HandlerID, std::unordered_map<std::type_index, HandlerFunction>> map;
+        std::mutex writeMutex;
+        std::atomic<const HandlerTable*> current{nullptr};
+        // Every table published so far, the current one last.
+        std::vector<std::unique_ptr<const HandlerTable>> tables;
     };
 
     Handlers handlers_;
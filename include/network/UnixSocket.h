@@ -6,11 +6,15 @@
 #include <sys/un.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
 #include <thread>
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
+#include <list>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include "eventbus/EventBus.h"
 #include "storage/Message.h"
@@ -31,6 +35,7 @@ public:
     {}
 
     ~SocketHandler() {
+        closeClients();
         if (serverSocket_ != -1) {
             close(serverSocket_);
         }
@@ -67,21 +72,175 @@ public:
 
         LOG_INFO("SocketHandler", "Socket bound and listening on " << socketPath_);
 
-        // Loop indefinitely to accept client connections.
-        while (true) {
+        // Accept client connections until stop() is called.
+        while (!stopping_) {
             int clientSocket = accept(serverSocket_, nullptr, nullptr);
             if (clientSocket < 0) {
+                if (stopping_) {
+                    break;
+                }
                 perror("accept");
                 continue;
             }
 
             LOG_INFO("SocketHandler", "New client connection accepted. Socket: " << clientSocket);
+            reapClients();
             // Launch a new thread to handle the client connection.
-            std::thread(&SocketHandler::handleClient, this, clientSocket).detach();
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            ClientConnection& client = clients_.emplace_back(clientSocket);
+            client.thread = std::thread([this, &client] {
+                handleClient(client.socket);
+                client.finished = true;
+            });
+        }
+
+        // The handlers behind the EventBus are destroyed once run() returns, so no client
+        // thread may still be sending to them.
+        closeClients();
+    }
+
+    // Makes run() return; run() disconnects the clients and waits for their threads before it
+    // does. Only uses async-signal-safe calls, so it may be called from a signal handler.
+    void stop() {
+        stopping_ = true;
+        if (serverSocket_ != -1) {
+            shutdown(serverSocket_, SHUT_RDWR);
         }
     }
 
 private:
+    // A client connection and the thread serving it. The socket is only closed after the
+    // thread has been joined, so its descriptor cannot be reused while it is still in use.
+    struct ClientConnection {
+        explicit ClientConnection(int s) : socket(s) {}
+
+        int socket;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    // Joins and closes the connections whose thread has ended.
+    void reapClients() {
+        std::list<ClientConnection> done;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            for (auto it = clients_.begin(); it != clients_.end();) {
+                auto next = std::next(it);
+                if (it->finished) {
+                    done.splice(done.end(), clients_, it);
+                }
+                it = next;
+            }
+        }
+        for (auto& client : done) {
+            client.thread.join();
+            close(client.socket);
+        }
+    }
+
+    // Shuts down every open connection, so that its thread leaves the read loop once the
+    // request in progress (if any) is answered, then joins and closes all of them.
+    void closeClients() {
+        std::list<ClientConnection> all;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            all.swap(clients_);
+        }
+        if (!all.empty()) {
+            LOG_INFO("SocketHandler", "Disconnecting " << all.size() << " client(s).");
+        }
+        for (auto& client : all) {
+            shutdown(client.socket, SHUT_RDWR);
+        }
+        for (auto& client : all) {
+            client.thread.join();
+            close(client.socket);
+        }
+    }
+
+    // Entries fetched per chunk when streaming a LIST response.
+    static constexpr size_t kListChunkSize = 1000;
+
+    // Writes the whole buffer (a large response may need several write calls). A client that
+    // has gone away yields false instead of SIGPIPE.
+    static bool sendAll(int socket, const std::string& data) {
+        const char* p = data.data();
+        size_t remaining = data.size();
+        while (remaining > 0) {
+            ssize_t n = send(socket, p, remaining, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            remaining -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Sends one response line; if that fails, the connection is shut down so that the
+    // read loop of handleClient() ends.
+    static void sendResponse(int socket, const std::string& response) {
+        if (!sendAll(socket, response)) {
+            LOG_ERROR("SocketHandler", "Failed to send response: " << std::strerror(errno));
+            shutdown(socket, SHUT_RDWR);
+        }
+    }
+
+    // Reads an optional count field. Negative values are rejected before they can wrap
+    // around to a huge size_t.
+    static size_t readCount(const json& j, const char* field, size_t fallback) {
+        if (!j.contains(field)) {
+            return fallback;
+        }
+        const long long value = j.at(field).get<long long>();
+        if (value < 0) {
+            throw std::invalid_argument(std::string("Invalid ") + field);
+        }
+        return static_cast<size_t>(value);
+    }
+
+    // Sends {"id":...,"response":[...]} chunk by chunk. Errors before the first byte
+    // is written become a normal error response; later ones close the connection.
+    void streamList(int clientSocket, ListEventMessage msg) {
+        std::string out;
+        size_t total = 0;
+        while (true) {
+            // Only the first chunk may fail before anything has been written.
+            auto result = [&] {
+                try {
+                    return eventBus_.send<ListEventReponseMessage>(HandlerID::StorageHandler, msg).get();
+                } catch (const std::exception& e) {
+                    if (total > 0 || !msg.after.empty()) {
+                        LOG_ERROR("SocketHandler", "LIST aborted after " << total << " entries: " << e.what());
+                        shutdown(clientSocket, SHUT_RDWR);
+                    }
+                    throw;
+                }
+            }();
+            if (msg.after.empty()) {
+                out = "{\"id\":" + json(result.id).dump() + ",\"response\":[";
+            }
+            for (const auto& kv : result.response) {
+                if (total++ > 0) {
+                    out += ',';
+                }
+                out += json{ {"key", kv.key}, {"value", kv.value}, {"group", kv.group} }.dump();
+            }
+            if (result.next.empty()) {
+                break;
+            }
+            if (!sendAll(clientSocket, out)) {
+                throw std::runtime_error("Client disconnected during LIST.");
+            }
+            out.clear();
+            msg.after = result.next;
+        }
+        out += "]}\n";
+        sendAll(clientSocket, out);
+        LOG_INFO("SocketHandler", "LIST streamed " << total << " entries.");
+    }
+
     // Handles an individual client connection and keeps it open until the client explicitly closes it or an error occurs.
     void handleClient(int clientSocket) {
         try {
@@ -129,7 +288,68 @@ private:
                         std::string respStr = respJson.dump() + "\n";
 
                         LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
+
+                    } else if (eventType == "MSET") {
+                        // Top-level flags apply to every entry unless the entry has its own.
+                        MSetEventMessage msg;
+                        msg.id = j.at("id").get<std::string>();
+                        const json defaults = j.value("flags", json::object());
+                        for (const auto& item : j.at("entries")) {
+                            const json flags = item.value("flags", defaults);
+                            MSetEntry entry;
+                            entry.persistent = flags.value("persistent", false);
+                            entry.ttl = flags.value("ttl", 0);
+                            entry.key = item.at("key").get<std::string>();
+                            entry.value = item.at("value").get<std::string>();
+                            entry.group = item.at("group").get<std::string>();
+                            msg.entries.push_back(std::move(entry));
+                        }
+
+                        auto result = eventBus_.send<MSetResponseMessage>(HandlerID::StorageHandler, msg).get();
+
+                        json respJson;
+                        respJson["id"] = result.id;
+                        respJson["response"] = result.response;
+                        std::string respStr = respJson.dump() + "\n";
+
+                        LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
+                        sendResponse(clientSocket, respStr);
+
+                    } else if (eventType == "MGET") {
+                        MGetEventMessage msg;
+                        msg.id = j.at("id").get<std::string>();
+                        msg.keys = j.at("keys").get<std::vector<std::string>>();
+
+                        auto result = eventBus_.send<MGetResponseMessage>(HandlerID::StorageHandler, msg).get();
+
+                        // Missing keys are reported as null.
+                        json respJson;
+                        respJson["id"] = result.id;
+                        json arr = json::array();
+                        for (const auto& value : result.response) {
+                            arr.push_back(value ? json(*value) : json(nullptr));
+                        }
+                        respJson["response"] = arr;
+                        std::string respStr = respJson.dump() + "\n";
+
+                        LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
+                        sendResponse(clientSocket, respStr);
+
+                    } else if (eventType == "MDELETE") {
+                        MDeleteEventMessage msg;
+                        msg.id = j.at("id").get<std::string>();
+                        msg.keys = j.at("keys").get<std::vector<std::string>>();
+
+                        auto result = eventBus_.send<MDeleteResponseMessage>(HandlerID::StorageHandler, msg).get();
+
+                        json respJson;
+                        respJson["id"] = result.id;
+                        respJson["response"] = result.response;
+                        std::string respStr = respJson.dump() + "\n";
+
+                        LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
+                        sendResponse(clientSocket, respStr);
 
                     } else if (eventType == "GET KEY") {
                         GetKeyEventMessage msg;
@@ -144,7 +364,7 @@ private:
                         std::string respStr = respJson.dump() + "\n";
 
                         LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
 
                     } else if (eventType == "GET GROUP") {
                         GetGroupEventMessage msg;
@@ -163,7 +383,7 @@ private:
                         std::string respStr = respJson.dump() + "\n";
 
                         LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
 
                     } else if (eventType == "DELETE KEY") {
                         DeleteKeyEventMessage msg;
@@ -178,7 +398,7 @@ private:
                         std::string respStr = respJson.dump() + "\n";
 
                         LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
 
                     } else if (eventType == "DELETE GROUP") {
                         DeleteGroupEventMessage msg;
@@ -193,33 +413,71 @@ private:
                         std::string respStr = respJson.dump() + "\n";
 
                         LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
 
                     } else if (eventType == "LIST") {
+                        // Streamed in chunks: the response is still one JSON line, but the
+                        // store is never materialized as a whole.
                         ListEventMessage msg;
                         msg.id = j.at("id").get<std::string>();
+                        msg.limit = readCount(j, "chunkSize", kListChunkSize);
+                        if (msg.limit == 0) {
+                            throw std::invalid_argument("Invalid chunk size");
+                        }
+                        streamList(clientSocket, msg);
+                    } else if (eventType == "SCAN") {
+                        ScanEventMessage msg;
+                        msg.id = j.at("id").get<std::string>();
+                        msg.cursor = j.value("cursor", "0");
+                        msg.count = readCount(j, "count", 100);
+                        msg.group = j.value("group", "");
+                        msg.prefix = j.value("prefix", "");
 
-                        auto result = eventBus_.send<ListEventReponseMessage>(HandlerID::StorageHandler, msg).get();
+                        auto result = eventBus_.send<ScanResponseMessage>(HandlerID::StorageHandler, msg).get();
 
                         json respJson;
                         respJson["id"] = result.id;
+                        respJson["cursor"] = result.cursor;
                         json arr = json::array();
                         for (const auto& kv : result.response) {
-                            arr.push_back({ {"key", kv.key}, {"value", kv.value}, {"group", kv.group}});
+                            arr.push_back({ {"key", kv.key}, {"value", kv.value}, {"group", kv.group} });
                         }
+                        respJson["response"] = arr;
+                        std::string respStr = respJson.dump() + "\n";
 
+                        LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
+                        sendResponse(clientSocket, respStr);
+
+                    } else if (eventType == "RANGE") {
+                        RangeEventMessage msg;
+                        msg.id = j.at("id").get<std::string>();
+                        msg.start = j.value("start", "");
+                        msg.end = j.value("end", "");
+                        msg.prefix = j.value("prefix", "");
+                        msg.limit = readCount(j, "limit", 100);
+
+                        auto result = eventBus_.send<RangeResponseMessage>(HandlerID::StorageHandler, msg).get();
+
+                        json respJson;
+                        respJson["id"] = result.id;
+                        respJson["next"] = result.next;
+                        json arr = json::array();
+                        for (const auto& kv : result.response) {
+                            arr.push_back({ {"key", kv.key}, {"value", kv.value}, {"group", kv.group} });
+                        }
                         respJson["response"] = arr;
                         std::string respStr = respJson.dump() + "\n";
 
                         LOG_INFO("SocketHandler", "Sending response: " << respStr.substr(0, 100) << "...");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
+
                     } else {
                         // Unknown event type
                         json errorJson;
                         errorJson["error"] = "Unknown event type";
                         std::string respStr = errorJson.dump() + "\n";
                         LOG_ERROR("SocketHandler", "Unknown event type received.");
-                        write(clientSocket, respStr.c_str(), respStr.size());
+                        sendResponse(clientSocket, respStr);
                     }
                 }
                 catch (const std::exception &e) {
@@ -227,21 +485,25 @@ private:
                     errorJson["error"] = e.what();
                     std::string respStr = errorJson.dump() + "\n";
                     LOG_ERROR("SocketHandler", "Exception caught while processing message: " << e.what());
-                    write(clientSocket, respStr.c_str(), respStr.size());
+                    sendResponse(clientSocket, respStr);
                 }
             }
         }
         catch (std::exception &e) {
             LOG_ERROR("SocketHandler", "Error in handleClient: " << e.what());
         }
-        // Close the client socket when done.
+        // End the connection; the descriptor itself is closed once this thread has been joined.
         LOG_INFO("SocketHandler", "Closing connection to client socket: " << clientSocket);
-        close(clientSocket);
+        shutdown(clientSocket, SHUT_RDWR);
     }
 
     std::string socketPath_;
     EventBus& eventBus_;
     int serverSocket_;
+    std::atomic<bool> stopping_{false};
+    std::mutex clientsMutex_;
+    // List nodes keep their address, so a client thread can refer to its own entry.
+    std::list<ClientConnection> clients_;
 };
 
 #endif // SOCKET_HANDLER_HPP
\ No newline at end of file
@@ -0,0 +1,787 @@
+#ifndef BITCASKENGINE_H
+#define BITCASKENGINE_H
+
+#include "storage/StorageEngine.h"
+#include "storage/Crc32.h"
+#include "storage/IoRing.h"
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <functional>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// Tuning knobs of the log-structured backend.
+struct BitcaskOptions {
+    // The active segment is sealed and a new one started once it grows beyond this size.
+    uint64_t maxSegmentBytes = 64 * 1024 * 1024;
+    // fsync after every write (matches the durability of a SQLite commit).
+    bool syncOnWrite = true;
+    // Sealed segments with at least this fraction of dead bytes are compacted.
+    double compactionDeadRatio = 0.5;
+    // Interval between two compaction checks.
+    int compactionIntervalMs = 1000;
+    // Reads, appends and fsyncs go through io_uring (blocking thread pool if false or unavailable).
+    bool useIoUring = true;
+    // Submission queue size; also the number of values a group scan reads concurrently.
+    unsigned ioQueueDepth = 256;
+};
+
+/*
+  BitcaskEngine stores entries in append-only segment files inside a directory.
+  An in-memory index maps every live key to the location of its latest record, so
+  a GET is one index lookup plus one read. Overwrites and deletes only append;
+  a background thread rewrites the live records of sealed segments that are mostly
+  dead and removes the old files. Every sealed segment gets a hint file (index
+  entries without values) so startup does not have to read the values again.
+
+  The index is ordered by key, so SCAN and RANGE walk only the keys they return.
+
+  Reads, appends and fsyncs go through an IoRing (io_uring, or a blocking thread
+  pool where io_uring is unavailable); group scans keep many value reads in
+  flight at once.
+
+  Record layout: crc32 | keyLen | valueLen | groupLen | flags | key | value | group
+  (all header fields uint32, native byte order; the crc covers everything after itself).
+*/
+class BitcaskEngine : public StorageEngine {
+public:
+    explicit BitcaskEngine(const std::string& directory, const BitcaskOptions& options = {})
+        : directory_(directory)
+        , options_(options)
+        , io_(options.ioQueueDepth, 4, options.useIoUring)
+        , activeId_(0)
+        , stopThread_(false)
+    {
+        std::filesystem::create_directories(directory_);
+        loadSegments();
+        openActiveSegment(activeId_ + 1);
+
+        compactionThread_ = std::thread(&BitcaskEngine::compactionLoop, this);
+        LOG_INFO("BitcaskEngine", "Opened '" << directory_ << "' with " << index_.size()
+                 << " live keys in " << segments_.size() << " segments.");
+    }
+
+    ~BitcaskEngine() override {
+        {
+            std::lock_guard<std::mutex> lock(compactionMutex_);
+            stopThread_ = true;
+        }
+        compactionCv_.notify_all();
+        if (compactionThread_.joinable()) {
+            compactionThread_.join();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        try {
+            sealActiveSegment();
+        } catch (const std::exception& e) {
+            LOG_ERROR("BitcaskEngine", "Writing hint file on shutdown failed: " << e.what());
+        }
+        for (auto& [id, segment] : segments_) {
+            ::close(segment.fd);
+        }
+        LOG_INFO("BitcaskEngine", "Segments closed.");
+    }
+
+    const char* name() const override { return "bitcask"; }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int /*ttlSeconds*/) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        appendRecord(key, value, group, false);
+        syncActive();
+    }
+
+    // Appends the whole batch under one lock and syncs once.
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& entry : entries) {
+            appendRecord(entry.key, entry.value, entry.group, false);
+        }
+        syncActive();
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        value = readValue(it->second);
+        return true;
+    }
+
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::optional<std::string>> result(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto it = index_.find(keys[i]);
+            if (it != index_.end()) {
+                result[i] = readValue(it->second);
+            }
+        }
+        return result;
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<KeyValue> result;
+        std::vector<const Location*> batch;
+        for (const auto& [key, location] : index_) {
+            if (location.group == group) {
+                result.push_back({ key, "" });
+                batch.push_back(&location);
+            }
+        }
+        // Values are read in batches of ioQueueDepth concurrent reads.
+        for (size_t start = 0; start < batch.size(); start += options_.ioQueueDepth) {
+            const size_t end = std::min<size_t>(batch.size(), start + options_.ioQueueDepth);
+            std::vector<const Location*> window(batch.begin() + start, batch.begin() + end);
+            std::vector<std::string> values = readValues(window);
+            for (size_t i = start; i < end; ++i) {
+                result[i].value = std::move(values[i - start]);
+            }
+        }
+        return result;
+    }
+
+    int erase(const std::string& key) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (index_.find(key) == index_.end()) {
+            return 0;
+        }
+        appendRecord(key, "", "", true);
+        syncActive();
+        return 1;
+    }
+
+    // Appends all tombstones under one lock and syncs once.
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        int count = 0;
+        for (const auto& key : keys) {
+            if (index_.find(key) != index_.end()) {
+                appendRecord(key, "", "", true);
+                ++count;
+            }
+        }
+        if (count > 0) {
+            syncActive();
+        }
+        return count;
+    }
+
+    int eraseGroup(const std::string& group) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::string> keys;
+        for (const auto& [key, location] : index_) {
+            if (location.group == group) {
+                keys.push_back(key);
+            }
+        }
+        for (const auto& key : keys) {
+            appendRecord(key, "", "", true);
+        }
+        if (!keys.empty()) {
+            syncActive();
+        }
+        return static_cast<int>(keys.size());
+    }
+
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        StorageEntry entry;
+        std::vector<const std::string*> keys;
+        std::vector<const Location*> window;
+        auto flush = [&] {
+            std::vector<std::string> values = readValues(window);
+            for (size_t i = 0; i < window.size(); ++i) {
+                entry.key = *keys[i];
+                entry.value = std::move(values[i]);
+                entry.group = window[i]->group;
+                fn(entry);
+            }
+            keys.clear();
+            window.clear();
+        };
+        for (const auto& [key, location] : index_) {
+            keys.push_back(&key);
+            window.push_back(&location);
+            if (window.size() >= options_.ioQueueDepth) {
+                flush();
+            }
+        }
+        flush();
+    }
+
+    // Walks the ordered index, so the lock is held for at most limit entries; their values
+    // are read with ioQueueDepth reads in flight, like a group scan.
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<StorageEntry> result;
+        std::vector<const Location*> batch;
+        const auto last = end.empty() ? index_.end() : index_.lower_bound(end);
+        for (auto it = index_.lower_bound(from); it != last && result.size() < limit; ++it) {
+            result.push_back({ it->first, "", it->second.group });
+            batch.push_back(&it->second);
+        }
+        for (size_t start = 0; start < batch.size(); start += options_.ioQueueDepth) {
+            const size_t stop = std::min<size_t>(batch.size(), start + options_.ioQueueDepth);
+            std::vector<const Location*> window(batch.begin() + start, batch.begin() + stop);
+            std::vector<std::string> values = readValues(window);
+            for (size_t i = start; i < stop; ++i) {
+                result[i].value = std::move(values[i - start]);
+            }
+        }
+        return result;
+    }
+
+    StorageStats stats() override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        StorageStats result;
+        result.entries = index_.size();
+        for (const auto& [id, segment] : segments_) {
+            result.bytes += segment.size;
+        }
+        return result;
+    }
+
+private:
+    static constexpr uint32_t kTombstone = 1;
+    static constexpr size_t kHeaderSize = 5 * sizeof(uint32_t);
+
+    struct Location {
+        uint32_t segment;
+        uint64_t offset;       // Start of the record.
+        uint32_t recordSize;
+        uint32_t keySize;
+        uint32_t valueSize;
+        std::string group;
+        // Older segments that still hold records of the key (see Deletion).
+        std::vector<uint32_t> shadowed;
+    };
+
+    // A key whose newest record is a tombstone. The tombstone is only needed while one of the
+    // shadowed segments exists: loading such a segment without it would bring an old value back.
+    struct Deletion {
+        uint32_t segment;
+        uint64_t offset;
+        std::vector<uint32_t> shadowed;
+    };
+
+    struct Segment {
+        int fd;
+        uint64_t size;
+        uint64_t deadBytes;
+    };
+
+    // Index entry as written to hint files (also kept for the active segment until it is sealed).
+    struct HintEntry {
+        uint64_t offset;
+        uint32_t recordSize;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint32_t flags;
+        std::string key;
+        std::string group;
+    };
+
+    struct RecordHeader {
+        uint32_t crc;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint32_t groupSize;
+        uint32_t flags;
+    };
+
+    std::string directory_;
+    BitcaskOptions options_;
+    IoRing io_;
+
+    // Protects index_, deleted_, segments_, activeId_ and activeHints_. GETs take it shared.
+    std::shared_mutex mutex_;
+    std::map<std::string, Location> index_;
+    // Deleted keys whose tombstone still shadows a record in an older segment.
+    std::unordered_map<std::string, Deletion> deleted_;
+    // Ordered by id, i.e. from the oldest to the newest segment.
+    std::map<uint32_t, Segment> segments_;
+    uint32_t activeId_;
+    std::vector<HintEntry> activeHints_;
+
+    std::thread compactionThread_;
+    std::mutex compactionMutex_;
+    std::condition_variable compactionCv_;
+    bool stopThread_;
+
+    // ------------------------------
+    // Helpers
+    // ------------------------------
+
+    std::string segmentPath(uint32_t id, const char* extension) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "segment-%06u.%s", id, extension);
+        return (std::filesystem::path(directory_) / name).string();
+    }
+
+    void writeAll(int fd, const char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = io_.write(fd, data, size, offset).get();
+            if (n < 0) {
+                if (n == -EINTR || n == -EAGAIN) continue;
+                throw std::runtime_error(std::string("Bitcask write error: ") + std::strerror(static_cast<int>(-n)));
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+    }
+
+    bool readAll(int fd, char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = io_.read(fd, data, size, offset).get();
+            if (n < 0) {
+                if (n == -EINTR || n == -EAGAIN) continue;
+                throw std::runtime_error(std::string("Bitcask read error: ") + std::strerror(static_cast<int>(-n)));
+            }
+            if (n == 0) {
+                return false;  // Unexpected end of file.
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    void syncFile(int fd) {
+        ssize_t rc = io_.fsync(fd).get();
+        if (rc < 0) {
+            throw std::runtime_error(std::string("Bitcask sync error: ") + std::strerror(static_cast<int>(-rc)));
+        }
+    }
+
+    static std::string encodeRecord(const std::string& key, const std::string& value,
+                                    const std::string& group, uint32_t flags) {
+        RecordHeader header{ 0, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size()),
+                             static_cast<uint32_t>(group.size()), flags };
+        std::string record(kHeaderSize + key.size() + value.size() + group.size(), '\0');
+        std::memcpy(record.data(), &header, kHeaderSize);
+        std::memcpy(record.data() + kHeaderSize, key.data(), key.size());
+        std::memcpy(record.data() + kHeaderSize + key.size(), value.data(), value.size());
+        std::memcpy(record.data() + kHeaderSize + key.size() + value.size(), group.data(), group.size());
+        header.crc = crc32(record.data() + sizeof(uint32_t), record.size() - sizeof(uint32_t));
+        std::memcpy(record.data(), &header.crc, sizeof(uint32_t));
+        return record;
+    }
+
+    std::string readValue(const Location& location) {
+        std::string value(location.valueSize, '\0');
+        const Segment& segment = segments_.at(location.segment);
+        if (!readAll(segment.fd, value.data(), value.size(), location.offset + kHeaderSize + location.keySize)) {
+            throw std::runtime_error("Bitcask record truncated.");
+        }
+        return value;
+    }
+
+    // Reads the values of several index entries with all reads in flight at once.
+    std::vector<std::string> readValues(const std::vector<const Location*>& locations) {
+        std::vector<std::string> values(locations.size());
+        std::vector<std::future<ssize_t>> pending;
+        pending.reserve(locations.size());
+        for (size_t i = 0; i < locations.size(); ++i) {
+            values[i].resize(locations[i]->valueSize);
+            pending.push_back(io_.read(segments_.at(locations[i]->segment).fd, values[i].data(), values[i].size(),
+                                       locations[i]->offset + kHeaderSize + locations[i]->keySize));
+        }
+        std::vector<ssize_t> results;
+        results.reserve(pending.size());
+        for (auto& future : pending) {
+            results.push_back(future.get());
+        }
+        for (size_t i = 0; i < locations.size(); ++i) {
+            if (results[i] != static_cast<ssize_t>(values[i].size())) {
+                // Short read or error: retry the value on its own.
+                values[i] = readValue(*locations[i]);
+            }
+        }
+        return values;
+    }
+
+    // Marks the record currently indexed for key (if any) as dead. Returns the segments that
+    // hold older records of the key, which the next record of the key shadows.
+    std::vector<uint32_t> retireLocked(const std::string& key) {
+        std::vector<uint32_t> shadowed;
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            auto segIt = segments_.find(it->second.segment);
+            if (segIt != segments_.end()) {
+                segIt->second.deadBytes += it->second.recordSize;
+            }
+            shadowed = std::move(it->second.shadowed);
+            shadowed.push_back(it->second.segment);
+            index_.erase(it);
+        } else if (auto del = deleted_.find(key); del != deleted_.end()) {
+            shadowed = std::move(del->second.shadowed);
+            deleted_.erase(del);
+        }
+        return shadowed;
+    }
+
+    // Drops compacted segments and the segment of the new record itself from shadowed.
+    void pruneShadowed(std::vector<uint32_t>& shadowed, uint32_t segment) const {
+        std::sort(shadowed.begin(), shadowed.end());
+        shadowed.erase(std::unique(shadowed.begin(), shadowed.end()), shadowed.end());
+        shadowed.erase(std::remove_if(shadowed.begin(), shadowed.end(), [this, segment](uint32_t id) {
+            return id == segment || segments_.find(id) == segments_.end();
+        }), shadowed.end());
+    }
+
+    // Points the index (or deleted_ for a tombstone) at a record. Caller holds mutex_ exclusively.
+    void indexRecordLocked(const std::string& key, const Location& location, bool tombstone,
+                           std::vector<uint32_t> shadowed) {
+        pruneShadowed(shadowed, location.segment);
+        if (tombstone) {
+            // A tombstone never holds live data, so it counts as dead even while it is needed.
+            segments_.at(location.segment).deadBytes += location.recordSize;
+            if (!shadowed.empty()) {
+                deleted_[key] = Deletion{ location.segment, location.offset, std::move(shadowed) };
+            }
+        } else {
+            Location& entry = index_[key];
+            entry = location;
+            entry.shadowed = std::move(shadowed);
+        }
+    }
+
+    // Appends a record to the active segment and updates the index. Caller holds mutex_ exclusively.
+    void appendRecord(const std::string& key, const std::string& value, const std::string& group, bool tombstone) {
+        appendRecord(key, value, group, tombstone, retireLocked(key));
+    }
+
+    // Same, for a record whose previous version is no longer indexed (moved by compaction).
+    void appendRecord(const std::string& key, const std::string& value, const std::string& group, bool tombstone,
+                      std::vector<uint32_t> shadowed) {
+        const std::string record = encodeRecord(key, value, group, tombstone ? kTombstone : 0);
+        Segment& active = segments_.at(activeId_);
+        const uint64_t offset = active.size;
+        writeAll(active.fd, record.data(), record.size(), offset);
+        active.size += record.size();
+
+        indexRecordLocked(key, Location{ activeId_, offset, static_cast<uint32_t>(record.size()),
+                                         static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size()), group, {} },
+                          tombstone, std::move(shadowed));
+        activeHints_.push_back(HintEntry{ offset, static_cast<uint32_t>(record.size()), static_cast<uint32_t>(key.size()),
+                                          static_cast<uint32_t>(value.size()), tombstone ? kTombstone : 0, key, group });
+
+        if (active.size >= options_.maxSegmentBytes) {
+            syncActive();
+            sealActiveSegment();
+            openActiveSegment(activeId_ + 1);
+        }
+    }
+
+    void syncActive() {
+        if (options_.syncOnWrite) {
+            syncFile(segments_.at(activeId_).fd);
+        }
+    }
+
+    void openActiveSegment(uint32_t id) {
+        const std::string path = segmentPath(id, "data");
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            LOG_ERROR("BitcaskEngine", "Unable to create segment '" << path << "': " << std::strerror(errno));
+            throw std::runtime_error("Error creating Bitcask segment.");
+        }
+        segments_[id] = Segment{ fd, 0, 0 };
+        activeId_ = id;
+        activeHints_.clear();
+    }
+
+    // Writes the hint file of the active segment. Caller holds mutex_ exclusively.
+    void sealActiveSegment() {
+        auto it = segments_.find(activeId_);
+        if (it == segments_.end()) {
+            return;
+        }
+        syncFile(it->second.fd);
+
+        std::string buffer;
+        const uint64_t dataSize = it->second.size;
+        buffer.append(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
+        for (const auto& hint : activeHints_) {
+            buffer.append(reinterpret_cast<const char*>(&hint.offset), sizeof(hint.offset));
+            buffer.append(reinterpret_cast<const char*>(&hint.recordSize), sizeof(hint.recordSize));
+            buffer.append(reinterpret_cast<const char*>(&hint.keySize), sizeof(hint.keySize));
+            buffer.append(reinterpret_cast<const char*>(&hint.valueSize), sizeof(hint.valueSize));
+            buffer.append(reinterpret_cast<const char*>(&hint.flags), sizeof(hint.flags));
+            const uint32_t groupSize = static_cast<uint32_t>(hint.group.size());
+            buffer.append(reinterpret_cast<const char*>(&groupSize), sizeof(groupSize));
+            buffer.append(hint.key);
+            buffer.append(hint.group);
+        }
+
+        // Write to a temporary file first so a crash never leaves a partial hint file behind.
+        const std::string tmpPath = segmentPath(activeId_, "hint.tmp");
+        int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Error creating Bitcask hint file.");
+        }
+        writeAll(fd, buffer.data(), buffer.size(), 0);
+        syncFile(fd);
+        ::close(fd);
+        std::filesystem::rename(tmpPath, segmentPath(activeId_, "hint"));
+        activeHints_.clear();
+    }
+
+    // Applies one record found while loading a segment to the index.
+    void applyLoadedRecord(uint32_t segmentId, const HintEntry& entry) {
+        indexRecordLocked(entry.key, Location{ segmentId, entry.offset, entry.recordSize, entry.keySize, entry.valueSize,
+                                               entry.group, {} },
+                          (entry.flags & kTombstone) != 0, retireLocked(entry.key));
+    }
+
+    bool loadHintFile(uint32_t id, std::vector<HintEntry>& entries) {
+        const std::string path = segmentPath(id, "hint");
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        const uint64_t fileSize = static_cast<uint64_t>(::lseek(fd, 0, SEEK_END));
+        std::string buffer(fileSize, '\0');
+        const bool complete = readAll(fd, buffer.data(), buffer.size(), 0);
+        ::close(fd);
+        if (!complete || fileSize < sizeof(uint64_t)) {
+            return false;
+        }
+
+        uint64_t dataSize;
+        std::memcpy(&dataSize, buffer.data(), sizeof(dataSize));
+        if (dataSize != segments_.at(id).size) {
+            LOG_ERROR("BitcaskEngine", "Hint file '" << path << "' does not match its segment; rescanning.");
+            return false;
+        }
+
+        size_t pos = sizeof(uint64_t);
+        constexpr size_t fixedSize = sizeof(uint64_t) + 5 * sizeof(uint32_t);
+        while (pos + fixedSize <= buffer.size()) {
+            HintEntry entry;
+            uint32_t groupSize;
+            std::memcpy(&entry.offset, buffer.data() + pos, sizeof(entry.offset));
+            std::memcpy(&entry.recordSize, buffer.data() + pos + 8, sizeof(uint32_t));
+            std::memcpy(&entry.keySize, buffer.data() + pos + 12, sizeof(uint32_t));
+            std::memcpy(&entry.valueSize, buffer.data() + pos + 16, sizeof(uint32_t));
+            std::memcpy(&entry.flags, buffer.data() + pos + 20, sizeof(uint32_t));
+            std::memcpy(&groupSize, buffer.data() + pos + 24, sizeof(uint32_t));
+            pos += fixedSize;
+            if (pos + entry.keySize + groupSize > buffer.size()) {
+                return false;
+            }
+            entry.key.assign(buffer.data() + pos, entry.keySize);
+            entry.group.assign(buffer.data() + pos + entry.keySize, groupSize);
+            pos += entry.keySize + groupSize;
+            entries.push_back(std::move(entry));
+        }
+        return pos == buffer.size();
+    }
+
+    // Reads all records of a data file; a torn or corrupt tail is cut off.
+    void scanDataFile(uint32_t id, std::vector<HintEntry>& entries) {
+        Segment& segment = segments_.at(id);
+        uint64_t offset = 0;
+        while (offset + kHeaderSize <= segment.size) {
+            RecordHeader header;
+            if (!readAll(segment.fd, reinterpret_cast<char*>(&header), kHeaderSize, offset)) {
+                break;
+            }
+            const uint64_t recordSize = kHeaderSize + uint64_t(header.keySize) + header.valueSize + header.groupSize;
+            if (offset + recordSize > segment.size) {
+                break;
+            }
+            std::string record(recordSize, '\0');
+            readAll(segment.fd, record.data(), record.size(), offset);
+            if (crc32(record.data() + sizeof(uint32_t), record.size() - sizeof(uint32_t)) != header.crc) {
+                break;
+            }
+            HintEntry entry;
+            entry.offset = offset;
+            entry.recordSize = static_cast<uint32_t>(recordSize);
+            entry.keySize = header.keySize;
+            entry.valueSize = header.valueSize;
+            entry.flags = header.flags;
+            entry.key.assign(record.data() + kHeaderSize, header.keySize);
+            entry.group.assign(record.data() + kHeaderSize + header.keySize + header.valueSize, header.groupSize);
+            entries.push_back(std::move(entry));
+            offset += recordSize;
+        }
+
+        if (offset != segment.size) {
+            LOG_ERROR("BitcaskEngine", "Segment " << id << " has a corrupt tail at offset " << offset
+                      << "; truncating " << (segment.size - offset) << " bytes.");
+            if (::ftruncate(segment.fd, static_cast<off_t>(offset)) != 0) {
+                throw std::runtime_error("Error truncating Bitcask segment.");
+            }
+            segment.size = offset;
+        }
+    }
+
+    void loadSegments() {
+        std::vector<uint32_t> ids;
+        for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+            const std::string name = file.path().filename().string();
+            unsigned int id;
+            char extension[8] = {};
+            if (std::sscanf(name.c_str(), "segment-%06u.%7s", &id, extension) == 2 && std::strcmp(extension, "data") == 0) {
+                ids.push_back(id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+
+        for (uint32_t id : ids) {
+            const std::string path = segmentPath(id, "data");
+            int fd = ::open(path.c_str(), O_RDWR);
+            if (fd < 0) {
+                LOG_ERROR("BitcaskEngine", "Unable to open segment '" << path << "': " << std::strerror(errno));
+                throw std::runtime_error("Error opening Bitcask segment.");
+            }
+            const uint64_t size = static_cast<uint64_t>(::lseek(fd, 0, SEEK_END));
+            segments_[id] = Segment{ fd, size, 0 };
+
+            std::vector<HintEntry> entries;
+            if (!loadHintFile(id, entries)) {
+                entries.clear();
+                scanDataFile(id, entries);
+            }
+            for (const auto& entry : entries) {
+                applyLoadedRecord(id, entry);
+            }
+            activeId_ = id;
+        }
+    }
+
+    // ------------------------------
+    // Background Compaction
+    // ------------------------------
+
+    void compactionLoop() {
+        const std::chrono::milliseconds interval(options_.compactionIntervalMs);
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(compactionMutex_);
+                if (compactionCv_.wait_for(lock, interval, [this] { return stopThread_; })) {
+                    break;
+                }
+            }
+            try {
+                uint32_t candidate;
+                while (!stopRequested() && findCompactionCandidate(candidate)) {
+                    compactSegment(candidate);
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("BitcaskEngine", "Compaction failed: " << e.what());
+            }
+        }
+    }
+
+    bool stopRequested() {
+        std::lock_guard<std::mutex> lock(compactionMutex_);
+        return stopThread_;
+    }
+
+    // Picks the oldest sealed segment whose dead fraction exceeds the configured ratio.
+    bool findCompactionCandidate(uint32_t& candidate) {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& [id, segment] : segments_) {
+            if (id == activeId_) {
+                continue;
+            }
+            if (segment.size == 0 ||
+                static_cast<double>(segment.deadBytes) / static_cast<double>(segment.size) >= options_.compactionDeadRatio) {
+                candidate = id;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the live records of a sealed segment to the active segment and deletes it.
+    // Foreground requests are only blocked for the duration of a single record move.
+    void compactSegment(uint32_t id) {
+        int fd;
+        uint64_t size;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            const Segment& segment = segments_.at(id);
+            fd = segment.fd;
+            size = segment.size;
+        }
+
+        uint64_t offset = 0;
+        uint64_t moved = 0;
+        uint64_t movedBytes = 0;
+        while (offset + kHeaderSize <= size) {
+            RecordHeader header;
+            readAll(fd, reinterpret_cast<char*>(&header), kHeaderSize, offset);
+            const uint64_t recordSize = kHeaderSize + uint64_t(header.keySize) + header.valueSize + header.groupSize;
+            std::string record(recordSize, '\0');
+            readAll(fd, record.data(), record.size(), offset);
+            const std::string key(record.data() + kHeaderSize, header.keySize);
+
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (header.flags & kTombstone) {
+                // Only the key's newest tombstone is kept, and only while a segment it shadows exists.
+                auto del = deleted_.find(key);
+                if (del != deleted_.end() && del->second.segment == id && del->second.offset == offset) {
+                    std::vector<uint32_t> shadowed = std::move(del->second.shadowed);
+                    deleted_.erase(del);
+                    pruneShadowed(shadowed, id);
+                    if (!shadowed.empty()) {
+                        appendRecord(key, "", "", true, std::move(shadowed));
+                    }
+                }
+            } else if (it != index_.end() && it->second.segment == id && it->second.offset == offset) {
+                const std::string value(record.data() + kHeaderSize + header.keySize, header.valueSize);
+                const std::string group(record.data() + kHeaderSize + header.keySize + header.valueSize, header.groupSize);
+                // Detach the index entry first so the old segment's dead bytes are not touched.
+                std::vector<uint32_t> shadowed = std::move(it->second.shadowed);
+                index_.erase(it);
+                appendRecord(key, value, group, false, std::move(shadowed));
+                ++moved;
+                movedBytes += recordSize;
+            }
+            offset += recordSize;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        syncFile(segments_.at(activeId_).fd);
+        ::close(fd);
+        segments_.erase(id);
+        std::filesystem::remove(segmentPath(id, "data"));
+        std::filesystem::remove(segmentPath(id, "hint"));
+        LOG_INFO("BitcaskEngine", "Compacted segment " << id << ": moved " << moved << " live records, reclaimed "
+                 << (size - movedBytes) << " bytes.");
+    }
+};
+
+#endif // BITCASKENGINE_H
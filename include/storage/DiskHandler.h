@@ -3,11 +3,23 @@
 
 #include "eventbus/EventBus.h"
 #include "storage/Message.h"  // The specific Message classes (SetEventMessage, etc.) should be defined here.
+#include "storage/StorageEngine.h"
+#include "storage/StorageEngineBinding.h"
+#include "storage/SqliteEngine.h"
+#include "storage/BitcaskEngine.h"
+#include "storage/LsmEngine.h"
+#include "storage/MmapHashEngine.h"
+#include "storage/ShardedEngine.h"
+#include <filesystem>
 #include <iostream>
-#include <mutex>
+#include <memory>
 #include <stdexcept>
 #include <string>
-#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // ------------------------------
 // Logging Helpers and Macros
@@ -20,246 +32,158 @@ std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
 #define LOG_ERROR(component, message) \
 std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
 
-// ------------------------------
-// RAII Helper Class for SQLite Statements
-// ------------------------------
-class SQLiteStmt {
-public:
-    SQLiteStmt(sqlite3* db, const char* sql)
-        : db_(db), stmt_(nullptr)
-    {
-        int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt_, nullptr);
-        if (rc != SQLITE_OK) {
-            throw std::runtime_error(std::string("SQLite prepare error: ") + sqlite3_errmsg(db_));
-        }
-    }
-
-    ~SQLiteStmt() {
-        if (stmt_) {
-            sqlite3_finalize(stmt_);
-        }
-    }
-
-    sqlite3_stmt* get() const { return stmt_; }
-
-    // Optional method to reset the statement.
-    void reset() {
-        if (stmt_) {
-            sqlite3_reset(stmt_);
-        }
-    }
+// Settings of the background space reclamation (optional "disk.compaction" section).
+struct DiskCompactionOptions {
+    bool enabled = true;
+    // Pause between two steps while there is nothing to reclaim.
+    int intervalMs = 1000;
+    // Pause between two steps while free space is being reclaimed (throttling).
+    int stepPauseMs = 10;
+    // Upper bound of the space returned per step; bounds how long a step holds the engine lock.
+    uint64_t maxBytesPerStep = 256 * 1024;
+    // Converts an existing SQLite database created without incremental auto_vacuum when it is
+    // opened. This is a full VACUUM that blocks startup for the size of the file.
+    bool convertExisting = false;
+};
 
-private:
-    sqlite3* db_;
-    sqlite3_stmt* stmt_;
+// Counters of the background space reclamation.
+struct DiskCompactionMetrics {
+    uint64_t steps = 0;
+    uint64_t reclaimedBytes = 0;
+    uint64_t timeSpentUs = 0;
 };
 
 // ------------------------------
 // DiskHandler Class
 // ------------------------------
+// Binds a persistent StorageEngine to the EventBus. The backend is selected by
+// name ("sqlite", "bitcask", "lsm" or "mmap"); engines do their own locking.
 class DiskHandler {
 public:
-    // Constructor: Opens (or creates, if it does not exist) the SQLite database.
-    explicit DiskHandler(EventBus& eventBus, const std::string& dbFile = "disk_store.db")
+    // Constructor: Opens (or creates, if it does not exist) the store of the selected backend.
+    // With shards > 1 the keyspace is split by key hash across that many stores of the backend.
+    explicit DiskHandler(EventBus& eventBus, const std::string& dbFile = "disk_store.db",
+                         const std::string& backend = "sqlite", size_t shards = 1,
+                         const DiskCompactionOptions& compaction = {})
         : eventBus_(eventBus)
+        , engine_(openEngine(backend, dbFile, shards, compaction.enabled && compaction.convertExisting))
+        , binding_(eventBus, HandlerID::DiskHandler, *engine_, "DiskHandler")
+        , compaction_(compaction)
+        , stopThread_(false)
     {
-        int rc = sqlite3_open(dbFile.c_str(), &db_);
-        if (rc != SQLITE_OK) {
-            LOG_ERROR("DiskHandler", "Unable to open database: " << sqlite3_errmsg(db_));
-            db_ = nullptr;
-            throw std::runtime_error("Error opening SQLite database.");
+        if (compaction_.enabled) {
+            compactionThread_ = std::thread(&DiskHandler::compactionLoop, this);
         }
-
-        // Create the table if it does not exist.
-        const char* createTableSQL = "CREATE TABLE IF NOT EXISTS store ("
-                                     "key TEXT PRIMARY KEY, "
-                                     "value TEXT, "
-                                     "group_name TEXT"
-                                     ");";
-        char* errMsg = nullptr;
-        rc = sqlite3_exec(db_, createTableSQL, nullptr, nullptr, &errMsg);
-        if (rc != SQLITE_OK) {
-            LOG_ERROR("DiskHandler", "SQL error while creating table: " << errMsg);
-            sqlite3_free(errMsg);
-            sqlite3_close(db_);
-            db_ = nullptr;
-            throw std::runtime_error("Error creating table in SQLite database.");
-        }
-
-        // Register EventBus handlers.
-        eventBus_.subscribe<SetEventMessage, SetResponseMessage>(HandlerID::DiskHandler,
-            [this](const SetEventMessage& msg) -> SetResponseMessage {
-                return handleSetEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<GetKeyEventMessage, GetKeyResponseMessage>(HandlerID::DiskHandler,
-            [this](const GetKeyEventMessage& msg) -> GetKeyResponseMessage {
-                return handleGetKeyEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<GetGroupEventMessage, GetGroupResponseMessage>(HandlerID::DiskHandler,
-            [this](const GetGroupEventMessage& msg) -> GetGroupResponseMessage {
-                return handleGetGroupEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<DeleteKeyEventMessage, DeleteKeyResponseMessage>(HandlerID::DiskHandler,
-            [this](const DeleteKeyEventMessage& msg) -> DeleteKeyResponseMessage {
-                return handleDeleteKeyEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<DeleteGroupEventMessage, DeleteGroupResponseMessage>(HandlerID::DiskHandler,
-            [this](const DeleteGroupEventMessage& msg) -> DeleteGroupResponseMessage {
-                return handleDeleteGroupEvent(msg);
-            }
-        );
-
-        LOG_INFO("DiskHandler", "Initialized and database '" << dbFile << "' opened successfully.");
+        LOG_INFO("DiskHandler", "Initialized with backend '" << backend << "' for '" << dbFile << "' ("
+                 << shards << (shards == 1 ? " shard)." : " shards)."));
     }
 
     ~DiskHandler() {
-        if (db_) {
-            sqlite3_close(db_);
-            LOG_INFO("DiskHandler", "Database connection closed.");
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopThread_ = true;
         }
-    }
-
-private:
-    sqlite3* db_ = nullptr;
-    std::mutex mutex_;
-    EventBus& eventBus_;
-
-    // Handler implementation for SET events.
-    SetResponseMessage handleSetEvent(const SetEventMessage& msg) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        char* errMsg = nullptr;
-        int rc = sqlite3_exec(db_, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg);
-        if (rc != SQLITE_OK) {
-            LOG_ERROR("DiskHandler", "Error starting transaction: " << errMsg);
-            sqlite3_free(errMsg);
-            throw std::runtime_error("SQLite transaction BEGIN error in SET.");
+        cv_.notify_all();
+        if (compactionThread_.joinable()) {
+            compactionThread_.join();
         }
+    }
 
-        try {
-            SQLiteStmt stmt(db_, "INSERT OR REPLACE INTO store (key, value, group_name) VALUES (?, ?, ?);");
-            sqlite3_bind_text(stmt.get(), 1, msg.key.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt.get(), 2, msg.value.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt.get(), 3, msg.group.c_str(), -1, SQLITE_TRANSIENT);
+    DiskCompactionMetrics compactionMetrics() const {
+        DiskCompactionMetrics metrics;
+        metrics.steps = compactionSteps_.load();
+        metrics.reclaimedBytes = reclaimedBytes_.load();
+        metrics.timeSpentUs = compactionTimeUs_.load();
+        return metrics;
+    }
 
-            rc = sqlite3_step(stmt.get());
-            if (rc != SQLITE_DONE) {
-                LOG_ERROR("DiskHandler", "Error executing statement: " << sqlite3_errmsg(db_));
-                throw std::runtime_error("SQLite step error in SET.");
-            }
-            // Commit the transaction.
-            rc = sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, &errMsg);
-            if (rc != SQLITE_OK) {
-                LOG_ERROR("DiskHandler", "Error committing transaction: " << errMsg);
-                sqlite3_free(errMsg);
-                throw std::runtime_error("SQLite transaction COMMIT error in SET.");
-            }
+    // Opens the store the way the constructor does, without binding it to an EventBus (used by the
+    // bulk tool). Shard i of "db/disk_store.db" lives in "db/disk_store-shard<i>.db".
+    // convertExisting: see DiskCompactionOptions (SQLite only).
+    static std::unique_ptr<StorageEngine> openEngine(const std::string& backend, const std::string& dbFile, size_t shards,
+                                                     bool convertExisting = false) {
+        if (shards <= 1) {
+            return createEngine(backend, dbFile, convertExisting);
         }
-        catch (const std::exception& e) {
-            // Roll back the transaction upon error.
-            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
-            LOG_ERROR("DiskHandler", "Transaction rolled back due to error: " << e.what());
-            throw; // Rethrow the exception.
+        const std::filesystem::path path(dbFile);
+        std::vector<std::unique_ptr<StorageEngine>> engines;
+        for (size_t i = 0; i < shards; ++i) {
+            const std::string shardFile = (path.parent_path() /
+                (path.stem().string() + "-shard" + std::to_string(i) + path.extension().string())).string();
+            engines.push_back(createEngine(backend, shardFile, convertExisting));
         }
-
-        SetResponseMessage resp;
-        resp.id = msg.id;
-        resp.response = true;
-        LOG_INFO("DiskHandler", "SET event successful for key: " << msg.key);
-        return resp;
+        return std::make_unique<ShardedEngine>(std::move(engines));
     }
 
-    // Handler implementation for GET KEY events.
-    GetKeyResponseMessage handleGetKeyEvent(const GetKeyEventMessage& msg) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        SQLiteStmt stmt(db_, "SELECT value FROM store WHERE key = ?;");
-        sqlite3_bind_text(stmt.get(), 1, msg.key.c_str(), -1, SQLITE_TRANSIENT);
-        std::string value;
-        int rc = sqlite3_step(stmt.get());
-        if (rc == SQLITE_ROW) {
-            const unsigned char* text = sqlite3_column_text(stmt.get(), 0);
-            value = text ? reinterpret_cast<const char*>(text) : "";
-            LOG_INFO("DiskHandler", "GET KEY event: Key '" << msg.key << "' found.");
-        } else if (rc == SQLITE_DONE) {
-            LOG_INFO("DiskHandler", "GET KEY event: Key '" << msg.key << "' not found.");
-        } else {
-            LOG_ERROR("DiskHandler", "Error retrieving value: " << sqlite3_errmsg(db_));
-            throw std::runtime_error("SQLite step error in GET KEY.");
+private:
+    EventBus& eventBus_;
+    std::unique_ptr<StorageEngine> engine_;
+    // Subscribes the storage events and forwards them to engine_.
+    StorageEngineBinding binding_;
+
+    // Background space reclamation.
+    DiskCompactionOptions compaction_;
+    std::thread compactionThread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopThread_;
+    std::atomic<uint64_t> compactionSteps_{0};
+    std::atomic<uint64_t> reclaimedBytes_{0};
+    std::atomic<uint64_t> compactionTimeUs_{0};
+
+    // Creates the backend; Bitcask, LSM and mmap files live in a directory next to the configured file.
+    static std::unique_ptr<StorageEngine> createEngine(const std::string& backend, const std::string& dbFile,
+                                                       bool convertExisting) {
+        if (backend == "sqlite") {
+            return std::make_unique<SqliteEngine>(dbFile, convertExisting);
+        } else if (backend == "bitcask") {
+            return std::make_unique<BitcaskEngine>(dbFile + ".bitcask");
+        } else if (backend == "lsm") {
+            return std::make_unique<LsmEngine>(dbFile + ".lsm");
+        } else if (backend == "mmap") {
+            return std::make_unique<MmapHashEngine>(dbFile + ".mmap");
         }
-        GetKeyResponseMessage resp;
-        resp.id = msg.id;
-        resp.response = value;
-        return resp;
+        LOG_ERROR("DiskHandler", "Unknown disk backend: " << backend);
+        throw std::invalid_argument("Unknown disk backend: " + backend);
     }
 
-    // Handler implementation for GET GROUP events.
-    GetGroupResponseMessage handleGetGroupEvent(const GetGroupEventMessage& msg) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        SQLiteStmt stmt(db_, "SELECT key, value FROM store WHERE group_name = ?;");
-        sqlite3_bind_text(stmt.get(), 1, msg.group.c_str(), -1, SQLITE_TRANSIENT);
-
-        GetGroupResponseMessage resp;
-        resp.id = msg.id;
+    // ------------------------------
+    // Background Thread: Space Reclamation
+    // ------------------------------
+    // Reclaims free space in small steps. Each step only holds the engine lock briefly,
+    // and the pause between steps leaves room for foreground requests.
+    void compactionLoop() {
+        uint64_t runBytes = 0;
         while (true) {
-            int rc = sqlite3_step(stmt.get());
-            if (rc == SQLITE_ROW) {
-                const unsigned char* keyText = sqlite3_column_text(stmt.get(), 0);
-                const unsigned char* valueText = sqlite3_column_text(stmt.get(), 1);
-                std::string key = keyText ? reinterpret_cast<const char*>(keyText) : "";
-                std::string value = valueText ? reinterpret_cast<const char*>(valueText) : "";
-                resp.response.push_back({ key, value });
-            } else if (rc == SQLITE_DONE) {
-                break;
-            } else {
-                LOG_ERROR("DiskHandler", "Error retrieving group: " << sqlite3_errmsg(db_));
-                throw std::runtime_error("SQLite step error in GET GROUP.");
+            const int pauseMs = runBytes > 0 ? compaction_.stepPauseMs : compaction_.intervalMs;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (cv_.wait_for(lock, std::chrono::milliseconds(pauseMs), [this] { return stopThread_; })) {
+                    break;
+                }
             }
-        }
-        LOG_INFO("DiskHandler", "GET GROUP event: Returned " << resp.response.size() << " entries for group '" << msg.group << "'.");
-        return resp;
-    }
-
-    // Handler implementation for DELETE KEY events.
-    DeleteKeyResponseMessage handleDeleteKeyEvent(const DeleteKeyEventMessage& msg) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        SQLiteStmt stmt(db_, "DELETE FROM store WHERE key = ?;");
-        sqlite3_bind_text(stmt.get(), 1, msg.key.c_str(), -1, SQLITE_TRANSIENT);
-        int rc = sqlite3_step(stmt.get());
-        if (rc != SQLITE_DONE) {
-            LOG_ERROR("DiskHandler", "Error executing DELETE: " << sqlite3_errmsg(db_));
-            throw std::runtime_error("SQLite step error in DELETE KEY.");
-        }
-        int changes = sqlite3_changes(db_);
-        DeleteKeyResponseMessage resp;
-        resp.id = msg.id;
-        resp.response = (changes > 0) ? 1 : 0;
-        LOG_INFO("DiskHandler", "DELETE KEY event: Key '" << msg.key << "' deletion " << ((changes > 0) ? "succeeded." : "failed."));
-        return resp;
-    }
 
-    // Handler implementation for DELETE GROUP events.
-    DeleteGroupResponseMessage handleDeleteGroupEvent(const DeleteGroupEventMessage& msg) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        SQLiteStmt stmt(db_, "DELETE FROM store WHERE group_name = ?;");
-        sqlite3_bind_text(stmt.get(), 1, msg.group.c_str(), -1, SQLITE_TRANSIENT);
-        int rc = sqlite3_step(stmt.get());
-        if (rc != SQLITE_DONE) {
-            LOG_ERROR("DiskHandler", "Error executing DELETE GROUP: " << sqlite3_errmsg(db_));
-            throw std::runtime_error("SQLite step error in DELETE GROUP.");
+            uint64_t reclaimed = 0;
+            auto start = std::chrono::steady_clock::now();
+            try {
+                reclaimed = engine_->compactStep(compaction_.maxBytesPerStep);
+            } catch (const std::exception& e) {
+                LOG_ERROR("DiskHandler", "Compaction step failed: " << e.what());
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            compactionTimeUs_ += static_cast<uint64_t>(elapsed.count());
+
+            if (reclaimed > 0) {
+                compactionSteps_++;
+                reclaimedBytes_ += reclaimed;
+                runBytes += reclaimed;
+            } else if (runBytes > 0) {
+                const DiskCompactionMetrics metrics = compactionMetrics();
+                LOG_INFO("DiskHandler", "Compaction reclaimed " << runBytes << " bytes (total " << metrics.reclaimedBytes
+                         << " bytes in " << metrics.steps << " steps, " << metrics.timeSpentUs << " us).");
+                runBytes = 0;
+            }
         }
-        int changes = sqlite3_changes(db_);
-        DeleteGroupResponseMessage resp;
-        resp.id = msg.id;
-        resp.response = changes;
-        LOG_INFO("DiskHandler", "DELETE GROUP event: Removed " << changes << " entries for group '" << msg.group << "'.");
-        return resp;
     }
 };
 
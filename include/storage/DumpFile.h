@@ -0,0 +1,450 @@
+#ifndef DUMPFILE_H
+#define DUMPFILE_H
+
+#include "storage/StorageEngine.h"
+#include "storage/Crc32.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+/*
+  Compact binary dump of cache entries, written and read as a stream.
+
+  File:    "ACMDUMP1" | record* | "ACMDEND1" | uint64 recordCount
+  Record:  crc32 | flags | ttlSeconds | keyLen | valueLen | groupLen | key | value | group
+           (all header fields 32 bit, native byte order; the crc covers everything after
+           itself; flags bit 0 marks a persistent entry)
+
+  A file without the trailer was cut off while being written and is rejected.
+*/
+namespace dump {
+
+inline constexpr char kMagic[8] = { 'A', 'C', 'M', 'D', 'U', 'M', 'P', '1' };
+inline constexpr char kTrailer[8] = { 'A', 'C', 'M', 'D', 'E', 'N', 'D', '1' };
+inline constexpr uint32_t kFlagPersistent = 1;
+inline constexpr size_t kRecordHeaderSize = 6 * sizeof(uint32_t);
+inline constexpr size_t kBufferSize = 1024 * 1024;
+
+} // namespace dump
+
+// ------------------------------
+// DumpWriter Class
+// ------------------------------
+// Appends records through a 1 MB buffer; finish() writes the trailer and syncs the file.
+class DumpWriter {
+public:
+    explicit DumpWriter(const std::string& path)
+        : path_(path)
+    {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Cannot create dump file '" + path + "': " + std::strerror(errno));
+        }
+        buffer_.reserve(dump::kBufferSize);
+        buffer_.append(dump::kMagic, sizeof(dump::kMagic));
+    }
+
+    ~DumpWriter() {
+        if (fd_ >= 0) {
+            // Not finished: the file stays without trailer and will be rejected.
+            ::close(fd_);
+        }
+    }
+
+    DumpWriter(const DumpWriter&) = delete;
+    DumpWriter& operator=(const DumpWriter&) = delete;
+
+    void write(const BatchEntry& entry, bool persistent) {
+        const size_t start = buffer_.size();
+        const uint32_t header[6] = {
+            0, persistent ? dump::kFlagPersistent : 0u, static_cast<uint32_t>(entry.ttlSeconds),
+            static_cast<uint32_t>(entry.key.size()), static_cast<uint32_t>(entry.value.size()),
+            static_cast<uint32_t>(entry.group.size())
+        };
+        buffer_.append(reinterpret_cast<const char*>(header), sizeof(header));
+        buffer_.append(entry.key);
+        buffer_.append(entry.value);
+        buffer_.append(entry.group);
+        const uint32_t crc = crc32(buffer_.data() + start + sizeof(uint32_t), buffer_.size() - start - sizeof(uint32_t));
+        std::memcpy(buffer_.data() + start, &crc, sizeof(crc));
+        ++count_;
+        if (buffer_.size() >= dump::kBufferSize) {
+            flush();
+        }
+    }
+
+    // Writes the trailer, flushes and fsyncs the file.
+    void finish() {
+        buffer_.append(dump::kTrailer, sizeof(dump::kTrailer));
+        buffer_.append(reinterpret_cast<const char*>(&count_), sizeof(count_));
+        flush();
+        if (::fsync(fd_) != 0) {
+            throw std::runtime_error("Cannot sync dump file '" + path_ + "': " + std::strerror(errno));
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t bytes() const { return written_ + buffer_.size(); }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    std::string buffer_;
+    uint64_t count_ = 0;
+    uint64_t written_ = 0;
+
+    void flush() {
+        const char* data = buffer_.data();
+        size_t remaining = buffer_.size();
+        while (remaining > 0) {
+            ssize_t n = ::write(fd_, data, remaining);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Cannot write dump file '" + path_ + "': " + std::strerror(errno));
+            }
+            data += n;
+            remaining -= static_cast<size_t>(n);
+        }
+        written_ += buffer_.size();
+        buffer_.clear();
+    }
+};
+
+// ------------------------------
+// DumpReader Class
+// ------------------------------
+// Reads records through a 1 MB buffer; throws on corrupt or truncated files.
+class DumpReader {
+public:
+    explicit DumpReader(const std::string& path)
+        : path_(path)
+    {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("Cannot open dump file '" + path + "': " + std::strerror(errno));
+        }
+        char magic[sizeof(dump::kMagic)];
+        if (!read(magic, sizeof(magic)) || std::memcmp(magic, dump::kMagic, sizeof(magic)) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("'" + path + "' is not a dump file.");
+        }
+    }
+
+    ~DumpReader() {
+        ::close(fd_);
+    }
+
+    DumpReader(const DumpReader&) = delete;
+    DumpReader& operator=(const DumpReader&) = delete;
+
+    // Reads the next record; returns false once the trailer has been reached.
+    bool next(BatchEntry& entry, bool& persistent) {
+        uint32_t header[6];
+        if (!read(reinterpret_cast<char*>(header), 2 * sizeof(uint32_t))) {
+            throw std::runtime_error("Dump file '" + path_ + "' is truncated.");
+        }
+        if (std::memcmp(header, dump::kTrailer, sizeof(dump::kTrailer)) == 0) {
+            uint64_t expected;
+            if (!read(reinterpret_cast<char*>(&expected), sizeof(expected)) || expected != count_) {
+                throw std::runtime_error("Dump file '" + path_ + "' has an invalid trailer.");
+            }
+            return false;
+        }
+        if (!read(reinterpret_cast<char*>(header) + 2 * sizeof(uint32_t), 4 * sizeof(uint32_t))) {
+            throw std::runtime_error("Dump file '" + path_ + "' is truncated.");
+        }
+
+        const size_t payload = size_t(header[3]) + header[4] + header[5];
+        record_.resize(dump::kRecordHeaderSize + payload);
+        std::memcpy(record_.data(), header, dump::kRecordHeaderSize);
+        if (!read(record_.data() + dump::kRecordHeaderSize, payload)) {
+            throw std::runtime_error("Dump file '" + path_ + "' is truncated.");
+        }
+        if (crc32(record_.data() + sizeof(uint32_t), record_.size() - sizeof(uint32_t)) != header[0]) {
+            throw std::runtime_error("Dump file '" + path_ + "' has a corrupt record at entry " + std::to_string(count_) + ".");
+        }
+
+        const char* data = record_.data() + dump::kRecordHeaderSize;
+        persistent = header[1] & dump::kFlagPersistent;
+        entry.ttlSeconds = static_cast<int>(header[2]);
+        entry.key.assign(data, header[3]);
+        entry.value.assign(data + header[3], header[4]);
+        entry.group.assign(data + header[3] + header[4], header[5]);
+        ++count_;
+        return true;
+    }
+
+    uint64_t count() const { return count_; }
+    // Bytes consumed so far.
+    uint64_t bytes() const { return consumed_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    std::vector<char> buffer_ = std::vector<char>(dump::kBufferSize);
+    size_t pos_ = 0;
+    size_t end_ = 0;
+    uint64_t consumed_ = 0;
+    uint64_t count_ = 0;
+    std::string record_;
+
+    bool read(char* out, size_t size) {
+        while (size > 0) {
+            if (pos_ == end_) {
+                ssize_t n = ::read(fd_, buffer_.data(), buffer_.size());
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::runtime_error("Cannot read dump file '" + path_ + "': " + std::strerror(errno));
+                }
+                if (n == 0) {
+                    return false;
+                }
+                pos_ = 0;
+                end_ = static_cast<size_t>(n);
+            }
+            const size_t chunk = std::min(size, end_ - pos_);
+            std::memcpy(out, buffer_.data() + pos_, chunk);
+            pos_ += chunk;
+            consumed_ += chunk;
+            out += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+};
+
+// ------------------------------
+// DumpView Class
+// ------------------------------
+// Read-only memory map of a complete dump. split() finds record boundaries so that
+// independent ranges can be decoded (and CRC-checked) on several threads at once.
+class DumpView {
+public:
+    explicit DumpView(const std::string& path)
+        : path_(path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open dump file '" + path + "': " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat dump file '" + path + "': " + std::strerror(errno));
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ < sizeof(dump::kMagic) + kTrailerSize) {
+            ::close(fd);
+            throw std::runtime_error("Dump file '" + path + "' is truncated.");
+        }
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Cannot map dump file '" + path + "': " + std::strerror(errno));
+        }
+        data_ = static_cast<const char*>(data);
+        ::madvise(data, size_, MADV_WILLNEED);
+
+        if (std::memcmp(data_, dump::kMagic, sizeof(dump::kMagic)) != 0) {
+            ::munmap(data, size_);
+            throw std::runtime_error("'" + path + "' is not a dump file.");
+        }
+        if (std::memcmp(data_ + size_ - kTrailerSize, dump::kTrailer, sizeof(dump::kTrailer)) != 0) {
+            ::munmap(data, size_);
+            throw std::runtime_error("Dump file '" + path + "' is truncated.");
+        }
+        std::memcpy(&count_, data_ + size_ - sizeof(uint64_t), sizeof(count_));
+    }
+
+    ~DumpView() {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    DumpView(const DumpView&) = delete;
+    DumpView& operator=(const DumpView&) = delete;
+
+    uint64_t count() const { return count_; }
+    size_t size() const { return size_; }
+
+    // Splits the records into at most parts byte ranges of similar size. Only the record
+    // headers are touched; a record running past the trailer or a wrong count throws.
+    std::vector<std::pair<size_t, size_t>> split(size_t parts) const {
+        const size_t end = size_ - kTrailerSize;
+        const size_t target = std::max<size_t>(1, (end - sizeof(dump::kMagic)) / std::max<size_t>(1, parts));
+        std::vector<std::pair<size_t, size_t>> ranges;
+        size_t rangeStart = sizeof(dump::kMagic);
+        size_t offset = rangeStart;
+        uint64_t records = 0;
+        while (offset < end) {
+            if (end - offset < dump::kRecordHeaderSize) {
+                throw std::runtime_error("Dump file '" + path_ + "' is corrupt.");
+            }
+            uint32_t header[6];
+            std::memcpy(header, data_ + offset, sizeof(header));
+            const size_t recordSize = dump::kRecordHeaderSize + size_t(header[3]) + header[4] + header[5];
+            if (recordSize > end - offset) {
+                throw std::runtime_error("Dump file '" + path_ + "' is corrupt.");
+            }
+            offset += recordSize;
+            ++records;
+            if (offset - rangeStart >= target && ranges.size() + 1 < parts) {
+                ranges.emplace_back(rangeStart, offset);
+                rangeStart = offset;
+            }
+        }
+        if (records != count_) {
+            throw std::runtime_error("Dump file '" + path_ + "' has an invalid trailer.");
+        }
+        if (offset > rangeStart) {
+            ranges.emplace_back(rangeStart, offset);
+        }
+        return ranges;
+    }
+
+    // Decodes the records of one range returned by split() and verifies their checksums.
+    void decode(size_t begin, size_t end, std::vector<BatchEntry>& out) const {
+        size_t offset = begin;
+        while (offset < end) {
+            uint32_t header[6];
+            std::memcpy(header, data_ + offset, sizeof(header));
+            const size_t recordSize = dump::kRecordHeaderSize + size_t(header[3]) + header[4] + header[5];
+            if (crc32(data_ + offset + sizeof(uint32_t), recordSize - sizeof(uint32_t)) != header[0]) {
+                throw std::runtime_error("Dump file '" + path_ + "' has a corrupt record at offset " + std::to_string(offset) + ".");
+            }
+            const char* data = data_ + offset + dump::kRecordHeaderSize;
+            BatchEntry& entry = out.emplace_back();
+            entry.ttlSeconds = static_cast<int>(header[2]);
+            entry.key.assign(data, header[3]);
+            entry.value.assign(data + header[3], header[4]);
+            entry.group.assign(data + header[3] + header[4], header[5]);
+            offset += recordSize;
+        }
+    }
+
+private:
+    static constexpr size_t kTrailerSize = sizeof(dump::kTrailer) + sizeof(uint64_t);
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t count_ = 0;
+};
+
+// Counters reported by BulkTransfer (also passed to the progress callback).
+struct BulkTransferStats {
+    uint64_t entries = 0;
+    // Records that had no target engine (e.g. non-persistent entries without a RAM target).
+    uint64_t skipped = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+using BulkProgress = std::function<void(const BulkTransferStats&)>;
+
+// ------------------------------
+// BulkTransfer Class
+// ------------------------------
+// Streams entries between StorageEngines and dump files in large batches.
+class BulkTransfer {
+public:
+    // Writes every entry of engine to path; entries are flagged persistent as requested.
+    static BulkTransferStats exportDump(StorageEngine& engine, const std::string& path, bool persistent,
+                                        const BulkProgress& progress = {}, uint64_t progressInterval = 100000) {
+        const auto start = std::chrono::steady_clock::now();
+        BulkTransferStats stats;
+        DumpWriter writer(path);
+        BatchEntry record;
+        engine.forEach([&](const StorageEntry& entry) {
+            record.key = entry.key;
+            record.value = entry.value;
+            record.group = entry.group;
+            writer.write(record, persistent);
+            if (progress && writer.count() % progressInterval == 0) {
+                stats.entries = writer.count();
+                stats.bytes = writer.bytes();
+                stats.seconds = secondsSince(start);
+                progress(stats);
+            }
+        });
+        writer.finish();
+        stats.entries = writer.count();
+        stats.bytes = writer.bytes();
+        stats.seconds = secondsSince(start);
+        return stats;
+    }
+
+    // Loads path with putBatch calls of batchSize entries. Persistent records go to
+    // persistentTarget, the others to volatileTarget; a null target skips its records.
+    static BulkTransferStats importDump(const std::string& path, StorageEngine* persistentTarget,
+                                        StorageEngine* volatileTarget, size_t batchSize = 10000,
+                                        const BulkProgress& progress = {}) {
+        const auto start = std::chrono::steady_clock::now();
+        BulkTransferStats stats;
+        DumpReader reader(path);
+        std::vector<BatchEntry> persistentBatch;
+        std::vector<BatchEntry> volatileBatch;
+        persistentBatch.reserve(batchSize);
+        volatileBatch.reserve(batchSize);
+
+        auto flush = [&](StorageEngine* target, std::vector<BatchEntry>& batch) {
+            if (batch.empty()) {
+                return;
+            }
+            target->putBatch(batch);
+            stats.entries += batch.size();
+            batch.clear();
+            if (progress) {
+                stats.bytes = reader.bytes();
+                stats.seconds = secondsSince(start);
+                progress(stats);
+            }
+        };
+
+        BatchEntry entry;
+        bool persistent = false;
+        while (reader.next(entry, persistent)) {
+            StorageEngine* target = persistent ? persistentTarget : volatileTarget;
+            if (!target) {
+                ++stats.skipped;
+                continue;
+            }
+            auto& batch = persistent ? persistentBatch : volatileBatch;
+            batch.push_back(std::move(entry));
+            if (batch.size() >= batchSize) {
+                flush(target, batch);
+            }
+        }
+        flush(persistentTarget, persistentBatch);
+        flush(volatileTarget, volatileBatch);
+
+        stats.bytes = reader.bytes();
+        stats.seconds = secondsSince(start);
+        return stats;
+    }
+
+private:
+    static double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif // DUMPFILE_H
@@ -0,0 +1,287 @@
+#ifndef IORING_H
+#define IORING_H
+
+#include "eventbus/EventBus.h"  // ThreadPool (fallback)
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+/*
+  IoRing runs positional reads, writes and fsyncs asynchronously. It talks to
+  io_uring directly through the raw syscalls: any number of threads push
+  submission entries, one completion thread reaps the completion queue and
+  fulfils the futures. If io_uring is unavailable (old kernel, seccomp filters
+  in containers) or disabled, the same calls run as blocking syscalls on a small
+  ThreadPool instead.
+
+  Every future yields the syscall result: bytes transferred (or 0 for fsync) on
+  success, -errno on failure. Short reads and writes are left to the caller.
+*/
+class IoRing {
+public:
+    explicit IoRing(unsigned queueDepth = 256, size_t fallbackThreads = 4, bool useIoUring = true)
+        : fallbackThreads_(fallbackThreads)
+    {
+        if (!useIoUring || !setupRing(queueDepth)) {
+            fallback_ = std::make_unique<ThreadPool>(fallbackThreads_);
+        } else {
+            completionThread_ = std::thread(&IoRing::completionLoop, this);
+        }
+        LOG_INFO("IoRing", "Using " << backend() << " for disk I/O.");
+    }
+
+    ~IoRing() {
+        if (ringFd_ >= 0) {
+            // A NOP with user_data 0 wakes the completion thread, which exits once nothing is in flight.
+            submit(IORING_OP_NOP, -1, 0, 0, 0, 0, nullptr);
+            completionThread_.join();
+            if (sqes_) ::munmap(sqes_, sqesSize_);
+            if (cqRing_ && cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+            if (sqRing_) ::munmap(sqRing_, sqRingSize_);
+            ::close(ringFd_);
+        }
+    }
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    bool usesIoUring() const { return ringFd_ >= 0; }
+    const char* backend() const { return usesIoUring() ? "io_uring" : "blocking thread pool"; }
+
+    std::future<ssize_t> read(int fd, void* buffer, size_t size, uint64_t offset) {
+        if (!usesIoUring()) {
+            return fallback_->enqueue([=] {
+                ssize_t n = ::pread(fd, buffer, size, static_cast<off_t>(offset));
+                return n < 0 ? static_cast<ssize_t>(-errno) : n;
+            });
+        }
+        return submitRequest(IORING_OP_READ, fd, reinterpret_cast<uint64_t>(buffer), static_cast<uint32_t>(size), offset, 0);
+    }
+
+    std::future<ssize_t> write(int fd, const void* buffer, size_t size, uint64_t offset) {
+        if (!usesIoUring()) {
+            return fallback_->enqueue([=] {
+                ssize_t n = ::pwrite(fd, buffer, size, static_cast<off_t>(offset));
+                return n < 0 ? static_cast<ssize_t>(-errno) : n;
+            });
+        }
+        return submitRequest(IORING_OP_WRITE, fd, reinterpret_cast<uint64_t>(buffer), static_cast<uint32_t>(size), offset, 0);
+    }
+
+    // Flushes the file; dataOnly skips metadata that is not needed to read the data back (fdatasync).
+    std::future<ssize_t> fsync(int fd, bool dataOnly = true) {
+        if (!usesIoUring()) {
+            return fallback_->enqueue([=] {
+                int rc = dataOnly ? ::fdatasync(fd) : ::fsync(fd);
+                return rc < 0 ? static_cast<ssize_t>(-errno) : static_cast<ssize_t>(0);
+            });
+        }
+        return submitRequest(IORING_OP_FSYNC, fd, 0, 0, 0, dataOnly ? IORING_FSYNC_DATASYNC : 0);
+    }
+
+private:
+    struct Request {
+        std::promise<ssize_t> promise;
+    };
+
+    size_t fallbackThreads_;
+    std::unique_ptr<ThreadPool> fallback_;
+
+    int ringFd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cqMask_ = 0;
+    unsigned cqEntries_ = 0;
+
+    // Serializes submitters and bounds the in-flight requests so the completion queue cannot overflow.
+    std::mutex submitMutex_;
+    std::condition_variable capacityCv_;
+    unsigned inFlight_ = 0;
+
+    std::thread completionThread_;
+
+    static int ioUringSetup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    static unsigned loadAcquire(unsigned* p) { return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire); }
+    static void storeRelease(unsigned* p, unsigned v) { std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release); }
+
+    // Creates the ring and maps its queues; returns false (with everything released) if that is not possible.
+    bool setupRing(unsigned queueDepth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = ioUringSetup(queueDepth, &params);
+        if (fd < 0) {
+            LOG_ERROR("IoRing", "io_uring unavailable (" << std::strerror(errno) << "); falling back to blocking I/O.");
+            return false;
+        }
+        // IORING_OP_READ / IORING_OP_WRITE arrived together with this feature flag (Linux 5.6).
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+            LOG_ERROR("IoRing", "Kernel io_uring lacks IORING_OP_READ/WRITE; falling back to blocking I/O.");
+            ::close(fd);
+            return false;
+        }
+        ringFd_ = fd;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        sqRing_ = mapRing(sqRingSize_, IORING_OFF_SQ_RING);
+        cqRing_ = singleMmap ? sqRing_ : mapRing(cqRingSize_, IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(mapRing(sqesSize_, IORING_OFF_SQES));
+        if (!sqRing_ || !cqRing_ || !sqes_) {
+            LOG_ERROR("IoRing", "Mapping the io_uring queues failed; falling back to blocking I/O.");
+            if (sqes_) ::munmap(sqes_, sqesSize_);
+            if (cqRing_ && cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+            if (sqRing_) ::munmap(sqRing_, sqRingSize_);
+            sqes_ = nullptr;
+            sqRing_ = cqRing_ = nullptr;
+            ::close(ringFd_);
+            ringFd_ = -1;
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries_ = params.sq_entries;
+
+        char* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqEntries_ = params.cq_entries;
+        return true;
+    }
+
+    void* mapRing(size_t size, off_t offset) {
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, offset);
+        return addr == MAP_FAILED ? nullptr : addr;
+    }
+
+    std::future<ssize_t> submitRequest(uint8_t opcode, int fd, uint64_t addr, uint32_t size, uint64_t offset, uint32_t flags) {
+        auto request = std::make_unique<Request>();
+        std::future<ssize_t> future = request->promise.get_future();
+        submit(opcode, fd, addr, size, offset, flags, request.get());
+        request.release();  // Owned by the completion thread from now on.
+        return future;
+    }
+
+    // Pushes one submission queue entry and hands it to the kernel.
+    void submit(uint8_t opcode, int fd, uint64_t addr, uint32_t size, uint64_t offset, uint32_t flags, Request* request) {
+        std::unique_lock<std::mutex> lock(submitMutex_);
+        capacityCv_.wait(lock, [this] {
+            return inFlight_ < cqEntries_ && *sqTail_ - loadAcquire(sqHead_) < sqEntries_;
+        });
+
+        const unsigned tail = *sqTail_;
+        const unsigned index = tail & sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = addr;
+        sqe.len = size;
+        sqe.off = offset;
+        sqe.fsync_flags = flags;
+        sqe.user_data = reinterpret_cast<uint64_t>(request);
+        sqArray_[index] = index;
+        storeRelease(sqTail_, tail + 1);
+        ++inFlight_;
+
+        while (ioUringEnter(ringFd_, 1, 0, 0) < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                // The entry stays queued and goes out with the next successful enter.
+                LOG_ERROR("IoRing", "io_uring_enter failed: " << std::strerror(errno));
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void completionLoop() {
+        bool stopRequested = false;
+        while (true) {
+            unsigned head = *cqHead_;
+            const unsigned tail = loadAcquire(cqTail_);
+            if (head == tail) {
+                if (ioUringEnter(ringFd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                    LOG_ERROR("IoRing", "Waiting for completions failed: " << std::strerror(errno));
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                continue;
+            }
+
+            unsigned completed = 0;
+            for (; head != tail; ++head, ++completed) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                if (cqe.user_data == 0) {
+                    stopRequested = true;
+                    continue;
+                }
+                Request* request = reinterpret_cast<Request*>(cqe.user_data);
+                request->promise.set_value(static_cast<ssize_t>(cqe.res));
+                delete request;
+            }
+            storeRelease(cqHead_, head);
+
+            bool idle;
+            {
+                std::lock_guard<std::mutex> lock(submitMutex_);
+                inFlight_ -= completed;
+                idle = inFlight_ == 0;
+            }
+            capacityCv_.notify_all();
+            if (stopRequested && idle) {
+                break;
+            }
+        }
+    }
+};
+
+#endif // IORING_H
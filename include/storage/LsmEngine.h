@@ -0,0 +1,1027 @@
+#ifndef LSMENGINE_H
+#define LSMENGINE_H
+
+#include "storage/StorageEngine.h"
+#include "storage/Crc32.h"
+#include <iostream>
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <queue>
+#include <type_traits>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// Tuning knobs of the LSM backend.
+struct LsmOptions {
+    // The memtable is frozen and flushed to a level-0 run once it holds this many bytes.
+    size_t memtableBytes = 4 * 1024 * 1024;
+    // fsync the write-ahead log after every write.
+    bool syncOnWrite = true;
+    // Number of level-0 runs that triggers a compaction into level 1.
+    size_t level0CompactionTrigger = 4;
+    // Target size of level 1; every further level may be levelSizeMultiplier times larger.
+    uint64_t level1Bytes = 16 * 1024 * 1024;
+    uint64_t levelSizeMultiplier = 10;
+    // Bloom filter bits per key of a run.
+    uint32_t bloomBitsPerKey = 10;
+};
+
+/*
+  LsmEngine is a log-structured merge tree for write-heavy persistent workloads.
+  Writes go to a write-ahead log and a sorted in-memory memtable. A full memtable is
+  frozen and written by a background thread as an immutable sorted run to level 0.
+  Level 0 may hold several overlapping runs; every deeper level holds exactly one run,
+  and a level that grows beyond its budget is merged into the next one (leveled
+  compaction). Every run carries a bloom filter and a sparse key index, so a point
+  lookup touches at most one data block per run whose filter matches.
+
+  Files inside the directory: wal-N.log, run-N.sst and MANIFEST (run ids per level).
+*/
+class LsmEngine : public StorageEngine {
+public:
+    explicit LsmEngine(const std::string& directory, const LsmOptions& options = {})
+        : directory_(directory)
+        , options_(options)
+        , memtableBytes_(0)
+        , nextFileId_(1)
+        , walFd_(-1)
+        , walId_(0)
+        , stopThread_(false)
+    {
+        std::filesystem::create_directories(directory_);
+        loadManifest();
+        replayWriteAheadLogs();
+        openWriteAheadLog();
+
+        backgroundThread_ = std::thread(&LsmEngine::backgroundLoop, this);
+        LOG_INFO("LsmEngine", "Opened '" << directory_ << "' with " << levels_.size() << " levels and "
+                 << memtable_.size() << " recovered memtable entries.");
+    }
+
+    ~LsmEngine() override {
+        {
+            std::lock_guard<std::shared_mutex> lock(mutex_);
+            stopThread_ = true;
+        }
+        workCv_.notify_all();
+        stallCv_.notify_all();
+        if (backgroundThread_.joinable()) {
+            backgroundThread_.join();
+        }
+        if (walFd_ >= 0) {
+            if (::fdatasync(walFd_) != 0) {
+                LOG_ERROR("LsmEngine", "Final WAL sync failed: " << std::strerror(errno));
+            }
+            ::close(walFd_);
+        }
+        LOG_INFO("LsmEngine", "Closed '" << directory_ << "'.");
+    }
+
+    const char* name() const override { return "lsm"; }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int /*ttlSeconds*/) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        writeLocked(lock, Entry{ key, value, group, false });
+    }
+
+    // Logs the whole batch with a single WAL sync.
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& entry : entries) {
+            writeLocked(lock, Entry{ entry.key, entry.value, entry.group, false }, false);
+        }
+        if (options_.syncOnWrite) {
+            syncData(walFd_);
+        }
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        Entry entry;
+        if (!lookupLocked(key, entry) || entry.tombstone) {
+            return false;
+        }
+        value = std::move(entry.value);
+        return true;
+    }
+
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::optional<std::string>> result(keys.size());
+        Entry entry;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (lookupLocked(keys[i], entry) && !entry.tombstone) {
+                result[i] = std::move(entry.value);
+            }
+        }
+        return result;
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<KeyValue> result;
+        mergeAllLocked([&](const Entry& entry) {
+            if (entry.group == group) {
+                result.push_back({ entry.key, entry.value });
+            }
+        });
+        return result;
+    }
+
+    int erase(const std::string& key) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        Entry existing;
+        if (!lookupLocked(key, existing) || existing.tombstone) {
+            return 0;
+        }
+        writeLocked(lock, Entry{ key, "", "", true });
+        return 1;
+    }
+
+    // Logs the tombstones of the whole batch with a single WAL sync.
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        int count = 0;
+        Entry existing;
+        for (const auto& key : keys) {
+            if (lookupLocked(key, existing) && !existing.tombstone) {
+                writeLocked(lock, Entry{ key, "", "", true }, false);
+                ++count;
+            }
+        }
+        if (count > 0 && options_.syncOnWrite) {
+            syncData(walFd_);
+        }
+        return count;
+    }
+
+    int eraseGroup(const std::string& group) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::string> keys;
+        mergeAllLocked([&](const Entry& entry) {
+            if (entry.group == group) {
+                keys.push_back(entry.key);
+            }
+        });
+        for (const auto& key : keys) {
+            writeLocked(lock, Entry{ key, "", "", true });
+        }
+        return static_cast<int>(keys.size());
+    }
+
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        StorageEntry result;
+        mergeAllLocked([&](const Entry& entry) {
+            result.key = entry.key;
+            result.value = entry.value;
+            result.group = entry.group;
+            fn(result);
+        });
+    }
+
+    // Starts the merge at from and stops after limit live entries, so a chunk reads a few
+    // blocks per run instead of the whole store.
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<StorageEntry> result;
+        if (limit == 0) {
+            return result;
+        }
+        mergeAllLocked([&](const Entry& entry) {
+            if (!end.empty() && entry.key >= end) {
+                return false;
+            }
+            result.push_back({ entry.key, entry.value, entry.group });
+            return result.size() < limit;
+        }, from);
+        return result;
+    }
+
+    StorageStats stats() override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        StorageStats result;
+        result.entries = memtable_.size() + (immutable_ ? immutable_->size() : 0);
+        result.bytes = memtableBytes_;
+        for (const auto& runs : levels_) {
+            for (const auto& run : runs) {
+                result.entries += run->entryCount;
+                result.bytes += run->fileSize;
+            }
+        }
+        return result;
+    }
+
+private:
+    static constexpr uint32_t kTombstone = 1;
+    static constexpr uint64_t kRunMagic = 0x4C534D52554E3031ull;  // "LSMRUN01"
+    static constexpr size_t kIndexInterval = 16;
+    static constexpr size_t kFooterSize = 4 * sizeof(uint64_t);
+
+    struct Entry {
+        std::string key;
+        std::string value;
+        std::string group;
+        bool tombstone = false;
+    };
+
+    using Memtable = std::map<std::string, Entry>;
+
+    // ------------------------------
+    // Encoding Helpers
+    // ------------------------------
+
+    static uint64_t hash64(const std::string& data, uint64_t seed) {
+        // FNV-1a; stable across processes because bloom filters are persisted.
+        uint64_t h = 14695981039346656037ull ^ seed;
+        for (unsigned char c : data) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static void appendU32(std::string& out, uint32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    static void appendU64(std::string& out, uint64_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    static uint32_t readU32(const char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+    static uint64_t readU64(const char* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+    // keySize | valueSize | groupSize | flags | key | value | group
+    static void encodeEntry(std::string& out, const Entry& entry) {
+        appendU32(out, static_cast<uint32_t>(entry.key.size()));
+        appendU32(out, static_cast<uint32_t>(entry.value.size()));
+        appendU32(out, static_cast<uint32_t>(entry.group.size()));
+        appendU32(out, entry.tombstone ? kTombstone : 0);
+        out.append(entry.key);
+        out.append(entry.value);
+        out.append(entry.group);
+    }
+
+    // Decodes one entry at pos; returns false if the buffer ends inside the entry.
+    static bool decodeEntry(const std::string& buffer, size_t& pos, Entry& entry) {
+        if (pos + 4 * sizeof(uint32_t) > buffer.size()) {
+            return false;
+        }
+        const char* p = buffer.data() + pos;
+        const uint32_t keySize = readU32(p), valueSize = readU32(p + 4), groupSize = readU32(p + 8), flags = readU32(p + 12);
+        const size_t total = 4 * sizeof(uint32_t) + size_t(keySize) + valueSize + groupSize;
+        if (pos + total > buffer.size()) {
+            return false;
+        }
+        p += 4 * sizeof(uint32_t);
+        entry.key.assign(p, keySize);
+        entry.value.assign(p + keySize, valueSize);
+        entry.group.assign(p + keySize + valueSize, groupSize);
+        entry.tombstone = (flags & kTombstone) != 0;
+        pos += total;
+        return true;
+    }
+
+    static size_t entryFootprint(const Entry& entry) {
+        return entry.key.size() + entry.value.size() + entry.group.size() + 4 * sizeof(uint32_t);
+    }
+
+    static void writeAll(int fd, const char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("LSM write error: ") + std::strerror(errno));
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+    }
+
+    static void syncData(int fd) {
+        if (::fdatasync(fd) != 0) {
+            throw std::runtime_error(std::string("LSM sync error: ") + std::strerror(errno));
+        }
+    }
+
+    static void readAll(int fd, char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pread(fd, data, size, static_cast<off_t>(offset));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("LSM read error: ") + std::strerror(errno));
+            }
+            if (n == 0) {
+                throw std::runtime_error("LSM run truncated.");
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+    }
+
+    std::string filePath(const char* prefix, uint64_t id, const char* extension) const {
+        char name[40];
+        std::snprintf(name, sizeof(name), "%s-%06llu.%s", prefix, static_cast<unsigned long long>(id), extension);
+        return (std::filesystem::path(directory_) / name).string();
+    }
+
+    // ------------------------------
+    // Sorted Runs
+    // ------------------------------
+
+    // An immutable sorted run on disk with its bloom filter and sparse index kept in memory.
+    struct Run {
+        uint64_t id = 0;
+        std::string path;
+        int fd = -1;
+        uint64_t dataSize = 0;
+        uint64_t fileSize = 0;
+        uint64_t entryCount = 0;
+        std::vector<std::pair<std::string, uint64_t>> sparseIndex;  // (first key of block, offset)
+        std::vector<uint8_t> bloom;
+        uint32_t bloomHashes = 0;
+
+        ~Run() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        bool mayContain(const std::string& key) const {
+            if (bloom.empty()) {
+                return true;
+            }
+            const uint64_t bits = bloom.size() * 8;
+            const uint64_t h1 = hash64(key, 0), h2 = hash64(key, 0x9E3779B97F4A7C15ull) | 1;
+            for (uint32_t i = 0; i < bloomHashes; ++i) {
+                const uint64_t bit = (h1 + i * h2) % bits;
+                if (!(bloom[bit / 8] & (1u << (bit % 8)))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool find(const std::string& key, Entry& entry) const {
+            if (sparseIndex.empty() || key < sparseIndex.front().first || !mayContain(key)) {
+                return false;
+            }
+            // Last block whose first key is <= key.
+            auto it = std::upper_bound(sparseIndex.begin(), sparseIndex.end(), key,
+                [](const std::string& k, const std::pair<std::string, uint64_t>& e) { return k < e.first; });
+            --it;
+            const uint64_t begin = it->second;
+            const uint64_t end = (std::next(it) == sparseIndex.end()) ? dataSize : std::next(it)->second;
+            std::string block(end - begin, '\0');
+            readAll(fd, block.data(), block.size(), begin);
+            size_t pos = 0;
+            Entry candidate;
+            while (decodeEntry(block, pos, candidate)) {
+                if (candidate.key == key) {
+                    entry = std::move(candidate);
+                    return true;
+                }
+                if (candidate.key > key) {
+                    break;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Sequential reader over the entries of a run, starting at the first key >= from.
+    class RunCursor {
+    public:
+        explicit RunCursor(const Run& run, const std::string& from = "") : run_(run), fileOffset_(0), pos_(0), valid_(false) {
+            if (!from.empty()) {
+                // Skip to the last block whose first key is <= from.
+                auto it = std::upper_bound(run.sparseIndex.begin(), run.sparseIndex.end(), from,
+                    [](const std::string& k, const std::pair<std::string, uint64_t>& e) { return k < e.first; });
+                if (it != run.sparseIndex.begin()) {
+                    fileOffset_ = std::prev(it)->second;
+                }
+            }
+            next();
+            while (valid_ && entry_.key < from) {
+                next();
+            }
+        }
+
+        bool valid() const { return valid_; }
+        const Entry& entry() const { return entry_; }
+
+        void next() {
+            while (true) {
+                if (decodeEntry(buffer_, pos_, entry_)) {
+                    valid_ = true;
+                    return;
+                }
+                if (fileOffset_ >= run_.dataSize) {
+                    valid_ = false;
+                    return;
+                }
+                // Refill: keep the undecoded tail and append the next chunk.
+                buffer_.erase(0, pos_);
+                pos_ = 0;
+                const size_t chunk = static_cast<size_t>(std::min<uint64_t>(256 * 1024, run_.dataSize - fileOffset_));
+                const size_t old = buffer_.size();
+                buffer_.resize(old + chunk);
+                readAll(run_.fd, buffer_.data() + old, chunk, fileOffset_);
+                fileOffset_ += chunk;
+            }
+        }
+
+    private:
+        const Run& run_;
+        uint64_t fileOffset_;
+        std::string buffer_;
+        size_t pos_;
+        Entry entry_;
+        bool valid_;
+    };
+
+    // Streams sorted entries with unique keys into a new run file.
+    class RunWriter {
+    public:
+        RunWriter(const std::string& path, uint64_t id, uint64_t expectedEntries, uint32_t bitsPerKey)
+            : run_(std::make_shared<Run>()), offset_(0)
+        {
+            run_->id = id;
+            run_->path = path;
+            run_->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (run_->fd < 0) {
+                LOG_ERROR("LsmEngine", "Unable to create run '" << path << "': " << std::strerror(errno));
+                throw std::runtime_error("Error creating LSM run.");
+            }
+            const uint64_t bits = std::max<uint64_t>(64, expectedEntries * bitsPerKey);
+            run_->bloom.assign((bits + 7) / 8, 0);
+            run_->bloomHashes = std::max<uint32_t>(1, static_cast<uint32_t>(bitsPerKey * 0.69));
+        }
+
+        void add(const Entry& entry) {
+            if (run_->entryCount % kIndexInterval == 0) {
+                run_->sparseIndex.emplace_back(entry.key, offset_ + buffer_.size());
+            }
+            const uint64_t bloomBits = run_->bloom.size() * 8;
+            const uint64_t h1 = hash64(entry.key, 0), h2 = hash64(entry.key, 0x9E3779B97F4A7C15ull) | 1;
+            for (uint32_t k = 0; k < run_->bloomHashes; ++k) {
+                const uint64_t bit = (h1 + k * h2) % bloomBits;
+                run_->bloom[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+            }
+            encodeEntry(buffer_, entry);
+            ++run_->entryCount;
+            if (buffer_.size() >= 1024 * 1024) {
+                writeAll(run_->fd, buffer_.data(), buffer_.size(), offset_);
+                offset_ += buffer_.size();
+                buffer_.clear();
+            }
+        }
+
+        uint64_t entryCount() const { return run_->entryCount; }
+
+        // Writes the trailer (sparse index, bloom filter, fixed-size footer) and syncs the file.
+        std::shared_ptr<Run> finish() {
+            run_->dataSize = offset_ + buffer_.size();
+            const uint64_t indexOffset = run_->dataSize;
+            appendU64(buffer_, run_->sparseIndex.size());
+            for (const auto& [key, blockOffset] : run_->sparseIndex) {
+                appendU32(buffer_, static_cast<uint32_t>(key.size()));
+                buffer_.append(key);
+                appendU64(buffer_, blockOffset);
+            }
+            const uint64_t bloomOffset = offset_ + buffer_.size();
+            appendU32(buffer_, run_->bloomHashes);
+            appendU32(buffer_, static_cast<uint32_t>(run_->bloom.size()));
+            buffer_.append(reinterpret_cast<const char*>(run_->bloom.data()), run_->bloom.size());
+            appendU64(buffer_, indexOffset);
+            appendU64(buffer_, bloomOffset);
+            appendU64(buffer_, run_->entryCount);
+            appendU64(buffer_, kRunMagic);
+            writeAll(run_->fd, buffer_.data(), buffer_.size(), offset_);
+            run_->fileSize = offset_ + buffer_.size();
+            buffer_.clear();
+            // A run that is not on disk must not reach the MANIFEST.
+            syncData(run_->fd);
+            return run_;
+        }
+
+    private:
+        std::shared_ptr<Run> run_;
+        std::string buffer_;
+        uint64_t offset_;
+    };
+
+    // Writes a sorted memtable to a new run.
+    std::shared_ptr<Run> writeRun(uint64_t id, const Memtable& table) {
+        RunWriter writer(filePath("run", id, "sst"), id, table.size(), options_.bloomBitsPerKey);
+        for (const auto& [key, entry] : table) {
+            writer.add(entry);
+        }
+        return writer.finish();
+    }
+
+    std::shared_ptr<Run> openRun(uint64_t id) {
+        auto run = std::make_shared<Run>();
+        run->id = id;
+        run->path = filePath("run", id, "sst");
+        run->fd = ::open(run->path.c_str(), O_RDONLY);
+        if (run->fd < 0) {
+            LOG_ERROR("LsmEngine", "Unable to open run '" << run->path << "': " << std::strerror(errno));
+            throw std::runtime_error("Error opening LSM run.");
+        }
+        run->fileSize = static_cast<uint64_t>(::lseek(run->fd, 0, SEEK_END));
+        if (run->fileSize < kFooterSize) {
+            throw std::runtime_error("LSM run too small: " + run->path);
+        }
+        char footer[kFooterSize];
+        readAll(run->fd, footer, kFooterSize, run->fileSize - kFooterSize);
+        const uint64_t indexOffset = readU64(footer), bloomOffset = readU64(footer + 8);
+        run->entryCount = readU64(footer + 16);
+        if (readU64(footer + 24) != kRunMagic || indexOffset > bloomOffset || bloomOffset > run->fileSize) {
+            throw std::runtime_error("LSM run footer corrupt: " + run->path);
+        }
+        run->dataSize = indexOffset;
+
+        std::string trailer(run->fileSize - kFooterSize - indexOffset, '\0');
+        readAll(run->fd, trailer.data(), trailer.size(), indexOffset);
+        size_t pos = 0;
+        const uint64_t indexCount = readU64(trailer.data());
+        pos += sizeof(uint64_t);
+        for (uint64_t i = 0; i < indexCount; ++i) {
+            const uint32_t keySize = readU32(trailer.data() + pos);
+            pos += sizeof(uint32_t);
+            std::string key(trailer.data() + pos, keySize);
+            pos += keySize;
+            run->sparseIndex.emplace_back(std::move(key), readU64(trailer.data() + pos));
+            pos += sizeof(uint64_t);
+        }
+        pos = bloomOffset - indexOffset;
+        run->bloomHashes = readU32(trailer.data() + pos);
+        const uint32_t bloomSize = readU32(trailer.data() + pos + 4);
+        run->bloom.assign(trailer.data() + pos + 8, trailer.data() + pos + 8 + bloomSize);
+        return run;
+    }
+
+    // ------------------------------
+    // State
+    // ------------------------------
+
+    std::string directory_;
+    LsmOptions options_;
+
+    // Protects everything below. Readers take it shared; run files are immutable.
+    std::shared_mutex mutex_;
+    Memtable memtable_;
+    size_t memtableBytes_;
+    // Frozen memtable being written to level 0 (nullptr if none).
+    std::shared_ptr<const Memtable> immutable_;
+    // levels_[0] holds overlapping runs (newest last); deeper levels hold at most one run.
+    std::vector<std::vector<std::shared_ptr<Run>>> levels_;
+    uint64_t nextFileId_;
+
+    int walFd_;
+    uint64_t walId_;
+    uint64_t walSize_ = 0;
+    // WAL files that only cover the frozen memtable; deleted once it is on disk.
+    std::vector<uint64_t> frozenWals_;
+
+    std::thread backgroundThread_;
+    std::condition_variable_any workCv_;
+    std::condition_variable_any stallCv_;
+    bool stopThread_;
+
+    // ------------------------------
+    // Write Path
+    // ------------------------------
+
+    // sync = false leaves the WAL sync to the caller (batched writes).
+    void writeLocked(std::unique_lock<std::shared_mutex>& lock, Entry entry, bool sync = true) {
+        // Stall while the previous memtable is still being flushed and the current one is full.
+        stallCv_.wait(lock, [this] { return stopThread_ || !immutable_ || memtableBytes_ < options_.memtableBytes; });
+
+        std::string record(sizeof(uint32_t), '\0');
+        encodeEntry(record, entry);
+        const uint32_t crc = crc32(record.data() + sizeof(uint32_t), record.size() - sizeof(uint32_t));
+        std::memcpy(record.data(), &crc, sizeof(crc));
+        writeAll(walFd_, record.data(), record.size(), walSize_);
+        walSize_ += record.size();
+        if (sync && options_.syncOnWrite) {
+            syncData(walFd_);
+        }
+
+        auto it = memtable_.find(entry.key);
+        if (it != memtable_.end()) {
+            memtableBytes_ -= entryFootprint(it->second);
+            memtableBytes_ += entryFootprint(entry);
+            it->second = std::move(entry);
+        } else {
+            memtableBytes_ += entryFootprint(entry);
+            std::string key = entry.key;
+            memtable_.emplace(std::move(key), std::move(entry));
+        }
+
+        if (memtableBytes_ >= options_.memtableBytes && !immutable_) {
+            freezeMemtableLocked();
+        }
+    }
+
+    // Moves the memtable aside and starts a new WAL for the next one.
+    void freezeMemtableLocked() {
+        syncData(walFd_);
+        immutable_ = std::make_shared<const Memtable>(std::move(memtable_));
+        memtable_.clear();
+        memtableBytes_ = 0;
+        frozenWals_.push_back(walId_);
+        ::close(walFd_);
+        walFd_ = -1;
+        openWriteAheadLog();
+        workCv_.notify_one();
+    }
+
+    void openWriteAheadLog() {
+        walId_ = nextFileId_++;
+        const std::string path = filePath("wal", walId_, "log");
+        walFd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (walFd_ < 0) {
+            LOG_ERROR("LsmEngine", "Unable to create WAL '" << path << "': " << std::strerror(errno));
+            throw std::runtime_error("Error creating LSM write-ahead log.");
+        }
+        walSize_ = 0;
+    }
+
+    // ------------------------------
+    // Read Path
+    // ------------------------------
+
+    // Finds the newest version of key (which may be a tombstone). Caller holds mutex_.
+    bool lookupLocked(const std::string& key, Entry& entry) {
+        auto it = memtable_.find(key);
+        if (it != memtable_.end()) {
+            entry = it->second;
+            return true;
+        }
+        if (immutable_) {
+            auto frozen = immutable_->find(key);
+            if (frozen != immutable_->end()) {
+                entry = frozen->second;
+                return true;
+            }
+        }
+        for (size_t level = 0; level < levels_.size(); ++level) {
+            const auto& runs = levels_[level];
+            // Newer runs are stored last in level 0.
+            for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+                if ((*run)->find(key, entry)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Source for the k-way merge; lower rank means newer data.
+    struct MergeSource {
+        size_t rank;
+        std::unique_ptr<RunCursor> cursor;
+        Memtable::const_iterator it, end;
+
+        bool valid() const { return cursor ? cursor->valid() : it != end; }
+        const Entry& entry() const { return cursor ? cursor->entry() : it->second; }
+        void next() { if (cursor) cursor->next(); else ++it; }
+    };
+
+    // Merges the given sources in key order and calls fn with the newest version of every key.
+    // If fn returns bool, false stops the merge.
+    template <typename Fn>
+    static void mergeSources(std::vector<MergeSource>& sources, bool keepTombstones, Fn&& fn) {
+        auto cmp = [&sources](size_t a, size_t b) {
+            const auto& ka = sources[a].entry().key;
+            const auto& kb = sources[b].entry().key;
+            return ka != kb ? ka > kb : sources[a].rank > sources[b].rank;
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(cmp)> heap(cmp);
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (sources[i].valid()) heap.push(i);
+        }
+        while (!heap.empty()) {
+            const size_t top = heap.top();
+            heap.pop();
+            const std::string key = sources[top].entry().key;
+            if (keepTombstones || !sources[top].entry().tombstone) {
+                if constexpr (std::is_same_v<std::invoke_result_t<Fn&, const Entry&>, bool>) {
+                    if (!fn(sources[top].entry())) {
+                        return;
+                    }
+                } else {
+                    fn(sources[top].entry());
+                }
+            }
+            sources[top].next();
+            if (sources[top].valid()) heap.push(top);
+            // Skip older versions of the same key.
+            while (!heap.empty() && sources[heap.top()].entry().key == key) {
+                const size_t older = heap.top();
+                heap.pop();
+                sources[older].next();
+                if (sources[older].valid()) heap.push(older);
+            }
+        }
+    }
+
+    // Visits every live entry of the store with key >= from in key order. Caller holds mutex_.
+    template <typename Fn>
+    void mergeAllLocked(Fn&& fn, const std::string& from = "") {
+        std::vector<MergeSource> sources;
+        size_t rank = 0;
+        sources.push_back(MergeSource{ rank++, nullptr, memtable_.lower_bound(from), memtable_.cend() });
+        if (immutable_) {
+            sources.push_back(MergeSource{ rank++, nullptr, immutable_->lower_bound(from), immutable_->cend() });
+        }
+        for (const auto& runs : levels_) {
+            for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+                sources.push_back(MergeSource{ rank++, std::make_unique<RunCursor>(**run, from), {}, {} });
+            }
+        }
+        mergeSources(sources, false, fn);
+    }
+
+    // ------------------------------
+    // Background Flush and Compaction
+    // ------------------------------
+
+    void backgroundLoop() {
+        while (true) {
+            std::shared_ptr<const Memtable> frozen;
+            {
+                std::unique_lock<std::shared_mutex> lock(mutex_);
+                workCv_.wait_for(lock, std::chrono::milliseconds(200), [this] { return stopThread_ || immutable_; });
+                if (stopThread_ && !immutable_) {
+                    break;
+                }
+                frozen = immutable_;
+            }
+            try {
+                if (frozen) {
+                    flushMemtable(frozen);
+                }
+                while (compactOneLevel()) {
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("LsmEngine", "Background work failed: " << e.what());
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+        LOG_INFO("LsmEngine", "Background thread exiting.");
+    }
+
+    void flushMemtable(const std::shared_ptr<const Memtable>& frozen) {
+        uint64_t runId;
+        {
+            std::lock_guard<std::shared_mutex> lock(mutex_);
+            runId = nextFileId_++;
+        }
+        auto run = writeRun(runId, *frozen);
+
+        std::vector<uint64_t> obsoleteWals;
+        {
+            std::lock_guard<std::shared_mutex> lock(mutex_);
+            if (levels_.empty()) {
+                levels_.emplace_back();
+            }
+            levels_[0].push_back(run);
+            immutable_.reset();
+            obsoleteWals.swap(frozenWals_);
+            saveManifestLocked();
+        }
+        stallCv_.notify_all();
+        for (uint64_t id : obsoleteWals) {
+            std::filesystem::remove(filePath("wal", id, "log"));
+        }
+        LOG_INFO("LsmEngine", "Flushed memtable with " << frozen->size() << " entries to run " << runId << ".");
+    }
+
+    uint64_t levelBudget(size_t level) const {
+        uint64_t budget = options_.level1Bytes;
+        for (size_t i = 1; i < level; ++i) {
+            budget *= options_.levelSizeMultiplier;
+        }
+        return budget;
+    }
+
+    // Merges one over-full level into the next; returns false if no level needs compaction.
+    bool compactOneLevel() {
+        std::vector<std::shared_ptr<Run>> inputs;
+        size_t source = 0;
+        bool bottom = false;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (!levels_.empty() && levels_[0].size() >= options_.level0CompactionTrigger) {
+                source = 0;
+            } else {
+                bool found = false;
+                for (size_t level = 1; level < levels_.size(); ++level) {
+                    if (!levels_[level].empty() && levels_[level][0]->fileSize > levelBudget(level)) {
+                        source = level;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    return false;
+                }
+            }
+            // Newest input first: source level (level 0 newest last), then the target level.
+            inputs.assign(levels_[source].rbegin(), levels_[source].rend());
+            if (source + 1 < levels_.size()) {
+                inputs.insert(inputs.end(), levels_[source + 1].begin(), levels_[source + 1].end());
+            }
+            bottom = source + 2 >= levels_.size();
+        }
+
+        uint64_t runId;
+        {
+            std::lock_guard<std::shared_mutex> lock(mutex_);
+            runId = nextFileId_++;
+        }
+
+        std::vector<MergeSource> sources;
+        uint64_t expectedEntries = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            sources.push_back(MergeSource{ i, std::make_unique<RunCursor>(*inputs[i]), {}, {} });
+            expectedEntries += inputs[i]->entryCount;
+        }
+        // Tombstones can be dropped once nothing older exists below the target level.
+        RunWriter writer(filePath("run", runId, "sst"), runId, expectedEntries, options_.bloomBitsPerKey);
+        mergeSources(sources, !bottom, [&writer](const Entry& entry) { writer.add(entry); });
+        const uint64_t mergedEntries = writer.entryCount();
+        std::shared_ptr<Run> output = writer.finish();
+        if (mergedEntries == 0) {
+            std::filesystem::remove(output->path);
+            output.reset();
+        }
+
+        {
+            std::lock_guard<std::shared_mutex> lock(mutex_);
+            // Level 0 may have received new runs meanwhile; remove only the merged ones.
+            auto& sourceRuns = levels_[source];
+            sourceRuns.erase(std::remove_if(sourceRuns.begin(), sourceRuns.end(), [&inputs](const std::shared_ptr<Run>& run) {
+                return std::find(inputs.begin(), inputs.end(), run) != inputs.end();
+            }), sourceRuns.end());
+            if (levels_.size() <= source + 1) {
+                levels_.emplace_back();
+            }
+            levels_[source + 1].clear();
+            if (output) {
+                levels_[source + 1].push_back(output);
+            }
+            saveManifestLocked();
+        }
+        for (const auto& run : inputs) {
+            std::filesystem::remove(run->path);
+        }
+        LOG_INFO("LsmEngine", "Compacted level " << source << " into level " << (source + 1) << ": "
+                 << inputs.size() << " runs -> " << mergedEntries << " entries.");
+        return true;
+    }
+
+    // ------------------------------
+    // Manifest and Recovery
+    // ------------------------------
+
+    // MANIFEST lines: "<level> <runId>"; replaced atomically via rename. Callers delete WALs
+    // and merged runs right after this returns, so the rename is synced before that.
+    void saveManifestLocked() {
+        const std::string tmpPath = (std::filesystem::path(directory_) / "MANIFEST.tmp").string();
+        {
+            std::ofstream out(tmpPath, std::ios::trunc);
+            for (size_t level = 0; level < levels_.size(); ++level) {
+                for (const auto& run : levels_[level]) {
+                    out << level << ' ' << run->id << '\n';
+                }
+            }
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Error writing LSM manifest.");
+            }
+        }
+        syncPath(tmpPath, O_RDONLY);
+        std::filesystem::rename(tmpPath, std::filesystem::path(directory_) / "MANIFEST");
+        syncPath(directory_, O_RDONLY | O_DIRECTORY);
+    }
+
+    static void syncPath(const std::string& path, int flags) {
+        const int fd = ::open(path.c_str(), flags);
+        if (fd < 0) {
+            throw std::runtime_error("LSM cannot open '" + path + "' for sync: " + std::strerror(errno));
+        }
+        const int rc = ::fsync(fd);
+        const int error = errno;
+        ::close(fd);
+        if (rc != 0) {
+            throw std::runtime_error("LSM sync error on '" + path + "': " + std::strerror(error));
+        }
+    }
+
+    void loadManifest() {
+        uint64_t maxId = 0;
+        std::ifstream in(std::filesystem::path(directory_) / "MANIFEST");
+        size_t level;
+        uint64_t id;
+        while (in >> level >> id) {
+            if (levels_.size() <= level) {
+                levels_.resize(level + 1);
+            }
+            levels_[level].push_back(openRun(id));
+            maxId = std::max(maxId, id);
+        }
+
+        // Remove runs left behind by an interrupted flush or compaction.
+        for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+            unsigned long long fileId;
+            const std::string name = file.path().filename().string();
+            if (std::sscanf(name.c_str(), "run-%llu.sst", &fileId) == 1) {
+                bool referenced = false;
+                for (const auto& runs : levels_) {
+                    for (const auto& run : runs) {
+                        referenced = referenced || run->id == fileId;
+                    }
+                }
+                if (!referenced) {
+                    std::filesystem::remove(file.path());
+                }
+            }
+            if (std::sscanf(name.c_str(), "wal-%llu.log", &fileId) == 1) {
+                maxId = std::max<uint64_t>(maxId, fileId);
+            }
+        }
+        nextFileId_ = maxId + 1;
+    }
+
+    // Replays every WAL in id order into the memtable; a torn tail record ends the replay of that file.
+    void replayWriteAheadLogs() {
+        std::vector<uint64_t> ids;
+        for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+            unsigned long long fileId;
+            if (std::sscanf(file.path().filename().string().c_str(), "wal-%llu.log", &fileId) == 1) {
+                ids.push_back(fileId);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+
+        for (uint64_t id : ids) {
+            const std::string path = filePath("wal", id, "log");
+            std::ifstream in(path, std::ios::binary);
+            std::string buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            size_t pos = 0;
+            while (pos + sizeof(uint32_t) <= buffer.size()) {
+                const uint32_t crc = readU32(buffer.data() + pos);
+                size_t entryPos = pos + sizeof(uint32_t);
+                Entry entry;
+                if (!decodeEntry(buffer, entryPos, entry) ||
+                    crc32(buffer.data() + pos + sizeof(uint32_t), entryPos - pos - sizeof(uint32_t)) != crc) {
+                    LOG_ERROR("LsmEngine", "WAL '" << path << "' has a corrupt tail at offset " << pos << ".");
+                    break;
+                }
+                pos = entryPos;
+                memtableBytes_ += entryFootprint(entry);
+                std::string key = entry.key;
+                memtable_[std::move(key)] = std::move(entry);
+            }
+        }
+
+        // Persist the recovered state as a level-0 run so the old logs can go.
+        if (!memtable_.empty()) {
+            if (levels_.empty()) {
+                levels_.emplace_back();
+            }
+            levels_[0].push_back(writeRun(nextFileId_++, memtable_));
+            saveManifestLocked();
+            memtable_.clear();
+            memtableBytes_ = 0;
+        }
+        for (uint64_t id : ids) {
+            std::filesystem::remove(filePath("wal", id, "log"));
+        }
+    }
+};
+
+#endif // LSMENGINE_H
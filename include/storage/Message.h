@@ -2,6 +2,8 @@
 #define SOCKETCONNECTION_H
 
 #include <eventbus/Message.h>
+#include <vector>
+#include <optional>
 
 
 // SET EVENT
@@ -40,6 +42,58 @@ struct DeleteGroupEventMessage : public Message {
 
 struct ListEventMessage : public Message {
     std::string id;
+    // Chunked listing: continue at this cursor (empty = from the start) and return at
+    // most limit entries. limit == 0 lists everything in one response.
+    std::string after;
+    size_t limit = 0;
+};
+
+// SCAN EVENT: one step of an incremental iteration over both tiers.
+struct ScanEventMessage : public Message {
+    std::string id;
+    // Opaque cursor from the previous response; "0" (or empty) starts a new scan.
+    std::string cursor;
+    // Number of keys to examine per step (a hint; filters may return fewer).
+    size_t count = 100;
+    // Optional filters.
+    std::string group;
+    std::string prefix;
+};
+
+// RANGE EVENT: entries with start <= key < end in key order ("" = unbounded).
+// A prefix narrows the range to the keys starting with it.
+struct RangeEventMessage : public Message {
+    std::string id;
+    std::string start;
+    std::string end;
+    std::string prefix;
+    size_t limit = 100;
+};
+
+// One entry of an MSET.
+struct MSetEntry {
+    std::string key;
+    std::string value;
+    std::string group;
+    bool persistent = false;
+    int ttl = 0;
+};
+
+// MSET / MGET / MDELETE EVENTS: many keys in one request. The StorageHandler sends
+// at most one message per tier for the whole batch.
+struct MSetEventMessage : public Message {
+    std::string id;
+    std::vector<MSetEntry> entries;
+};
+
+struct MGetEventMessage : public Message {
+    std::string id;
+    std::vector<std::string> keys;
+};
+
+struct MDeleteEventMessage : public Message {
+    std::string id;
+    std::vector<std::string> keys;
 };
 
 // ======================
@@ -85,6 +139,39 @@ struct StorageEntry {
 struct ListEventReponseMessage : public Message {
     std::string id;
     std::vector<StorageEntry> response;
+    // Cursor for the next chunk; empty once the listing is complete.
+    std::string next;
+};
+
+struct ScanResponseMessage : public Message {
+    std::string id;
+    // Cursor for the next step; "0" once the scan is complete.
+    std::string cursor;
+    std::vector<StorageEntry> response;
+};
+
+struct RangeResponseMessage : public Message {
+    std::string id;
+    std::vector<StorageEntry> response;
+    // Start key for the next page; empty if the range is exhausted.
+    std::string next;
+};
+
+struct MSetResponseMessage : public Message {
+    std::string id;
+    bool response;
+};
+
+struct MGetResponseMessage : public Message {
+    std::string id;
+    // One value per requested key, in request order; empty if the key does not exist.
+    std::vector<std::optional<std::string>> response;
+};
+
+struct MDeleteResponseMessage : public Message {
+    std::string id;
+    // Number of removed entries.
+    int response;
 };
 
 #endif //SOCKETCONNECTION_H
@@ -0,0 +1,809 @@
+#ifndef MMAPHASHENGINE_H
+#define MMAPHASHENGINE_H
+
+#include "storage/StorageEngine.h"
+#include "storage/Crc32.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <shared_mutex>
+#include <set>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// Tuning knobs of the memory-mapped hash table backend.
+struct MmapHashOptions {
+    // Number of slots of a new table (rounded up to a power of two).
+    uint64_t initialCapacity = 1024;
+    // fsync the redo log after every write (matches the durability of a SQLite commit).
+    bool syncOnWrite = true;
+    // The mapping is msync'ed and the redo log truncated once the log grows beyond this size.
+    uint64_t checkpointBytes = 4 * 1024 * 1024;
+    // The table is rebuilt once used and deleted slots exceed this fraction of the capacity.
+    double maxLoadFactor = 0.7;
+};
+
+/*
+  MmapHashEngine keeps all entries in one memory-mapped file: a header, an
+  open-addressing hash table (linear probing) and a value heap behind it. A GET
+  hashes the key, probes the mapped slots and copies the value out of the heap,
+  without a single syscall.
+
+  Writes are first appended to a redo log and then applied to the mapping. The
+  mapping is only msync'ed at checkpoints, after which the log is truncated. On
+  startup, slots that point at invalid heap records are dropped and the log is
+  replayed; put and erase are idempotent, so replaying an already applied
+  operation is harmless. When the table fills up (or the heap is mostly dead),
+  the live records are copied into a new generation file, which replaces the old
+  one once it is complete.
+
+  The hash table has no key order, so a sorted copy of the keys is kept in memory
+  for SCAN and RANGE; it is rebuilt from the table on startup.
+
+  File layout:  FileHeader | Slot[capacity] | heap records
+  Heap record:  crc32 | keyLen | valueLen | groupLen | key | value | group  (padded to 8 bytes)
+  Redo record:  crc32 | op | keyLen | valueLen | groupLen | key | value | group
+*/
+class MmapHashEngine : public StorageEngine {
+public:
+    explicit MmapHashEngine(const std::string& directory, const MmapHashOptions& options = {})
+        : directory_(directory)
+        , options_(options)
+    {
+        std::filesystem::create_directories(directory_);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        openTable();
+        recover();
+        forEachLocked([this](const char* record) { keyIndex_.insert(recordKey(record)); });
+        LOG_INFO("MmapHashEngine", "Opened '" << directory_ << "' with " << header()->count
+                 << " live keys and " << header()->capacity << " slots.");
+    }
+
+    ~MmapHashEngine() override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        try {
+            checkpointLocked();
+        } catch (const std::exception& e) {
+            LOG_ERROR("MmapHashEngine", "Checkpoint on shutdown failed: " << e.what());
+        }
+        unmapTable();
+        if (logFd_ >= 0) {
+            ::close(logFd_);
+        }
+        LOG_INFO("MmapHashEngine", "Table closed.");
+    }
+
+    const char* name() const override { return "mmap"; }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int /*ttlSeconds*/) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        // Rebuilding drops the redo log, so it has to happen before this write is logged.
+        reserveSlotLocked();
+        appendRedo(kOpPut, key, value, group);
+        syncRedo();
+        putLocked(key, value, group);
+        maybeCheckpoint();
+    }
+
+    // Applies the whole batch under one lock with a single redo log sync.
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& entry : entries) {
+            reserveSlotLocked();
+            appendRedo(kOpPut, entry.key, entry.value, entry.group);
+            putLocked(entry.key, entry.value, entry.group);
+        }
+        syncRedo();
+        maybeCheckpoint();
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const uint64_t slot = findSlot(key, hashKey(key));
+        if (slot == kNotFound) {
+            return false;
+        }
+        const char* record = base_ + slots()[slot].offset;
+        value.assign(record + kRecordHeaderSize + readU32(record + 4), readU32(record + 8));
+        return true;
+    }
+
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::optional<std::string>> result(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const uint64_t slot = findSlot(keys[i], hashKey(keys[i]));
+            if (slot != kNotFound) {
+                const char* record = base_ + slots()[slot].offset;
+                result[i].emplace(record + kRecordHeaderSize + readU32(record + 4), readU32(record + 8));
+            }
+        }
+        return result;
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<KeyValue> result;
+        forEachLocked([&](const char* record) {
+            if (recordGroupEquals(record, group)) {
+                result.push_back({ recordKey(record), recordValue(record) });
+            }
+        });
+        return result;
+    }
+
+    int erase(const std::string& key) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (findSlot(key, hashKey(key)) == kNotFound) {
+            return 0;
+        }
+        appendRedo(kOpErase, key, "", "");
+        syncRedo();
+        eraseLocked(key);
+        maybeCheckpoint();
+        return 1;
+    }
+
+    // Removes the whole batch under one lock with a single redo log sync.
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        int count = 0;
+        for (const auto& key : keys) {
+            if (findSlot(key, hashKey(key)) != kNotFound) {
+                appendRedo(kOpErase, key, "", "");
+                eraseLocked(key);
+                ++count;
+            }
+        }
+        if (count > 0) {
+            syncRedo();
+            maybeCheckpoint();
+        }
+        return count;
+    }
+
+    int eraseGroup(const std::string& group) override {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        int matches = 0;
+        forEachLocked([&](const char* record) {
+            if (recordGroupEquals(record, group)) {
+                matches++;
+            }
+        });
+        if (matches == 0) {
+            return 0;
+        }
+        appendRedo(kOpEraseGroup, group, "", "");
+        syncRedo();
+        eraseGroupLocked(group);
+        maybeCheckpoint();
+        return matches;
+    }
+
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        StorageEntry entry;
+        forEachLocked([&](const char* record) {
+            entry.key = recordKey(record);
+            entry.value = recordValue(record);
+            entry.group = recordGroup(record);
+            fn(entry);
+        });
+    }
+
+    // Walks the ordered key index, so the lock is held for at most limit lookups.
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<StorageEntry> result;
+        const auto last = end.empty() ? keyIndex_.end() : keyIndex_.lower_bound(end);
+        for (auto it = keyIndex_.lower_bound(from); it != last && result.size() < limit; ++it) {
+            const char* record = base_ + slots()[findSlot(*it, hashKey(*it))].offset;
+            result.push_back({ *it, recordValue(record), recordGroup(record) });
+        }
+        return result;
+    }
+
+    StorageStats stats() override {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        StorageStats result;
+        result.entries = header()->count;
+        result.bytes = mappedSize_ + logSize_;
+        return result;
+    }
+
+private:
+    static constexpr uint64_t kMagic = 0x3148534148504d4dull;  // "MMPHASH1"
+    static constexpr uint64_t kNotFound = ~0ull;
+    static constexpr size_t kRecordHeaderSize = 4 * sizeof(uint32_t);
+    static constexpr size_t kRedoHeaderSize = 5 * sizeof(uint32_t);
+    static constexpr uint64_t kMinHeapSlack = 64 * 1024;
+
+    static constexpr uint32_t kSlotEmpty = 0;
+    static constexpr uint32_t kSlotUsed = 1;
+    static constexpr uint32_t kSlotDeleted = 2;
+
+    static constexpr uint32_t kOpPut = 1;
+    static constexpr uint32_t kOpErase = 2;
+    static constexpr uint32_t kOpEraseGroup = 3;
+
+    struct FileHeader {
+        uint64_t magic;
+        uint64_t complete;    // Set once a new generation file is fully written.
+        uint64_t capacity;    // Number of slots (power of two).
+        uint64_t count;       // Live entries.
+        uint64_t tombstones;  // Deleted slots.
+        uint64_t heapEnd;     // First free heap byte (file offset).
+        uint64_t deadBytes;   // Heap bytes no longer referenced by a slot.
+        uint64_t reserved;
+    };
+
+    struct Slot {
+        uint64_t hash;
+        uint64_t offset;      // File offset of the heap record.
+        uint32_t size;        // Padded record size.
+        uint32_t state;
+    };
+
+    std::string directory_;
+    MmapHashOptions options_;
+
+    // Protects the mapping and the redo log. GETs take it shared; writers (and remaps) exclusively.
+    std::shared_mutex mutex_;
+    int fd_ = -1;
+    char* base_ = nullptr;
+    uint64_t mappedSize_ = 0;
+    uint32_t generation_ = 0;
+    int logFd_ = -1;
+    uint64_t logSize_ = 0;
+    bool replaying_ = false;
+    // Live keys in order (filled after recovery).
+    std::set<std::string> keyIndex_;
+
+    // ------------------------------
+    // Helpers
+    // ------------------------------
+
+    static uint64_t hashKey(const std::string& key) {
+        // FNV-1a; persisted in the slots, so it must be stable across processes.
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static uint32_t readU32(const char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+    static void writeU32(char* p, uint32_t v) { std::memcpy(p, &v, sizeof(v)); }
+
+    static uint64_t pad8(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+    static uint64_t roundToPage(uint64_t size) {
+        const uint64_t page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        return (size + page - 1) / page * page;
+    }
+
+    static uint64_t heapStart(uint64_t capacity) {
+        return sizeof(FileHeader) + capacity * sizeof(Slot);
+    }
+
+    FileHeader* header() const { return reinterpret_cast<FileHeader*>(base_); }
+    Slot* slots() const { return reinterpret_cast<Slot*>(base_ + sizeof(FileHeader)); }
+
+    static std::string recordKey(const char* record) {
+        return std::string(record + kRecordHeaderSize, readU32(record + 4));
+    }
+
+    static std::string recordValue(const char* record) {
+        return std::string(record + kRecordHeaderSize + readU32(record + 4), readU32(record + 8));
+    }
+
+    static std::string recordGroup(const char* record) {
+        return std::string(record + kRecordHeaderSize + readU32(record + 4) + readU32(record + 8), readU32(record + 12));
+    }
+
+    static bool recordGroupEquals(const char* record, const std::string& group) {
+        const uint32_t groupSize = readU32(record + 12);
+        return groupSize == group.size() &&
+               std::memcmp(record + kRecordHeaderSize + readU32(record + 4) + readU32(record + 8), group.data(), groupSize) == 0;
+    }
+
+    std::string tablePath(uint32_t generation) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "table-%06u.mht", generation);
+        return (std::filesystem::path(directory_) / name).string();
+    }
+
+    std::string logPath() const {
+        return (std::filesystem::path(directory_) / "redo.log").string();
+    }
+
+    static void throwErrno(const std::string& what) {
+        throw std::runtime_error("MmapHash " + what + ": " + std::strerror(errno));
+    }
+
+    // Calls fn with every live heap record. Caller holds mutex_.
+    template <typename Fn>
+    void forEachLocked(Fn&& fn) const {
+        const uint64_t capacity = header()->capacity;
+        for (uint64_t i = 0; i < capacity; ++i) {
+            if (slots()[i].state == kSlotUsed) {
+                fn(base_ + slots()[i].offset);
+            }
+        }
+    }
+
+    // Returns the slot holding key, or kNotFound. Caller holds mutex_.
+    uint64_t findSlot(const std::string& key, uint64_t hash) const {
+        const uint64_t mask = header()->capacity - 1;
+        for (uint64_t probe = 0, i = hash & mask; probe <= mask; ++probe, i = (i + 1) & mask) {
+            const Slot& slot = slots()[i];
+            if (slot.state == kSlotEmpty) {
+                return kNotFound;
+            }
+            if (slot.state == kSlotUsed && slot.hash == hash) {
+                const char* record = base_ + slot.offset;
+                if (readU32(record + 4) == key.size() &&
+                    std::memcmp(record + kRecordHeaderSize, key.data(), key.size()) == 0) {
+                    return i;
+                }
+            }
+        }
+        return kNotFound;
+    }
+
+    // ------------------------------
+    // Table Files
+    // ------------------------------
+
+    void mapFile(int fd, uint64_t size) {
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            throwErrno("mmap failed");
+        }
+        fd_ = fd;
+        base_ = static_cast<char*>(addr);
+        mappedSize_ = size;
+    }
+
+    void unmapTable() {
+        if (base_) {
+            ::munmap(base_, mappedSize_);
+            base_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // Creates and maps an empty, not yet complete table file.
+    void createTable(uint32_t generation, uint64_t capacity, uint64_t heapBytes) {
+        const std::string path = tablePath(generation);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throwErrno("cannot create '" + path + "'");
+        }
+        const uint64_t size = roundToPage(heapStart(capacity) + std::max(heapBytes, kMinHeapSlack));
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            throwErrno("cannot size '" + path + "'");
+        }
+        mapFile(fd, size);
+        generation_ = generation;
+        // ftruncate zero-fills, so all slots start out empty.
+        FileHeader* h = header();
+        h->magic = kMagic;
+        h->complete = 0;
+        h->capacity = capacity;
+        h->count = 0;
+        h->tombstones = 0;
+        h->heapEnd = heapStart(capacity);
+        h->deadBytes = 0;
+    }
+
+    // Flushes a freshly written table file and marks it complete.
+    void sealTable() {
+        if (::msync(base_, mappedSize_, MS_SYNC) != 0) {
+            throwErrno("msync failed");
+        }
+        header()->complete = 1;
+        if (::msync(base_, sizeof(FileHeader), MS_SYNC) != 0) {
+            throwErrno("msync failed");
+        }
+    }
+
+    // Maps the newest complete table file, removing incomplete or superseded ones.
+    void openTable() {
+        std::vector<uint32_t> generations;
+        for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+            unsigned id = 0;
+            if (std::sscanf(file.path().filename().c_str(), "table-%06u.mht", &id) == 1) {
+                generations.push_back(id);
+            }
+        }
+        std::sort(generations.rbegin(), generations.rend());
+
+        for (uint32_t generation : generations) {
+            if (base_) {
+                std::filesystem::remove(tablePath(generation));
+                continue;
+            }
+            int fd = ::open(tablePath(generation).c_str(), O_RDWR);
+            struct stat st{};
+            if (fd < 0 || ::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(FileHeader)) {
+                if (fd >= 0) ::close(fd);
+                LOG_ERROR("MmapHashEngine", "Ignoring unreadable table generation " << generation);
+                std::filesystem::remove(tablePath(generation));
+                continue;
+            }
+            mapFile(fd, static_cast<uint64_t>(st.st_size));
+            const FileHeader* h = header();
+            const uint64_t capacity = h->capacity;
+            const bool valid = h->magic == kMagic && h->complete == 1 && capacity != 0 &&
+                               (capacity & (capacity - 1)) == 0 && heapStart(capacity) <= mappedSize_;
+            if (!valid) {
+                LOG_ERROR("MmapHashEngine", "Ignoring incomplete table generation " << generation);
+                unmapTable();
+                std::filesystem::remove(tablePath(generation));
+                continue;
+            }
+            generation_ = generation;
+        }
+
+        if (!base_) {
+            uint64_t capacity = 16;
+            while (capacity < options_.initialCapacity) {
+                capacity <<= 1;
+            }
+            createTable(1, capacity, 0);
+            sealTable();
+        }
+    }
+
+    // Grows the file (and the mapping) so that size more heap bytes fit. Caller holds mutex_ exclusively.
+    void ensureHeapSpace(uint64_t size) {
+        const uint64_t needed = header()->heapEnd + size;
+        if (needed <= mappedSize_) {
+            return;
+        }
+        const uint64_t newSize = roundToPage(std::max(needed, mappedSize_ * 2));
+        if (::ftruncate(fd_, static_cast<off_t>(newSize)) != 0) {
+            throwErrno("cannot grow table file");
+        }
+        void* addr = ::mremap(base_, mappedSize_, newSize, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED) {
+            throwErrno("mremap failed");
+        }
+        base_ = static_cast<char*>(addr);
+        mappedSize_ = newSize;
+    }
+
+    // Writes a heap record at heapEnd and returns its offset. Caller holds mutex_ exclusively.
+    uint64_t appendHeapRecord(const char* key, uint32_t keySize, const char* value, uint32_t valueSize,
+                              const char* group, uint32_t groupSize) {
+        const uint64_t size = pad8(kRecordHeaderSize + keySize + valueSize + groupSize);
+        ensureHeapSpace(size);
+        const uint64_t offset = header()->heapEnd;
+        char* record = base_ + offset;
+        writeU32(record + 4, keySize);
+        writeU32(record + 8, valueSize);
+        writeU32(record + 12, groupSize);
+        std::memcpy(record + kRecordHeaderSize, key, keySize);
+        std::memcpy(record + kRecordHeaderSize + keySize, value, valueSize);
+        std::memcpy(record + kRecordHeaderSize + keySize + valueSize, group, groupSize);
+        writeU32(record, crc32(record + 4, kRecordHeaderSize - 4 + keySize + valueSize + groupSize));
+        header()->heapEnd = offset + size;
+        return offset;
+    }
+
+    // ------------------------------
+    // Mutations (shared by the write path and redo log replay)
+    // ------------------------------
+
+    // Rebuilds the table if one more insert would exceed the load factor.
+    void reserveSlotLocked() {
+        const FileHeader* h = header();
+        if (static_cast<double>(h->count + h->tombstones + 1) > static_cast<double>(h->capacity) * options_.maxLoadFactor) {
+            rebuildLocked();
+        }
+    }
+
+    // Caller has called reserveSlotLocked(), so a free slot exists.
+    void putLocked(const std::string& key, const std::string& value, const std::string& group) {
+        const uint64_t hash = hashKey(key);
+        const uint64_t offset = appendHeapRecord(key.data(), static_cast<uint32_t>(key.size()),
+                                                 value.data(), static_cast<uint32_t>(value.size()),
+                                                 group.data(), static_cast<uint32_t>(group.size()));
+        const uint32_t size = static_cast<uint32_t>(pad8(kRecordHeaderSize + key.size() + value.size() + group.size()));
+        FileHeader* h = header();  // The mapping may have moved.
+
+        const uint64_t existing = findSlot(key, hash);
+        if (existing != kNotFound) {
+            Slot& slot = slots()[existing];
+            h->deadBytes += slot.size;
+            slot.offset = offset;
+            slot.size = size;
+            return;
+        }
+
+        const uint64_t mask = h->capacity - 1;
+        for (uint64_t i = hash & mask; ; i = (i + 1) & mask) {
+            Slot& slot = slots()[i];
+            if (slot.state != kSlotUsed) {
+                if (slot.state == kSlotDeleted) {
+                    h->tombstones--;
+                }
+                slot.hash = hash;
+                slot.offset = offset;
+                slot.size = size;
+                slot.state = kSlotUsed;
+                h->count++;
+                keyIndex_.insert(key);
+                break;
+            }
+        }
+
+        if (h->deadBytes > kMinHeapSlack && h->deadBytes > h->heapEnd - heapStart(h->capacity) - h->deadBytes) {
+            rebuildLocked();
+        }
+    }
+
+    void releaseSlot(uint64_t index) {
+        Slot& slot = slots()[index];
+        keyIndex_.erase(recordKey(base_ + slot.offset));
+        slot.state = kSlotDeleted;
+        header()->deadBytes += slot.size;
+        header()->count--;
+        header()->tombstones++;
+    }
+
+    int eraseLocked(const std::string& key) {
+        const uint64_t index = findSlot(key, hashKey(key));
+        if (index == kNotFound) {
+            return 0;
+        }
+        releaseSlot(index);
+        return 1;
+    }
+
+    int eraseGroupLocked(const std::string& group) {
+        int count = 0;
+        const uint64_t capacity = header()->capacity;
+        for (uint64_t i = 0; i < capacity; ++i) {
+            if (slots()[i].state == kSlotUsed && recordGroupEquals(base_ + slots()[i].offset, group)) {
+                releaseSlot(i);
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // Copies all live records into a new generation file with a table sized for them.
+    // The new file is complete on disk before the old one and the redo log are dropped.
+    void rebuildLocked() {
+        const FileHeader* old = header();
+        const uint64_t live = old->count;
+        uint64_t capacity = 16;
+        while (static_cast<double>(live + 1) * 2 > static_cast<double>(capacity) * options_.maxLoadFactor) {
+            capacity <<= 1;
+        }
+        const uint64_t liveBytes = old->heapEnd - heapStart(old->capacity) - old->deadBytes;
+
+        char* oldBase = base_;
+        const uint64_t oldSize = mappedSize_;
+        const int oldFd = fd_;
+        const uint32_t oldGeneration = generation_;
+        const uint64_t oldCapacity = old->capacity;
+        const Slot* oldSlots = reinterpret_cast<const Slot*>(oldBase + sizeof(FileHeader));
+
+        try {
+            createTable(oldGeneration + 1, capacity, liveBytes + liveBytes / 2);
+        } catch (...) {
+            base_ = oldBase;
+            mappedSize_ = oldSize;
+            fd_ = oldFd;
+            generation_ = oldGeneration;
+            throw;
+        }
+
+        const uint64_t mask = capacity - 1;
+        for (uint64_t i = 0; i < oldCapacity; ++i) {
+            const Slot& from = oldSlots[i];
+            if (from.state != kSlotUsed) {
+                continue;
+            }
+            // The new heap was sized for all live records, so this never remaps.
+            const uint64_t offset = header()->heapEnd;
+            std::memcpy(base_ + offset, oldBase + from.offset, from.size);
+            header()->heapEnd += from.size;
+            for (uint64_t j = from.hash & mask; ; j = (j + 1) & mask) {
+                Slot& to = slots()[j];
+                if (to.state == kSlotEmpty) {
+                    to = from;
+                    to.offset = offset;
+                    break;
+                }
+            }
+            header()->count++;
+        }
+        sealTable();
+
+        // During recovery the log still holds operations that have not been applied yet.
+        if (!replaying_) {
+            truncateLog();
+        }
+        ::munmap(oldBase, oldSize);
+        ::close(oldFd);
+        std::filesystem::remove(tablePath(oldGeneration));
+        LOG_INFO("MmapHashEngine", "Rebuilt table generation " << generation_ << " with " << capacity
+                 << " slots for " << live << " live keys.");
+    }
+
+    // ------------------------------
+    // Redo Log and Recovery
+    // ------------------------------
+
+    void appendRedo(uint32_t op, const std::string& key, const std::string& value, const std::string& group) {
+        std::string record(kRedoHeaderSize + key.size() + value.size() + group.size(), '\0');
+        writeU32(record.data() + 4, op);
+        writeU32(record.data() + 8, static_cast<uint32_t>(key.size()));
+        writeU32(record.data() + 12, static_cast<uint32_t>(value.size()));
+        writeU32(record.data() + 16, static_cast<uint32_t>(group.size()));
+        std::memcpy(record.data() + kRedoHeaderSize, key.data(), key.size());
+        std::memcpy(record.data() + kRedoHeaderSize + key.size(), value.data(), value.size());
+        std::memcpy(record.data() + kRedoHeaderSize + key.size() + value.size(), group.data(), group.size());
+        writeU32(record.data(), crc32(record.data() + 4, record.size() - 4));
+
+        const char* data = record.data();
+        size_t remaining = record.size();
+        while (remaining > 0) {
+            ssize_t n = ::write(logFd_, data, remaining);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throwErrno("redo log write error");
+            }
+            data += n;
+            remaining -= static_cast<size_t>(n);
+        }
+        logSize_ += record.size();
+    }
+
+    void syncRedo() {
+        if (options_.syncOnWrite && ::fdatasync(logFd_) != 0) {
+            throwErrno("redo log sync error");
+        }
+    }
+
+    void truncateLog() {
+        if (::ftruncate(logFd_, 0) != 0 || ::fdatasync(logFd_) != 0) {
+            throwErrno("cannot truncate redo log");
+        }
+        logSize_ = 0;
+    }
+
+    // Persists the mapping; afterwards the redo log is no longer needed.
+    void checkpointLocked() {
+        if (logSize_ == 0) {
+            return;
+        }
+        if (::msync(base_, mappedSize_, MS_SYNC) != 0) {
+            throwErrno("msync failed");
+        }
+        truncateLog();
+    }
+
+    void maybeCheckpoint() {
+        if (logSize_ >= options_.checkpointBytes) {
+            checkpointLocked();
+        }
+    }
+
+    // Drops slots whose heap record did not survive a crash and recomputes the header counters.
+    void repairTable() {
+        FileHeader* h = header();
+        const uint64_t start = heapStart(h->capacity);
+        uint64_t count = 0, tombstones = 0, liveBytes = 0, heapEnd = std::max(h->heapEnd, start);
+        for (uint64_t i = 0; i < h->capacity; ++i) {
+            Slot& slot = slots()[i];
+            if (slot.state == kSlotUsed) {
+                bool valid = slot.offset >= start && slot.size >= kRecordHeaderSize &&
+                             slot.offset + slot.size <= mappedSize_;
+                if (valid) {
+                    const char* record = base_ + slot.offset;
+                    const uint64_t payload = kRecordHeaderSize + uint64_t(readU32(record + 4)) +
+                                             readU32(record + 8) + readU32(record + 12);
+                    valid = pad8(payload) == slot.size &&
+                            readU32(record) == crc32(record + 4, payload - 4) &&
+                            hashKey(recordKey(record)) == slot.hash;
+                }
+                if (valid) {
+                    count++;
+                    liveBytes += slot.size;
+                    heapEnd = std::max(heapEnd, slot.offset + slot.size);
+                    continue;
+                }
+                slot.state = kSlotDeleted;
+            }
+            if (slot.state != kSlotEmpty) {
+                // Keeps probe chains intact; unknown states are treated as deleted as well.
+                slot.state = kSlotDeleted;
+                tombstones++;
+            }
+        }
+        h->count = count;
+        h->tombstones = tombstones;
+        h->heapEnd = std::min(heapEnd, mappedSize_);
+        h->deadBytes = h->heapEnd - start - liveBytes;
+    }
+
+    // Replays the redo log (if the last run did not end with a checkpoint) and truncates it.
+    void recover() {
+        logFd_ = ::open(logPath().c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (logFd_ < 0) {
+            throwErrno("cannot open redo log");
+        }
+        std::string log;
+        char buffer[64 * 1024];
+        ssize_t n;
+        while ((n = ::pread(logFd_, buffer, sizeof(buffer), static_cast<off_t>(log.size()))) > 0) {
+            log.append(buffer, static_cast<size_t>(n));
+        }
+        if (n < 0) {
+            throwErrno("cannot read redo log");
+        }
+        logSize_ = log.size();
+        if (log.empty()) {
+            return;
+        }
+
+        repairTable();
+        replaying_ = true;
+        size_t pos = 0, replayed = 0;
+        while (pos + kRedoHeaderSize <= log.size()) {
+            const char* p = log.data() + pos;
+            const uint64_t total = kRedoHeaderSize + uint64_t(readU32(p + 8)) + readU32(p + 12) + readU32(p + 16);
+            if (pos + total > log.size() || crc32(p + 4, total - 4) != readU32(p)) {
+                break;  // Torn tail of the last write.
+            }
+            const std::string key(p + kRedoHeaderSize, readU32(p + 8));
+            const uint32_t op = readU32(p + 4);
+            if (op == kOpPut) {
+                reserveSlotLocked();
+                putLocked(key, std::string(p + kRedoHeaderSize + key.size(), readU32(p + 12)),
+                          std::string(p + kRedoHeaderSize + key.size() + readU32(p + 12), readU32(p + 16)));
+            } else if (op == kOpErase) {
+                eraseLocked(key);
+            } else if (op == kOpEraseGroup) {
+                eraseGroupLocked(key);
+            }
+            pos += total;
+            replayed++;
+        }
+        if (pos < log.size()) {
+            LOG_ERROR("MmapHashEngine", "Dropping " << (log.size() - pos) << " bytes of a torn redo log tail.");
+        }
+        replaying_ = false;
+        LOG_INFO("MmapHashEngine", "Replayed " << replayed << " redo log records.");
+        checkpointLocked();
+    }
+};
+
+#endif // MMAPHASHENGINE_H
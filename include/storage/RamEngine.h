@@ -0,0 +1,310 @@
+#ifndef RAMENGINE_H
+#define RAMENGINE_H
+
+#include "storage/StorageEngine.h"
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <string_view>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+using Clock = std::chrono::steady_clock;
+
+// Forward declaration for the iterator type of the eviction queue.
+using EvictionIterator = std::multimap<Clock::time_point, std::string>::iterator;
+
+// Structure that stores an entry in RAM.
+struct RamEntry {
+    std::string value;
+    // Group used for later searches.
+    std::string group;
+    // Insertion time (for eviction).
+    Clock::time_point insertionTime;
+    // Expiration time; if TTL <= 0, expirationTime is set to a distant future time.
+    Clock::time_point expirationTime;
+    // Iterator in the eviction queue.
+    EvictionIterator evictionIt;
+};
+
+// ------------------------------
+// RamEngine Class
+// ------------------------------
+// Volatile engine backing the RamHandler: an unordered_map with TTLs and a
+// size limit that is enforced by expireAndEvict() (oldest entries go first).
+// An ordered index over the keys serves scans in small, key-ordered chunks.
+class RamEngine : public StorageEngine {
+public:
+    explicit RamEngine(size_t maxSizeBytes)
+        : maxSizeBytes_(maxSizeBytes)
+        , currentUsage_(0)
+    {}
+
+    const char* name() const override { return "ram"; }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int ttlSeconds) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        putLocked(key, value, group, ttlSeconds, Clock::now());
+    }
+
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        for (const auto& entry : entries) {
+            putLocked(entry.key, entry.value, entry.group, entry.ttlSeconds, now);
+        }
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = store_.find(key);
+        if (it == store_.end()) {
+            return false;
+        }
+        value = it->second.value;
+        return true;
+    }
+
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::optional<std::string>> result(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto it = store_.find(keys[i]);
+            if (it != store_.end()) {
+                result[i] = it->second.value;
+            }
+        }
+        return result;
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<KeyValue> result;
+        for (auto it = store_.begin(); it != store_.end(); ++it) {
+            if (it->second.group == group) {
+                result.push_back({ it->first, it->second.value });
+            }
+        }
+        return result;
+    }
+
+    int erase(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = store_.find(key);
+        if (it == store_.end()) {
+            return 0;
+        }
+        removeLocked(it);
+        return 1;
+    }
+
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int count = 0;
+        for (const auto& key : keys) {
+            auto it = store_.find(key);
+            if (it != store_.end()) {
+                removeLocked(it);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    int eraseGroup(const std::string& group) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int count = 0;
+        for (auto it = store_.begin(); it != store_.end(); ) {
+            if (it->second.group == group) {
+                it = removeLocked(it);
+                ++count;
+            } else {
+                ++it;
+            }
+        }
+        return count;
+    }
+
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        StorageEntry entry;
+        for (auto it = store_.begin(); it != store_.end(); ++it) {
+            entry.key = it->first;
+            entry.value = it->second.value;
+            entry.group = it->second.group;
+            fn(entry);
+        }
+    }
+
+    // Walks the ordered key index, so the lock is held for at most limit entries.
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<StorageEntry> result;
+        const auto last = end.empty() ? keyIndex_.end() : keyIndex_.lower_bound(end);
+        for (auto it = keyIndex_.lower_bound(from); it != last && result.size() < limit; ++it) {
+            const RamEntry& entry = store_.find(std::string(*it))->second;
+            result.push_back({ std::string(*it), entry.value, entry.group });
+        }
+        return result;
+    }
+
+    StorageStats stats() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        StorageStats result;
+        result.entries = store_.size();
+        result.bytes = currentUsage_;
+        return result;
+    }
+
+    // Point-in-time copy of all live entries, oldest first, with their remaining TTL
+    // (rounded up; 0 = no TTL). Loading the copy with putBatch keeps the eviction order.
+    std::vector<BatchEntry> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        std::vector<BatchEntry> result;
+        result.reserve(store_.size());
+        for (const auto& [insertionTime, key] : evictionQueue_) {
+            const RamEntry& entry = store_.at(key);
+            int ttlSeconds = 0;
+            if (entry.expirationTime != Clock::time_point::max()) {
+                if (entry.expirationTime <= now) {
+                    continue;
+                }
+                ttlSeconds = static_cast<int>(std::chrono::ceil<std::chrono::seconds>(entry.expirationTime - now).count());
+            }
+            result.push_back({ key, entry.value, entry.group, ttlSeconds });
+        }
+        return result;
+    }
+
+    // Removes expired entries, then evicts the oldest entries while usage exceeds the limit.
+    void expireAndEvict() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+
+        // --- 1. TTL Check ---
+        for (auto it = store_.begin(); it != store_.end(); ) {
+            if (now >= it->second.expirationTime) {
+                LOG_INFO("RamEngine", "TTL Check: Removing expired entry: " << it->first);
+                it = removeLocked(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // --- 2. Size-based Eviction ---
+        while (currentUsage_ > maxSizeBytes_ && !evictionQueue_.empty()) {
+            // The oldest entry (by insertion time) is at the beginning of the queue.
+            auto evIt = evictionQueue_.begin();
+            std::string key = evIt->second;
+            LOG_INFO("RamEngine", "Size Eviction: Usage (" << currentUsage_
+                     << ") exceeds limit (" << maxSizeBytes_
+                     << "). Removing entry: " << key);
+            auto storeIt = store_.find(key);
+            if (storeIt != store_.end()) {
+                removeLocked(storeIt);
+            } else {
+                // Safety check: should not happen, but erase the iterator regardless.
+                evictionQueue_.erase(evIt);
+            }
+        }
+    }
+
+private:
+    // Internal storage for key-value pairs.
+    std::unordered_map<std::string, RamEntry> store_;
+    // Mutex to protect the store and other member variables.
+    std::mutex mutex_;
+    // Eviction queue: sorted by insertion time (oldest first).
+    std::multimap<Clock::time_point, std::string> evictionQueue_;
+    // Keys in sorted order; the views point into the nodes of store_.
+    std::set<std::string_view> keyIndex_;
+    // Maximum size in bytes.
+    size_t maxSizeBytes_;
+    // Current (incrementally managed) memory usage (sum of key and value lengths).
+    size_t currentUsage_;
+
+    using StoreIterator = std::unordered_map<std::string, RamEntry>::iterator;
+
+    // Inserts or overwrites one entry. Caller holds mutex_.
+    void putLocked(const std::string& key, const std::string& value, const std::string& group, int ttlSeconds,
+                   Clock::time_point now) {
+        // If the key already exists, remove the old entry and adjust currentUsage_.
+        auto it = store_.find(key);
+        if (it != store_.end()) {
+            currentUsage_ -= calculateExactEntryUsage(it->first, it->second);
+            evictionQueue_.erase(it->second.evictionIt);
+            keyIndex_.erase(it->first);
+            store_.erase(it);
+            LOG_INFO("RamEngine", "Overwriting existing key: " << key);
+        }
+
+        RamEntry entry;
+        entry.value = value;
+        entry.insertionTime = now;
+        entry.group = group;
+        if (ttlSeconds > 0) {
+            entry.expirationTime = now + std::chrono::seconds(ttlSeconds);
+        } else {
+            // If ttl <= 0, set expirationTime to a distant future.
+            entry.expirationTime = Clock::time_point::max();
+        }
+        // Insert into the eviction queue and store the iterator in the entry.
+        auto evIt = evictionQueue_.insert({ entry.insertionTime, key });
+        entry.evictionIt = evIt;
+
+        currentUsage_ += calculateExactEntryUsage(key, entry);
+        auto stored = store_.emplace(key, std::move(entry)).first;
+        keyIndex_.insert(stored->first);
+    }
+
+    // Removes an entry together with its eviction queue slot. Caller holds mutex_.
+    StoreIterator removeLocked(StoreIterator it) {
+        currentUsage_ -= calculateExactEntryUsage(it->first, it->second);
+        evictionQueue_.erase(it->second.evictionIt);
+        keyIndex_.erase(it->first);
+        return store_.erase(it);
+    }
+
+    // Calculates the (approximate) memory usage of a store entry.
+    size_t calculateExactEntryUsage(const std::string& key, const RamEntry& entry) {
+        size_t usage = 0;
+
+        // 1. Key (std::string)
+        usage += sizeof(key);
+        usage += key.capacity() * sizeof(char);
+
+        // 2. entry.value (std::string)
+        usage += sizeof(entry.value);
+        usage += entry.value.capacity() * sizeof(char);
+
+        // 3. entry.group (std::string)
+        usage += sizeof(entry.group);
+        usage += entry.group.capacity() * sizeof(char);
+
+        // 4. Additional fields in RamEntry:
+        usage += sizeof(entry.insertionTime);
+        usage += sizeof(entry.expirationTime);
+
+        // 5. evictionIt (an iterator, typically a pointer or similar)
+        usage += sizeof(entry.evictionIt);
+
+        // 6. Node of the ordered key index (view + tree links and color)
+        usage += sizeof(std::string_view) + 4 * sizeof(void*);
+
+        return usage;
+    }
+};
+
+#endif // RAMENGINE_H
@@ -0,0 +1,463 @@
+#ifndef RAMOPLOG_H
+#define RAMOPLOG_H
+
+#include "storage/StorageEngine.h"
+#include "storage/RamEngine.h"
+#include "storage/DumpFile.h"  // dump::kBufferSize
+#include "storage/Crc32.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// When the append log is flushed to disk.
+enum class OpLogFsync {
+    Always,       // before every write is acknowledged
+    EverySecond,  // by the background thread; at most ~1 s of writes can be lost
+    Never         // left to the OS
+};
+
+// Settings for the RAM append log (optional "ram.appendLog" section of the config).
+struct RamOpLogOptions {
+    bool enabled = false;
+    std::string file = "ram_oplog.aof";
+    OpLogFsync fsync = OpLogFsync::EverySecond;
+    // The log is rewritten once it is larger than rewriteMinBytes and has grown by
+    // rewriteGrowthPercent since the last rewrite.
+    uint64_t rewriteMinBytes = 64ull * 1024 * 1024;
+    int rewriteGrowthPercent = 100;
+};
+
+/*
+  RamOpLog wraps the RamEngine and appends every SET / DELETE KEY / DELETE GROUP to
+  a log file before applying it. On startup the log is replayed into the engine.
+
+  Record: crc32 | op | expireAtMs (int64, wall clock, 0 = no TTL) | keyLen | valueLen | groupLen | data
+  (header fields 32 bit except expireAtMs, native byte order; the crc covers everything after itself)
+
+  TTLs are logged as absolute wall-clock times, so entries that expired while the
+  node was down are not restored. Size evictions are not logged; replayed entries
+  beyond the size limit are evicted again by the RamHandler.
+
+  The rewrite copies the current entries into a new log while writes continue: ops
+  arriving meanwhile go to the old log and to a buffer, which is appended to the new
+  log right before it replaces the old one.
+*/
+class RamOpLog : public StorageEngine {
+public:
+    RamOpLog(RamEngine& engine, const RamOpLogOptions& options)
+        : engine_(engine)
+        , options_(options)
+        , stopThread_(false)
+    {
+        replay();
+        fd_ = ::open(options_.file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Cannot open append log '" + options_.file + "': " + std::strerror(errno));
+        }
+        lastRewriteSize_ = size_;
+        bgThread_ = std::thread(&RamOpLog::backgroundLoop, this);
+    }
+
+    ~RamOpLog() {
+        {
+            std::lock_guard<std::mutex> lock(threadMutex_);
+            stopThread_ = true;
+        }
+        cv_.notify_all();
+        if (bgThread_.joinable()) {
+            bgThread_.join();
+        }
+        if (options_.fsync != OpLogFsync::Never) {
+            ::fdatasync(fd_);
+        }
+        ::close(fd_);
+    }
+
+    RamOpLog(const RamOpLog&) = delete;
+    RamOpLog& operator=(const RamOpLog&) = delete;
+
+    const char* name() const override { return "ram+oplog"; }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int ttlSeconds) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_.clear();
+        encode(record_, kOpSet, expireAt(ttlSeconds), key, value, group);
+        appendLocked(record_);
+        engine_.put(key, value, group, ttlSeconds);
+    }
+
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_.clear();
+        for (const auto& entry : entries) {
+            encode(record_, kOpSet, expireAt(entry.ttlSeconds), entry.key, entry.value, entry.group);
+        }
+        appendLocked(record_);
+        engine_.putBatch(entries);
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        return engine_.get(key, value);
+    }
+
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        return engine_.getBatch(keys);
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        return engine_.getGroup(group);
+    }
+
+    int erase(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_.clear();
+        encode(record_, kOpDelete, 0, key, "", "");
+        appendLocked(record_);
+        return engine_.erase(key);
+    }
+
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_.clear();
+        for (const auto& key : keys) {
+            encode(record_, kOpDelete, 0, key, "", "");
+        }
+        appendLocked(record_);
+        return engine_.eraseBatch(keys);
+    }
+
+    int eraseGroup(const std::string& group) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_.clear();
+        encode(record_, kOpDeleteGroup, 0, "", "", group);
+        appendLocked(record_);
+        return engine_.eraseGroup(group);
+    }
+
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        engine_.forEach(fn);
+    }
+
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        return engine_.scan(from, limit, end);
+    }
+
+    StorageStats stats() override {
+        return engine_.stats();
+    }
+
+    // Current size of the log file in bytes.
+    uint64_t logSize() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    // Replaces the log by one SET per live entry; returns the new log size.
+    uint64_t rewrite() {
+        std::lock_guard<std::mutex> rewriteLock(rewriteMutex_);
+        const std::string tmpFile = options_.file + ".rewrite";
+        std::vector<BatchEntry> entries;
+        int64_t now = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries = engine_.snapshot();
+            now = nowMs();
+            rewriting_ = true;
+            rewriteBuffer_.clear();
+        }
+
+        const int fd = ::open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rewriting_ = false;
+            throw std::runtime_error("Cannot create '" + tmpFile + "': " + std::strerror(errno));
+        }
+        uint64_t written = 0;
+        try {
+            std::string buffer;
+            for (const auto& entry : entries) {
+                encode(buffer, kOpSet, entry.ttlSeconds > 0 ? now + int64_t(entry.ttlSeconds) * 1000 : 0,
+                       entry.key, entry.value, entry.group);
+                if (buffer.size() >= dump::kBufferSize) {
+                    writeAll(fd, buffer);
+                    written += buffer.size();
+                    buffer.clear();
+                }
+            }
+            writeAll(fd, buffer);
+            written += buffer.size();
+        } catch (...) {
+            discardRewrite(fd, tmpFile);
+            std::lock_guard<std::mutex> lock(mutex_);
+            rewriting_ = false;
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        rewriting_ = false;
+        try {
+            writeAll(fd, rewriteBuffer_);
+        } catch (...) {
+            discardRewrite(fd, tmpFile);
+            throw;
+        }
+        written += rewriteBuffer_.size();
+        rewriteBuffer_.clear();
+        rewriteBuffer_.shrink_to_fit();
+        // The rename replaces the only copy of the log; the current log stays in use if this fails.
+        if (::fdatasync(fd) != 0) {
+            const int error = errno;
+            discardRewrite(fd, tmpFile);
+            throw std::runtime_error("Cannot sync '" + tmpFile + "': " + std::strerror(error));
+        }
+        std::filesystem::rename(tmpFile, options_.file);
+        syncDirectory();
+        // The new file is positioned at its end, so appends continue there.
+        ::close(fd_);
+        fd_ = fd;
+        size_ = written;
+        lastRewriteSize_ = written;
+        LOG_INFO("RamOpLog", "Rewrote " << options_.file << " with " << entries.size() << " entries (" << written << " bytes).");
+        return written;
+    }
+
+private:
+    static constexpr uint32_t kOpSet = 1;
+    static constexpr uint32_t kOpDelete = 2;
+    static constexpr uint32_t kOpDeleteGroup = 3;
+    static constexpr size_t kHeaderSize = 5 * sizeof(uint32_t) + sizeof(int64_t);
+
+    RamEngine& engine_;
+    RamOpLogOptions options_;
+    int fd_ = -1;
+    uint64_t size_ = 0;
+    uint64_t lastRewriteSize_ = 0;
+    // Serializes log appends with the engine update, so log order equals apply order.
+    std::mutex mutex_;
+    std::string record_;
+    bool rewriting_ = false;
+    std::string rewriteBuffer_;
+    std::mutex rewriteMutex_;
+
+    // Background thread: fsync (EverySecond) and log rewriting.
+    std::thread bgThread_;
+    std::mutex threadMutex_;
+    std::condition_variable cv_;
+    bool stopThread_;
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static int64_t expireAt(int ttlSeconds) {
+        return ttlSeconds > 0 ? nowMs() + int64_t(ttlSeconds) * 1000 : 0;
+    }
+
+    static void encode(std::string& out, uint32_t op, int64_t expireAtMs,
+                       const std::string& key, const std::string& value, const std::string& group) {
+        const size_t start = out.size();
+        const uint32_t head[2] = { 0, op };
+        const uint32_t lengths[3] = {
+            static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size()), static_cast<uint32_t>(group.size())
+        };
+        out.append(reinterpret_cast<const char*>(head), sizeof(head));
+        out.append(reinterpret_cast<const char*>(&expireAtMs), sizeof(expireAtMs));
+        out.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+        out.append(key);
+        out.append(value);
+        out.append(group);
+        const uint32_t crc = crc32(out.data() + start + sizeof(uint32_t), out.size() - start - sizeof(uint32_t));
+        std::memcpy(out.data() + start, &crc, sizeof(crc));
+    }
+
+    void writeAll(int fd, const std::string& data) {
+        const char* p = data.data();
+        size_t remaining = data.size();
+        while (remaining > 0) {
+            ssize_t n = ::write(fd, p, remaining);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Cannot write append log '" + options_.file + "': " + std::strerror(errno));
+            }
+            p += n;
+            remaining -= static_cast<size_t>(n);
+        }
+    }
+
+    // Caller holds mutex_.
+    void appendLocked(const std::string& records) {
+        writeAll(fd_, records);
+        size_ += records.size();
+        if (rewriting_) {
+            rewriteBuffer_.append(records);
+        }
+        // Throws before the caller applies the operation, so it is never acknowledged as durable.
+        if (options_.fsync == OpLogFsync::Always && ::fdatasync(fd_) != 0) {
+            throw std::runtime_error("Cannot sync append log '" + options_.file + "': " + std::strerror(errno));
+        }
+    }
+
+    // Drops a rewrite that did not complete; the current log is left untouched.
+    static void discardRewrite(int fd, const std::string& tmpFile) {
+        ::close(fd);
+        std::error_code ec;
+        std::filesystem::remove(tmpFile, ec);
+    }
+
+    // Applies the log to the engine. A torn or corrupt tail (crash while appending)
+    // is cut off; everything before it is kept.
+    void replay() {
+        const int fd = ::open(options_.file.c_str(), O_RDWR);
+        if (fd < 0) {
+            LOG_INFO("RamOpLog", "No append log at " << options_.file << ", starting empty.");
+            return;
+        }
+        struct stat st;
+        ::fstat(fd, &st);
+        const size_t fileSize = static_cast<size_t>(st.st_size);
+        if (fileSize == 0) {
+            ::close(fd);
+            return;
+        }
+        void* map = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map append log '" + options_.file + "': " + std::strerror(errno));
+        }
+        ::madvise(map, fileSize, MADV_SEQUENTIAL);
+
+        const auto start = std::chrono::steady_clock::now();
+        const char* data = static_cast<const char*>(map);
+        const int64_t now = nowMs();
+        std::vector<BatchEntry> pending;
+        auto flush = [&] {
+            engine_.putBatch(pending);
+            pending.clear();
+        };
+
+        size_t pos = 0;
+        uint64_t records = 0;
+        while (fileSize - pos >= kHeaderSize) {
+            uint32_t head[2];
+            int64_t expireAtMs;
+            uint32_t lengths[3];
+            std::memcpy(head, data + pos, sizeof(head));
+            std::memcpy(&expireAtMs, data + pos + sizeof(head), sizeof(expireAtMs));
+            std::memcpy(lengths, data + pos + sizeof(head) + sizeof(expireAtMs), sizeof(lengths));
+            const size_t recordSize = kHeaderSize + size_t(lengths[0]) + lengths[1] + lengths[2];
+            if (recordSize > fileSize - pos ||
+                crc32(data + pos + sizeof(uint32_t), recordSize - sizeof(uint32_t)) != head[0]) {
+                break;
+            }
+            const char* p = data + pos + kHeaderSize;
+            std::string key(p, lengths[0]);
+            std::string group(p + lengths[0] + lengths[1], lengths[2]);
+
+            if (head[1] == kOpSet && (expireAtMs == 0 || expireAtMs > now)) {
+                const int ttlSeconds = expireAtMs == 0 ? 0 : static_cast<int>((expireAtMs - now + 999) / 1000);
+                pending.push_back({ std::move(key), std::string(p + lengths[0], lengths[1]), std::move(group), ttlSeconds });
+                if (pending.size() >= 10000) {
+                    flush();
+                }
+            } else {
+                // Deletes (and SETs that have expired by now) must see all earlier SETs.
+                flush();
+                if (head[1] == kOpDeleteGroup) {
+                    engine_.eraseGroup(group);
+                } else {
+                    engine_.erase(key);
+                }
+            }
+            pos += recordSize;
+            ++records;
+        }
+        flush();
+        ::munmap(map, fileSize);
+
+        if (pos < fileSize) {
+            LOG_ERROR("RamOpLog", "Append log " << options_.file << " has a torn or corrupt tail at offset " << pos
+                      << "; dropping " << (fileSize - pos) << " bytes.");
+            if (::ftruncate(fd, static_cast<off_t>(pos)) != 0) {
+                LOG_ERROR("RamOpLog", "Cannot truncate " << options_.file << ": " << std::strerror(errno));
+            }
+        }
+        ::close(fd);
+        size_ = pos;
+        LOG_INFO("RamOpLog", "Replayed " << records << " operations from " << options_.file << " in "
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms.");
+    }
+
+    bool rewriteDue() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_ >= options_.rewriteMinBytes &&
+               size_ >= lastRewriteSize_ + lastRewriteSize_ * static_cast<uint64_t>(options_.rewriteGrowthPercent) / 100;
+    }
+
+    void syncDirectory() {
+        std::filesystem::path dir = std::filesystem::path(options_.file).parent_path();
+        if (dir.empty()) {
+            dir = ".";
+        }
+        const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    // ------------------------------
+    // Background Thread: Periodic fsync and Log Rewriting
+    // ------------------------------
+    void backgroundLoop() {
+        const std::chrono::seconds interval(1);
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(threadMutex_);
+                if (cv_.wait_for(lock, interval, [this] { return stopThread_; })) {
+                    break;
+                }
+            }
+            if (options_.fsync == OpLogFsync::EverySecond) {
+                int fd;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    fd = ::dup(fd_);
+                }
+                // fsync outside the lock so writers are not blocked meanwhile.
+                if (fd >= 0) {
+                    ::fdatasync(fd);
+                    ::close(fd);
+                }
+            }
+            if (rewriteDue()) {
+                try {
+                    rewrite();
+                } catch (const std::exception& ex) {
+                    LOG_ERROR("RamOpLog", "Rewrite failed: " << ex.what());
+                }
+            }
+        }
+    }
+};
+
+#endif // RAMOPLOG_H
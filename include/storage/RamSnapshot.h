@@ -0,0 +1,127 @@
+#ifndef RAMSNAPSHOT_H
+#define RAMSNAPSHOT_H
+
+#include "storage/RamEngine.h"
+#include "storage/DumpFile.h"
+#include "eventbus/EventBus.h"  // ThreadPool
+#include <iostream>
+#include <string>
+#include <vector>
+#include <future>
+#include <filesystem>
+#include <stdexcept>
+#include <cmath>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// Settings for RAM snapshots (optional "ram.snapshot" section of the config).
+struct RamSnapshotOptions {
+    bool enabled = false;
+    std::string file = "ram_snapshot.acmdump";
+    // Seconds between periodic snapshots; 0 = only on shutdown.
+    int intervalSeconds = 300;
+    // Threads that decode the snapshot at startup.
+    size_t loadThreads = 4;
+};
+
+// ------------------------------
+// RamSnapshot Class
+// ------------------------------
+// Saves the RamEngine into a dump file (see DumpFile.h) and loads it back at startup.
+class RamSnapshot {
+public:
+    // Writes a point-in-time copy to "<file>.tmp" and renames it over file, so a crash
+    // while saving leaves the previous snapshot intact. Returns the number of entries.
+    static uint64_t save(RamEngine& engine, const std::string& file) {
+        const std::vector<BatchEntry> entries = engine.snapshot();
+        const std::string tmpFile = file + ".tmp";
+        {
+            DumpWriter writer(tmpFile);
+            for (const auto& entry : entries) {
+                writer.write(entry, false);
+            }
+            writer.finish();
+        }
+        std::filesystem::rename(tmpFile, file);
+        syncDirectory(file);
+        return entries.size();
+    }
+
+    // Maps file, decodes its ranges in parallel and inserts them in file order, so
+    // the restored entries keep their relative age. TTLs are shortened by the age of the
+    // snapshot; entries that expired in the meantime are dropped. Throws on a corrupt snapshot.
+    static uint64_t load(RamEngine& engine, const std::string& file, size_t threads) {
+        const double age = secondsSinceModified(file);
+        DumpView view(file);
+        const auto ranges = view.split(std::max<size_t>(1, threads) * 4);
+        if (ranges.empty()) {
+            return 0;
+        }
+
+        ThreadPool pool(std::min(std::max<size_t>(1, threads), ranges.size()));
+        std::vector<std::future<std::vector<BatchEntry>>> futures;
+        futures.reserve(ranges.size());
+        for (const auto& [begin, end] : ranges) {
+            futures.push_back(pool.enqueue([&view, age, begin = begin, end = end] {
+                std::vector<BatchEntry> part;
+                view.decode(begin, end, part);
+                std::erase_if(part, [age](BatchEntry& entry) {
+                    if (entry.ttlSeconds <= 0) {
+                        return false;
+                    }
+                    const double remaining = entry.ttlSeconds - age;
+                    entry.ttlSeconds = static_cast<int>(std::ceil(remaining));
+                    return remaining <= 0;
+                });
+                return part;
+            }));
+        }
+        // Wait for every range before get() may rethrow; the tasks reference view.
+        for (auto& future : futures) {
+            future.wait();
+        }
+        uint64_t loaded = 0;
+        for (auto& future : futures) {
+            const std::vector<BatchEntry> part = future.get();
+            engine.putBatch(part);
+            loaded += part.size();
+        }
+        return loaded;
+    }
+
+private:
+    // The snapshot is written in one go, so its modification time is the time it was taken.
+    static double secondsSinceModified(const std::string& file) {
+        struct stat st;
+        struct timespec now;
+        if (::stat(file.c_str(), &st) != 0 || ::clock_gettime(CLOCK_REALTIME, &now) != 0) {
+            return 0;
+        }
+        const double age = double(now.tv_sec - st.st_mtim.tv_sec) + double(now.tv_nsec - st.st_mtim.tv_nsec) / 1e9;
+        return age > 0 ? age : 0;
+    }
+
+    // Makes the rename durable.
+    static void syncDirectory(const std::string& file) {
+        std::filesystem::path dir = std::filesystem::path(file).parent_path();
+        if (dir.empty()) {
+            dir = ".";
+        }
+        const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+};
+
+#endif // RAMSNAPSHOT_H
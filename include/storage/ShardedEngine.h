@@ -0,0 +1,244 @@
+#ifndef SHARDEDENGINE_H
+#define SHARDEDENGINE_H
+
+#include "storage/StorageEngine.h"
+#include "eventbus/EventBus.h"  // ThreadPool
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <algorithm>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+/*
+  ShardedEngine splits the keyspace across several independent engines (e.g. one
+  SQLite file per shard, each with its own connection and writer lock). Single-key
+  operations go to the shard selected by a stable hash of the key; group queries
+  and deletes run on all shards in parallel and the results are merged.
+
+  The shard of a key depends on the shard count, so an existing store must always
+  be reopened with the same number of shards.
+*/
+class ShardedEngine : public StorageEngine {
+public:
+    explicit ShardedEngine(std::vector<std::unique_ptr<StorageEngine>> shards)
+        : shards_(std::move(shards))
+        , pool_(shards_.size())
+    {
+        if (shards_.empty()) {
+            throw std::invalid_argument("ShardedEngine needs at least one shard.");
+        }
+        LOG_INFO("ShardedEngine", "Initialized with " << shards_.size() << " " << shards_.front()->name() << " shards.");
+    }
+
+    const char* name() const override { return "sharded"; }
+
+    size_t shardCount() const { return shards_.size(); }
+
+    // Index of the shard responsible for key.
+    size_t shardOf(const std::string& key) const {
+        // FNV-1a; placement is persisted, so the hash must be stable across processes.
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return static_cast<size_t>(h % shards_.size());
+    }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int ttlSeconds) override {
+        shards_[shardOf(key)]->put(key, value, group, ttlSeconds);
+    }
+
+    // Splits the batch by shard and writes the parts in parallel.
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::vector<std::vector<BatchEntry>> parts(shards_.size());
+        for (const auto& entry : entries) {
+            parts[shardOf(entry.key)].push_back(entry);
+        }
+        std::vector<std::future<void>> futures;
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            if (!parts[i].empty()) {
+                StorageEngine* engine = shards_[i].get();
+                const std::vector<BatchEntry>* part = &parts[i];
+                futures.push_back(pool_.enqueue([engine, part] { engine->putBatch(*part); }));
+            }
+        }
+        for (auto& future : futures) {
+            future.wait();
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        return shards_[shardOf(key)]->get(key, value);
+    }
+
+    // Splits the keys by shard, looks the parts up in parallel and restores the request order.
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        std::vector<std::vector<std::string>> parts(shards_.size());
+        std::vector<std::vector<size_t>> positions(shards_.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const size_t shard = shardOf(keys[i]);
+            parts[shard].push_back(keys[i]);
+            positions[shard].push_back(i);
+        }
+        const auto values = perShard(parts, [](StorageEngine& shard, const std::vector<std::string>& part) {
+            return shard.getBatch(part);
+        });
+        std::vector<std::optional<std::string>> result(keys.size());
+        for (size_t shard = 0; shard < shards_.size(); ++shard) {
+            for (size_t j = 0; j < values[shard].size(); ++j) {
+                result[positions[shard][j]] = std::move(values[shard][j]);
+            }
+        }
+        return result;
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        std::vector<KeyValue> result;
+        for (auto& part : fanOut([&group](StorageEngine& shard) { return shard.getGroup(group); })) {
+            result.insert(result.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        }
+        return result;
+    }
+
+    int erase(const std::string& key) override {
+        return shards_[shardOf(key)]->erase(key);
+    }
+
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::vector<std::vector<std::string>> parts(shards_.size());
+        for (const auto& key : keys) {
+            parts[shardOf(key)].push_back(key);
+        }
+        int count = 0;
+        for (int removed : perShard(parts, [](StorageEngine& shard, const std::vector<std::string>& part) {
+                 return shard.eraseBatch(part);
+             })) {
+            count += removed;
+        }
+        return count;
+    }
+
+    int eraseGroup(const std::string& group) override {
+        int count = 0;
+        for (int removed : fanOut([&group](StorageEngine& shard) { return shard.eraseGroup(group); })) {
+            count += removed;
+        }
+        return count;
+    }
+
+    // Visits the shards one after another so fn is never called concurrently.
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        for (auto& shard : shards_) {
+            shard->forEach(fn);
+        }
+    }
+
+    // Scans every shard in parallel and merges the sorted chunks.
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        std::vector<StorageEntry> merged;
+        for (auto& part : fanOut([&from, limit, &end](StorageEngine& shard) { return shard.scan(from, limit, end); })) {
+            std::vector<StorageEntry> next;
+            next.reserve(std::min(limit, merged.size() + part.size()));
+            auto a = merged.begin();
+            auto b = part.begin();
+            while (next.size() < limit && (a != merged.end() || b != part.end())) {
+                if (b == part.end() || (a != merged.end() && a->key < b->key)) {
+                    next.push_back(std::move(*a++));
+                } else {
+                    next.push_back(std::move(*b++));
+                }
+            }
+            merged.swap(next);
+        }
+        return merged;
+    }
+
+    StorageStats stats() override {
+        StorageStats result;
+        for (const StorageStats& part : fanOut([](StorageEngine& shard) { return shard.stats(); })) {
+            result.entries += part.entries;
+            result.bytes += part.bytes;
+        }
+        return result;
+    }
+
+    // Lets every shard take one step; each shard only blocks its own requests meanwhile.
+    uint64_t compactStep(uint64_t maxBytes) override {
+        uint64_t reclaimed = 0;
+        for (auto& shard : shards_) {
+            reclaimed += shard->compactStep(maxBytes);
+        }
+        return reclaimed;
+    }
+
+private:
+    std::vector<std::unique_ptr<StorageEngine>> shards_;
+    // One worker per shard, so a fan-out never waits for a free thread.
+    ThreadPool pool_;
+
+    // Runs fn on every shard in parallel and returns the per-shard results in shard order.
+    template <typename Fn>
+    auto fanOut(Fn fn) -> std::vector<decltype(fn(std::declval<StorageEngine&>()))> {
+        using Result = decltype(fn(std::declval<StorageEngine&>()));
+        std::vector<std::future<Result>> futures;
+        futures.reserve(shards_.size());
+        for (auto& shard : shards_) {
+            StorageEngine* engine = shard.get();
+            futures.push_back(pool_.enqueue([fn, engine] { return fn(*engine); }));
+        }
+        // Wait for every shard before get() may rethrow; the tasks reference the caller's arguments.
+        for (auto& future : futures) {
+            future.wait();
+        }
+        std::vector<Result> results;
+        results.reserve(futures.size());
+        for (auto& future : futures) {
+            results.push_back(future.get());
+        }
+        return results;
+    }
+
+    // Runs fn(shard, parts[shard]) in parallel for every shard with a non-empty part;
+    // shards without a part get a default-constructed result.
+    template <typename Part, typename Fn>
+    auto perShard(const std::vector<Part>& parts, Fn fn)
+        -> std::vector<decltype(fn(std::declval<StorageEngine&>(), parts.front()))> {
+        using Result = decltype(fn(std::declval<StorageEngine&>(), parts.front()));
+        std::vector<std::future<Result>> futures(shards_.size());
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            if (!parts[i].empty()) {
+                StorageEngine* engine = shards_[i].get();
+                const Part* part = &parts[i];
+                futures[i] = pool_.enqueue([fn, engine, part] { return fn(*engine, *part); });
+            }
+        }
+        for (auto& future : futures) {
+            if (future.valid()) {
+                future.wait();
+            }
+        }
+        std::vector<Result> results(shards_.size());
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            if (futures[i].valid()) {
+                results[i] = futures[i].get();
+            }
+        }
+        return results;
+    }
+};
+
+#endif // SHARDEDENGINE_H
@@ -0,0 +1,426 @@
+#ifndef SQLITEENGINE_H
+#define SQLITEENGINE_H
+
+#include "storage/StorageEngine.h"
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <sqlite3.h>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// ------------------------------
+// RAII Helper Class for SQLite Statements
+// ------------------------------
+class SQLiteStmt {
+public:
+    SQLiteStmt(sqlite3* db, const char* sql)
+        : db_(db), stmt_(nullptr)
+    {
+        int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt_, nullptr);
+        if (rc != SQLITE_OK) {
+            throw std::runtime_error(std::string("SQLite prepare error: ") + sqlite3_errmsg(db_));
+        }
+    }
+
+    ~SQLiteStmt() {
+        if (stmt_) {
+            sqlite3_finalize(stmt_);
+        }
+    }
+
+    sqlite3_stmt* get() const { return stmt_; }
+
+    // Optional method to reset the statement.
+    void reset() {
+        if (stmt_) {
+            sqlite3_reset(stmt_);
+        }
+    }
+
+private:
+    sqlite3* db_;
+    sqlite3_stmt* stmt_;
+};
+
+// ------------------------------
+// SqliteEngine Class
+// ------------------------------
+// Stores all entries in a single SQLite table; one connection guarded by a mutex.
+class SqliteEngine : public StorageEngine {
+public:
+    // Opens (or creates, if it does not exist) the SQLite database. New databases use incremental
+    // auto_vacuum; an existing one without it is only converted if convertToIncrementalVacuum is set,
+    // because the conversion is a full VACUUM that blocks until the whole file has been rewritten.
+    explicit SqliteEngine(const std::string& dbFile, bool convertToIncrementalVacuum = false) {
+        int rc = sqlite3_open(dbFile.c_str(), &db_);
+        if (rc != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "Unable to open database: " << sqlite3_errmsg(db_));
+            sqlite3_close(db_);
+            db_ = nullptr;
+            throw std::runtime_error("Error opening SQLite database.");
+        }
+
+        enableIncrementalVacuum(convertToIncrementalVacuum);
+
+        // Create the table if it does not exist.
+        const char* createTableSQL = "CREATE TABLE IF NOT EXISTS store ("
+                                     "key TEXT PRIMARY KEY, "
+                                     "value TEXT, "
+                                     "group_name TEXT"
+                                     ");";
+        char* errMsg = nullptr;
+        rc = sqlite3_exec(db_, createTableSQL, nullptr, nullptr, &errMsg);
+        if (rc != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "SQL error while creating table: " << errMsg);
+            sqlite3_free(errMsg);
+            sqlite3_close(db_);
+            db_ = nullptr;
+            throw std::runtime_error("Error creating table in SQLite database.");
+        }
+    }
+
+    ~SqliteEngine() override {
+        if (db_) {
+            sqlite3_close(db_);
+            LOG_INFO("SqliteEngine", "Database connection closed.");
+        }
+    }
+
+    const char* name() const override { return "sqlite"; }
+
+    void put(const std::string& key, const std::string& value, const std::string& group, int /*ttlSeconds*/) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        char* errMsg = nullptr;
+        int rc = sqlite3_exec(db_, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg);
+        if (rc != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "Error starting transaction: " << errMsg);
+            sqlite3_free(errMsg);
+            throw std::runtime_error("SQLite transaction BEGIN error in SET.");
+        }
+
+        try {
+            SQLiteStmt stmt(db_, "INSERT OR REPLACE INTO store (key, value, group_name) VALUES (?, ?, ?);");
+            sqlite3_bind_text(stmt.get(), 1, key.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt.get(), 2, value.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt.get(), 3, group.c_str(), -1, SQLITE_TRANSIENT);
+
+            rc = sqlite3_step(stmt.get());
+            if (rc != SQLITE_DONE) {
+                LOG_ERROR("SqliteEngine", "Error executing statement: " << sqlite3_errmsg(db_));
+                throw std::runtime_error("SQLite step error in SET.");
+            }
+            // Commit the transaction.
+            rc = sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, &errMsg);
+            if (rc != SQLITE_OK) {
+                LOG_ERROR("SqliteEngine", "Error committing transaction: " << errMsg);
+                sqlite3_free(errMsg);
+                throw std::runtime_error("SQLite transaction COMMIT error in SET.");
+            }
+        }
+        catch (const std::exception& e) {
+            // Roll back the transaction upon error.
+            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+            LOG_ERROR("SqliteEngine", "Transaction rolled back due to error: " << e.what());
+            throw; // Rethrow the exception.
+        }
+    }
+
+    // Writes the whole batch in a single transaction with one prepared statement.
+    void putBatch(const std::vector<BatchEntry>& entries) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        char* errMsg = nullptr;
+        int rc = sqlite3_exec(db_, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg);
+        if (rc != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "Error starting transaction: " << errMsg);
+            sqlite3_free(errMsg);
+            throw std::runtime_error("SQLite transaction BEGIN error in batch SET.");
+        }
+
+        try {
+            SQLiteStmt stmt(db_, "INSERT OR REPLACE INTO store (key, value, group_name) VALUES (?, ?, ?);");
+            for (const auto& entry : entries) {
+                sqlite3_bind_text(stmt.get(), 1, entry.key.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(stmt.get(), 2, entry.value.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(stmt.get(), 3, entry.group.c_str(), -1, SQLITE_TRANSIENT);
+                if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+                    LOG_ERROR("SqliteEngine", "Error executing statement: " << sqlite3_errmsg(db_));
+                    throw std::runtime_error("SQLite step error in batch SET.");
+                }
+                stmt.reset();
+            }
+            rc = sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, &errMsg);
+            if (rc != SQLITE_OK) {
+                LOG_ERROR("SqliteEngine", "Error committing transaction: " << errMsg);
+                sqlite3_free(errMsg);
+                throw std::runtime_error("SQLite transaction COMMIT error in batch SET.");
+            }
+        }
+        catch (const std::exception& e) {
+            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+            LOG_ERROR("SqliteEngine", "Transaction rolled back due to error: " << e.what());
+            throw;
+        }
+    }
+
+    bool get(const std::string& key, std::string& value) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SQLiteStmt stmt(db_, "SELECT value FROM store WHERE key = ?;");
+        sqlite3_bind_text(stmt.get(), 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        int rc = sqlite3_step(stmt.get());
+        if (rc == SQLITE_ROW) {
+            const unsigned char* text = sqlite3_column_text(stmt.get(), 0);
+            value = text ? reinterpret_cast<const char*>(text) : "";
+            return true;
+        } else if (rc == SQLITE_DONE) {
+            return false;
+        }
+        LOG_ERROR("SqliteEngine", "Error retrieving value: " << sqlite3_errmsg(db_));
+        throw std::runtime_error("SQLite step error in GET KEY.");
+    }
+
+    // Reads the whole batch in one transaction with one prepared statement, so all
+    // values come from the same snapshot.
+    std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::optional<std::string>> result(keys.size());
+        runTransaction("batch GET", [&] {
+            SQLiteStmt stmt(db_, "SELECT value FROM store WHERE key = ?;");
+            for (size_t i = 0; i < keys.size(); ++i) {
+                sqlite3_bind_text(stmt.get(), 1, keys[i].c_str(), -1, SQLITE_TRANSIENT);
+                int rc = sqlite3_step(stmt.get());
+                if (rc == SQLITE_ROW) {
+                    result[i] = columnText(stmt.get(), 0);
+                } else if (rc != SQLITE_DONE) {
+                    LOG_ERROR("SqliteEngine", "Error retrieving value: " << sqlite3_errmsg(db_));
+                    throw std::runtime_error("SQLite step error in batch GET.");
+                }
+                stmt.reset();
+            }
+        });
+        return result;
+    }
+
+    std::vector<KeyValue> getGroup(const std::string& group) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SQLiteStmt stmt(db_, "SELECT key, value FROM store WHERE group_name = ?;");
+        sqlite3_bind_text(stmt.get(), 1, group.c_str(), -1, SQLITE_TRANSIENT);
+
+        std::vector<KeyValue> result;
+        while (true) {
+            int rc = sqlite3_step(stmt.get());
+            if (rc == SQLITE_ROW) {
+                const unsigned char* keyText = sqlite3_column_text(stmt.get(), 0);
+                const unsigned char* valueText = sqlite3_column_text(stmt.get(), 1);
+                std::string key = keyText ? reinterpret_cast<const char*>(keyText) : "";
+                std::string value = valueText ? reinterpret_cast<const char*>(valueText) : "";
+                result.push_back({ key, value });
+            } else if (rc == SQLITE_DONE) {
+                break;
+            } else {
+                LOG_ERROR("SqliteEngine", "Error retrieving group: " << sqlite3_errmsg(db_));
+                throw std::runtime_error("SQLite step error in GET GROUP.");
+            }
+        }
+        return result;
+    }
+
+    int erase(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SQLiteStmt stmt(db_, "DELETE FROM store WHERE key = ?;");
+        sqlite3_bind_text(stmt.get(), 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        int rc = sqlite3_step(stmt.get());
+        if (rc != SQLITE_DONE) {
+            LOG_ERROR("SqliteEngine", "Error executing DELETE: " << sqlite3_errmsg(db_));
+            throw std::runtime_error("SQLite step error in DELETE KEY.");
+        }
+        return (sqlite3_changes(db_) > 0) ? 1 : 0;
+    }
+
+    // Deletes the whole batch in a single transaction.
+    int eraseBatch(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int count = 0;
+        runTransaction("batch DELETE", [&] {
+            SQLiteStmt stmt(db_, "DELETE FROM store WHERE key = ?;");
+            for (const auto& key : keys) {
+                sqlite3_bind_text(stmt.get(), 1, key.c_str(), -1, SQLITE_TRANSIENT);
+                if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+                    LOG_ERROR("SqliteEngine", "Error executing DELETE: " << sqlite3_errmsg(db_));
+                    throw std::runtime_error("SQLite step error in batch DELETE.");
+                }
+                count += sqlite3_changes(db_) > 0 ? 1 : 0;
+                stmt.reset();
+            }
+        });
+        return count;
+    }
+
+    int eraseGroup(const std::string& group) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SQLiteStmt stmt(db_, "DELETE FROM store WHERE group_name = ?;");
+        sqlite3_bind_text(stmt.get(), 1, group.c_str(), -1, SQLITE_TRANSIENT);
+        int rc = sqlite3_step(stmt.get());
+        if (rc != SQLITE_DONE) {
+            LOG_ERROR("SqliteEngine", "Error executing DELETE GROUP: " << sqlite3_errmsg(db_));
+            throw std::runtime_error("SQLite step error in DELETE GROUP.");
+        }
+        return sqlite3_changes(db_);
+    }
+
+    void forEach(const std::function<void(const StorageEntry&)>& fn) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SQLiteStmt stmt(db_, "SELECT key, value, group_name FROM store;");
+        StorageEntry entry;
+        while (true) {
+            int rc = sqlite3_step(stmt.get());
+            if (rc == SQLITE_ROW) {
+                entry.key = columnText(stmt.get(), 0);
+                entry.value = columnText(stmt.get(), 1);
+                entry.group = columnText(stmt.get(), 2);
+                fn(entry);
+            } else if (rc == SQLITE_DONE) {
+                break;
+            } else {
+                LOG_ERROR("SqliteEngine", "Error iterating store: " << sqlite3_errmsg(db_));
+                throw std::runtime_error("SQLite step error in LIST.");
+            }
+        }
+    }
+
+    // Range scan over the primary key index.
+    std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SQLiteStmt stmt(db_, end.empty()
+            ? "SELECT key, value, group_name FROM store WHERE key >= ?1 ORDER BY key LIMIT ?2;"
+            : "SELECT key, value, group_name FROM store WHERE key >= ?1 AND key < ?3 ORDER BY key LIMIT ?2;");
+        sqlite3_bind_text(stmt.get(), 1, from.c_str(), static_cast<int>(from.size()), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt.get(), 2, static_cast<sqlite3_int64>(limit));
+        if (!end.empty()) {
+            sqlite3_bind_text(stmt.get(), 3, end.c_str(), static_cast<int>(end.size()), SQLITE_TRANSIENT);
+        }
+
+        std::vector<StorageEntry> result;
+        while (true) {
+            int rc = sqlite3_step(stmt.get());
+            if (rc == SQLITE_ROW) {
+                result.push_back({ columnText(stmt.get(), 0), columnText(stmt.get(), 1), columnText(stmt.get(), 2) });
+            } else if (rc == SQLITE_DONE) {
+                break;
+            } else {
+                LOG_ERROR("SqliteEngine", "Error scanning store: " << sqlite3_errmsg(db_));
+                throw std::runtime_error("SQLite step error in LIST.");
+            }
+        }
+        return result;
+    }
+
+    StorageStats stats() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        StorageStats result;
+        SQLiteStmt count(db_, "SELECT COUNT(*) FROM store;");
+        if (sqlite3_step(count.get()) == SQLITE_ROW) {
+            result.entries = static_cast<uint64_t>(sqlite3_column_int64(count.get(), 0));
+        }
+        result.bytes = static_cast<uint64_t>(pragmaValue("page_count") * pragmaValue("page_size"));
+        return result;
+    }
+
+    // Returns up to maxBytes worth of free pages to the file system (PRAGMA incremental_vacuum).
+    uint64_t compactStep(uint64_t maxBytes) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const int64_t pageSize = pragmaValue("page_size");
+        const int64_t freeBefore = pragmaValue("freelist_count");
+        if (freeBefore == 0 || pageSize <= 0) {
+            return 0;
+        }
+        const int64_t pages = std::max<int64_t>(1, static_cast<int64_t>(maxBytes) / pageSize);
+        char* errMsg = nullptr;
+        const std::string sql = "PRAGMA incremental_vacuum(" + std::to_string(pages) + ");";
+        if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "Incremental vacuum failed: " << errMsg);
+            sqlite3_free(errMsg);
+            return 0;
+        }
+        const int64_t freed = freeBefore - pragmaValue("freelist_count");
+        return static_cast<uint64_t>(std::max<int64_t>(0, freed) * pageSize);
+    }
+
+private:
+    // Runs body between BEGIN and COMMIT; rolls back and rethrows if it fails.
+    // The caller holds mutex_.
+    template <typename Body>
+    void runTransaction(const char* what, Body body) {
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db_, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "Error starting transaction: " << errMsg);
+            sqlite3_free(errMsg);
+            throw std::runtime_error(std::string("SQLite transaction BEGIN error in ") + what + ".");
+        }
+        try {
+            body();
+            if (sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+                LOG_ERROR("SqliteEngine", "Error committing transaction: " << errMsg);
+                sqlite3_free(errMsg);
+                throw std::runtime_error(std::string("SQLite transaction COMMIT error in ") + what + ".");
+            }
+        }
+        catch (const std::exception& e) {
+            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+            LOG_ERROR("SqliteEngine", "Transaction rolled back due to error: " << e.what());
+            throw;
+        }
+    }
+
+    // Free pages are only returned to the file system with auto_vacuum=INCREMENTAL. An empty database
+    // takes the mode directly; an existing one only through a full VACUUM, which is done on request.
+    void enableIncrementalVacuum(bool convertExisting) {
+        constexpr int64_t kIncremental = 2;
+        if (pragmaValue("auto_vacuum") == kIncremental) {
+            return;
+        }
+        const bool existing = pragmaValue("page_count") > 0;
+        if (existing && !convertExisting) {
+            LOG_INFO("SqliteEngine", "Database was created without incremental auto_vacuum; free pages stay in the file "
+                     "until it is converted (disk.compaction.convertExisting).");
+            return;
+        }
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db_, "PRAGMA auto_vacuum = INCREMENTAL;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            LOG_ERROR("SqliteEngine", "Unable to enable incremental auto_vacuum: " << errMsg);
+            sqlite3_free(errMsg);
+            return;
+        }
+        if (existing) {
+            LOG_INFO("SqliteEngine", "Converting existing database to incremental auto_vacuum (one-time VACUUM).");
+            if (sqlite3_exec(db_, "VACUUM;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+                LOG_ERROR("SqliteEngine", "VACUUM failed: " << errMsg);
+                sqlite3_free(errMsg);
+            }
+        }
+    }
+
+    static std::string columnText(sqlite3_stmt* stmt, int column) {
+        const unsigned char* text = sqlite3_column_text(stmt, column);
+        return text ? reinterpret_cast<const char*>(text) : "";
+    }
+
+    // Reads a single integer PRAGMA. Caller holds mutex_ (or is the constructor).
+    int64_t pragmaValue(const std::string& pragma) {
+        SQLiteStmt stmt(db_, ("PRAGMA " + pragma + ";").c_str());
+        return sqlite3_step(stmt.get()) == SQLITE_ROW ? sqlite3_column_int64(stmt.get(), 0) : 0;
+    }
+
+    sqlite3* db_ = nullptr;
+    std::mutex mutex_;
+};
+
+#endif // SQLITEENGINE_H
@@ -0,0 +1,146 @@
+#ifndef STORAGEENGINE_H
+#define STORAGEENGINE_H
+
+#include "storage/Message.h"  // KeyValue, StorageEntry
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <vector>
+
+// Counters every engine reports through StorageEngine::stats().
+struct StorageStats {
+    // Number of live entries (the LSM engine reports an upper bound that includes shadowed versions).
+    uint64_t entries = 0;
+    // Bytes held by the engine (memory for RAM, files for persistent engines).
+    uint64_t bytes = 0;
+};
+
+// Entry of a bulk write (StorageEngine::putBatch).
+struct BatchEntry {
+    std::string key;
+    std::string value;
+    std::string group;
+    // <= 0 means no expiry.
+    int ttlSeconds = 0;
+};
+
+// ------------------------------
+// StorageEngine Interface
+// ------------------------------
+// Key-value backend behind the RamHandler and the DiskHandler. Implementations
+// must be safe to call from several EventBus worker threads at once.
+class StorageEngine {
+public:
+    virtual ~StorageEngine() = default;
+
+    // Short name used in logs and benchmarks.
+    virtual const char* name() const = 0;
+
+    // Inserts or overwrites the entry for key. ttlSeconds <= 0 means no expiry;
+    // persistent engines keep entries until they are deleted and ignore it.
+    virtual void put(const std::string& key, const std::string& value, const std::string& group, int ttlSeconds) = 0;
+
+    // Inserts or overwrites many entries at once. Engines override this to use one
+    // transaction / one lock acquisition / one fsync for the whole batch.
+    virtual void putBatch(const std::vector<BatchEntry>& entries) {
+        for (const auto& entry : entries) {
+            put(entry.key, entry.value, entry.group, entry.ttlSeconds);
+        }
+    }
+
+    // Returns true and fills value if the key exists.
+    virtual bool get(const std::string& key, std::string& value) = 0;
+
+    // Returns all key-value pairs belonging to the group.
+    virtual std::vector<KeyValue> getGroup(const std::string& group) = 0;
+
+    // Looks up many keys at once; result[i] is empty if keys[i] does not exist. Engines
+    // override this to take their lock / open their read transaction once per batch.
+    virtual std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys) {
+        std::vector<std::optional<std::string>> result(keys.size());
+        std::string value;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (get(keys[i], value)) {
+                result[i] = value;
+            }
+        }
+        return result;
+    }
+
+    // Removes the key; returns the number of removed entries (0 or 1).
+    virtual int erase(const std::string& key) = 0;
+
+    // Removes many keys at once; returns the number of removed entries. Like putBatch,
+    // engines override this to use one transaction / lock acquisition / sync per batch.
+    virtual int eraseBatch(const std::vector<std::string>& keys) {
+        int count = 0;
+        for (const auto& key : keys) {
+            count += erase(key);
+        }
+        return count;
+    }
+
+    // Removes all keys of the group; returns the number of removed entries.
+    virtual int eraseGroup(const std::string& group) = 0;
+
+    // Calls fn for every live entry. fn runs under the engine's lock and must not call back into the engine.
+    virtual void forEach(const std::function<void(const StorageEntry&)>& fn) = 0;
+
+    virtual StorageStats stats() = 0;
+
+    // One chunk of an incremental scan in key order: up to limit entries with
+    // from <= key < end ("" for from / end means unbounded). A chunk shorter than limit
+    // ends the scan; the next chunk starts at scanSuccessor() of the last key. All engines
+    // in this tree override it with an ordered walk that touches about limit entries. The
+    // default is only a fallback for engines without key order: it visits every entry per
+    // chunk under the engine's lock (O(N) per chunk) and keeps the limit smallest keys.
+    virtual std::vector<StorageEntry> scan(const std::string& from, size_t limit, const std::string& end = "") {
+        if (limit == 0) {
+            return {};
+        }
+        auto byKey = [](const StorageEntry& a, const StorageEntry& b) { return a.key < b.key; };
+        std::priority_queue<StorageEntry, std::vector<StorageEntry>, decltype(byKey)> smallest(byKey);
+        forEach([&](const StorageEntry& entry) {
+            if (entry.key < from || (!end.empty() && entry.key >= end)) {
+                return;
+            }
+            if (smallest.size() < limit) {
+                smallest.push(entry);
+            } else if (entry.key < smallest.top().key) {
+                smallest.pop();
+                smallest.push(entry);
+            }
+        });
+        std::vector<StorageEntry> result(smallest.size());
+        for (size_t i = result.size(); i > 0; --i) {
+            result[i - 1] = smallest.top();
+            smallest.pop();
+        }
+        return result;
+    }
+
+    // The smallest key greater than key.
+    static std::string scanSuccessor(const std::string& key) {
+        return key + '\0';
+    }
+
+    // Exclusive upper bound of all keys starting with prefix ("" if there is none).
+    static std::string prefixEnd(std::string prefix) {
+        while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF) {
+            prefix.pop_back();
+        }
+        if (!prefix.empty()) {
+            prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+        }
+        return prefix;
+    }
+
+    // Reclaims up to roughly maxBytes of unused space in one short step and returns the
+    // bytes freed (0 once there is nothing left). Engines that compact on their own
+    // background threads keep this default.
+    virtual uint64_t compactStep(uint64_t /*maxBytes*/) { return 0; }
+};
+
+#endif // STORAGEENGINE_H
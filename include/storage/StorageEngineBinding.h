@@ -0,0 +1,306 @@
+#ifndef STORAGEENGINEBINDING_H
+#define STORAGEENGINEBINDING_H
+
+#include "eventbus/EventBus.h"
+#include "storage/Message.h"
+#include "storage/StorageEngine.h"
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <span>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// ------------------------------
+// StorageEngineBinding Class
+// ------------------------------
+// Subscribes the SET / GET KEY / GET GROUP / DELETE KEY / DELETE GROUP / LIST / SCAN / RANGE events
+// and the batch events MSET / MGET / MDELETE of a
+// storage tier (RamHandler, DiskHandler) and forwards them to its StorageEngine.
+// Key lookups (GET KEY, MGET) are subscribed with lookupMode; a tier whose lookups never
+// block passes DispatchMode::Inline so they run on the sender's thread.
+// SET and GET KEY also get batch callbacks, so EventBus::sendBatch() reaches the engine
+// with one putBatch / getBatch call per batch.
+class StorageEngineBinding {
+public:
+    StorageEngineBinding(EventBus& eventBus, HandlerID id, StorageEngine& engine, const std::string& component,
+                         DispatchMode lookupMode = DispatchMode::Pooled)
+        : eventBus_(eventBus)
+        , id_(id)
+        , engine_(engine)
+        , component_(component)
+    {
+        eventBus.subscribe<SetEventMessage, SetResponseMessage>(id,
+            [this](const SetEventMessage& msg) -> SetResponseMessage {
+                return handleSetEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<GetKeyEventMessage, GetKeyResponseMessage>(id,
+            [this](const GetKeyEventMessage& msg) -> GetKeyResponseMessage {
+                return handleGetKeyEvent(msg);
+            },
+            lookupMode
+        );
+
+        eventBus.subscribeBatch<SetEventMessage, SetResponseMessage>(id,
+            [this](std::span<const SetEventMessage> msgs) -> std::vector<SetResponseMessage> {
+                return handleSetBatch(msgs);
+            }
+        );
+
+        eventBus.subscribeBatch<GetKeyEventMessage, GetKeyResponseMessage>(id,
+            [this](std::span<const GetKeyEventMessage> msgs) -> std::vector<GetKeyResponseMessage> {
+                return handleGetKeyBatch(msgs);
+            }
+        );
+
+        eventBus.subscribe<GetGroupEventMessage, GetGroupResponseMessage>(id,
+            [this](const GetGroupEventMessage& msg) -> GetGroupResponseMessage {
+                return handleGetGroupEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<DeleteKeyEventMessage, DeleteKeyResponseMessage>(id,
+            [this](const DeleteKeyEventMessage& msg) -> DeleteKeyResponseMessage {
+                return handleDeleteKeyEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<DeleteGroupEventMessage, DeleteGroupResponseMessage>(id,
+            [this](const DeleteGroupEventMessage& msg) -> DeleteGroupResponseMessage {
+                return handleDeleteGroupEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<ListEventMessage, ListEventReponseMessage>(id,
+            [this](const ListEventMessage& msg) -> ListEventReponseMessage {
+                return handleListEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<ScanEventMessage, ScanResponseMessage>(id,
+            [this](const ScanEventMessage& msg) -> ScanResponseMessage {
+                return handleScanEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<RangeEventMessage, RangeResponseMessage>(id,
+            [this](const RangeEventMessage& msg) -> RangeResponseMessage {
+                return handleRangeEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<MSetEventMessage, MSetResponseMessage>(id,
+            [this](const MSetEventMessage& msg) -> MSetResponseMessage {
+                return handleMSetEvent(msg);
+            }
+        );
+
+        eventBus.subscribe<MGetEventMessage, MGetResponseMessage>(id,
+            [this](const MGetEventMessage& msg) -> MGetResponseMessage {
+                return handleMGetEvent(msg);
+            },
+            lookupMode
+        );
+
+        eventBus.subscribe<MDeleteEventMessage, MDeleteResponseMessage>(id,
+            [this](const MDeleteEventMessage& msg) -> MDeleteResponseMessage {
+                return handleMDeleteEvent(msg);
+            }
+        );
+    }
+
+    // The callbacks capture this and the engine; drop them before either goes away.
+    ~StorageEngineBinding() {
+        eventBus_.unsubscribeAll(id_);
+    }
+
+    // The subscribed callbacks capture this; the binding must stay where it was constructed.
+    StorageEngineBinding(const StorageEngineBinding&) = delete;
+    StorageEngineBinding& operator=(const StorageEngineBinding&) = delete;
+
+private:
+    EventBus& eventBus_;
+    HandlerID id_;
+    StorageEngine& engine_;
+    std::string component_;
+
+    // Handles a SET event: stores the provided key and value.
+    SetResponseMessage handleSetEvent(const SetEventMessage& msg) {
+        engine_.put(msg.key, msg.value, msg.group, msg.ttl);
+
+        SetResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = true;
+        LOG_INFO(component_, "SET event successful for key: " << msg.key);
+        return resp;
+    }
+
+    // Handles a GET KEY event: returns the value (or an empty string if not found).
+    GetKeyResponseMessage handleGetKeyEvent(const GetKeyEventMessage& msg) {
+        GetKeyResponseMessage resp;
+        resp.id = msg.id;
+        if (engine_.get(msg.key, resp.response)) {
+            LOG_INFO(component_, "GET KEY event: Key '" << msg.key << "' found.");
+        } else {
+            resp.response = "";
+            LOG_INFO(component_, "GET KEY event: Key '" << msg.key << "' not found.");
+        }
+        return resp;
+    }
+
+    // Handles a batch of SET events with one putBatch call (later SETs of a key win).
+    std::vector<SetResponseMessage> handleSetBatch(std::span<const SetEventMessage> msgs) {
+        std::vector<BatchEntry> entries;
+        entries.reserve(msgs.size());
+        for (const auto& msg : msgs) {
+            entries.push_back({ msg.key, msg.value, msg.group, msg.ttl });
+        }
+        engine_.putBatch(entries);
+        LOG_INFO(component_, "SET batch: Stored " << entries.size() << " entries.");
+
+        std::vector<SetResponseMessage> responses(msgs.size());
+        for (size_t i = 0; i < msgs.size(); ++i) {
+            responses[i].id = msgs[i].id;
+            responses[i].response = true;
+        }
+        return responses;
+    }
+
+    // Handles a batch of GET KEY events with one getBatch call.
+    std::vector<GetKeyResponseMessage> handleGetKeyBatch(std::span<const GetKeyEventMessage> msgs) {
+        std::vector<std::string> keys;
+        keys.reserve(msgs.size());
+        for (const auto& msg : msgs) {
+            keys.push_back(msg.key);
+        }
+        std::vector<std::optional<std::string>> values = engine_.getBatch(keys);
+
+        std::vector<GetKeyResponseMessage> responses(msgs.size());
+        for (size_t i = 0; i < msgs.size(); ++i) {
+            responses[i].id = msgs[i].id;
+            if (values[i]) {
+                responses[i].response = std::move(*values[i]);
+            }
+        }
+        return responses;
+    }
+
+    // Handles a GET GROUP event: returns all key-value pairs belonging to the group.
+    GetGroupResponseMessage handleGetGroupEvent(const GetGroupEventMessage& msg) {
+        GetGroupResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = engine_.getGroup(msg.group);
+        LOG_INFO(component_, "GET GROUP event: Returned " << resp.response.size() << " entries for group '" << msg.group << "'.");
+        return resp;
+    }
+
+    // Handles a DELETE KEY event.
+    DeleteKeyResponseMessage handleDeleteKeyEvent(const DeleteKeyEventMessage& msg) {
+        int changes = engine_.erase(msg.key);
+        DeleteKeyResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = (changes > 0) ? 1 : 0;
+        LOG_INFO(component_, "DELETE KEY event: Key '" << msg.key << "' deletion " << ((changes > 0) ? "succeeded." : "failed."));
+        return resp;
+    }
+
+    // Handles a DELETE GROUP event.
+    DeleteGroupResponseMessage handleDeleteGroupEvent(const DeleteGroupEventMessage& msg) {
+        int changes = engine_.eraseGroup(msg.group);
+        DeleteGroupResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = changes;
+        LOG_INFO(component_, "DELETE GROUP event: Removed " << changes << " entries for group '" << msg.group << "'.");
+        return resp;
+    }
+
+    // Handles a LIST event: everything at once (limit == 0) or one key-ordered chunk.
+    ListEventReponseMessage handleListEvent(const ListEventMessage& msg) {
+        ListEventReponseMessage resp;
+        resp.id = msg.id;
+        if (msg.limit == 0) {
+            engine_.forEach([&resp](const StorageEntry& entry) {
+                resp.response.push_back(entry);
+            });
+        } else {
+            resp.response = engine_.scan(msg.after, msg.limit);
+            if (resp.response.size() == msg.limit) {
+                resp.next = StorageEngine::scanSuccessor(resp.response.back().key);
+            }
+        }
+        LOG_INFO(component_, "LIST event: Returned " << resp.response.size() << " entries.");
+        return resp;
+    }
+
+    // Handles one SCAN step on this tier. msg.cursor is a key here ("" = start); the
+    // response cursor is empty once the tier is exhausted.
+    ScanResponseMessage handleScanEvent(const ScanEventMessage& msg) {
+        ScanResponseMessage resp;
+        resp.id = msg.id;
+        // A prefix becomes a key range, so the scan seeks straight to it.
+        const std::string from = std::max(msg.cursor, msg.prefix);
+        const auto chunk = engine_.scan(from, msg.count, StorageEngine::prefixEnd(msg.prefix));
+        for (const auto& entry : chunk) {
+            if (msg.group.empty() || entry.group == msg.group) {
+                resp.response.push_back(entry);
+            }
+        }
+        if (chunk.size() == msg.count) {
+            resp.cursor = StorageEngine::scanSuccessor(chunk.back().key);
+        }
+        return resp;
+    }
+
+    // Handles an MSET event: the whole batch goes to the engine in one putBatch call.
+    MSetResponseMessage handleMSetEvent(const MSetEventMessage& msg) {
+        std::vector<BatchEntry> entries;
+        entries.reserve(msg.entries.size());
+        for (const auto& entry : msg.entries) {
+            entries.push_back({ entry.key, entry.value, entry.group, entry.ttl });
+        }
+        engine_.putBatch(entries);
+        LOG_INFO(component_, "MSET event: Stored " << entries.size() << " entries.");
+        MSetResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = true;
+        return resp;
+    }
+
+    // Handles an MGET event with one getBatch call.
+    MGetResponseMessage handleMGetEvent(const MGetEventMessage& msg) {
+        MGetResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = engine_.getBatch(msg.keys);
+        return resp;
+    }
+
+    // Handles an MDELETE event with one eraseBatch call.
+    MDeleteResponseMessage handleMDeleteEvent(const MDeleteEventMessage& msg) {
+        MDeleteResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = engine_.eraseBatch(msg.keys);
+        LOG_INFO(component_, "MDELETE event: Removed " << resp.response << " of " << msg.keys.size() << " keys.");
+        return resp;
+    }
+
+    // Handles a RANGE event on this tier; the StorageHandler has already resolved the prefix.
+    RangeResponseMessage handleRangeEvent(const RangeEventMessage& msg) {
+        RangeResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = engine_.scan(msg.start, msg.limit, msg.end);
+        if (resp.response.size() == msg.limit && msg.limit > 0) {
+            resp.next = StorageEngine::scanSuccessor(resp.response.back().key);
+        }
+        LOG_INFO(component_, "RANGE event: Returned " << resp.response.size() << " entries.");
+        return resp;
+    }
+};
+
+#endif // STORAGEENGINEBINDING_H
@@ -3,11 +3,15 @@
 
 #include "eventbus/EventBus.h"
 #include "storage/Message.h"  // Contains definitions for SetEventMessage, SetResponseMessage, etc.
+#include "storage/WriteBehindQueue.h"
+#include "storage/StorageEngine.h"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
+#include <memory>
+#include <algorithm>
 
 // Logging macros with a consistent layout.
 #define LOG_INFO(component, message) \
@@ -21,167 +25,298 @@ std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
   and forwards them to the RamHandler and DiskHandler.
   This way, modifications are stored both in fast, volatile memory (RAM)
   and persistently (on disk).
+  With write-behind enabled, persistent SETs are acknowledged once they are
+  buffered and reach the DiskHandler asynchronously (see WriteBehindQueue).
+
+  The handlers are coroutines: they start on the sender's thread, co_await the tiers'
+  responses and continue on the thread that delivers them, so a tier fallback
+  suspends instead of blocking. No EventBus worker waits for another one, so the pool
+  cannot fill up with blocked handlers. The sender keeps msg alive until the result
+  is ready (see EventBus::send); messages built here for the tiers either live in the
+  coroutine frame or are handed over to the EventBus.
 */
 class StorageHandler {
 public:
-    explicit StorageHandler(EventBus& eventBus)
+    explicit StorageHandler(EventBus& eventBus, const WriteBehindOptions& writeBehind = {})
         : eventBus_(eventBus)
     {
-        // Register the handler functions for Storage events with the EventBus.
-        eventBus_.subscribe<SetEventMessage, SetResponseMessage>(HandlerID::StorageHandler,
-            [this](const SetEventMessage& msg) -> SetResponseMessage {
-                return handleSetEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<GetKeyEventMessage, GetKeyResponseMessage>(HandlerID::StorageHandler,
-            [this](const GetKeyEventMessage& msg) -> GetKeyResponseMessage {
-                return handleGetKeyEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<GetGroupEventMessage, GetGroupResponseMessage>(HandlerID::StorageHandler,
-            [this](const GetGroupEventMessage& msg) -> GetGroupResponseMessage {
-                return handleGetGroupEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<DeleteKeyEventMessage, DeleteKeyResponseMessage>(HandlerID::StorageHandler,
-            [this](const DeleteKeyEventMessage& msg) -> DeleteKeyResponseMessage {
-                return handleDeleteKeyEvent(msg);
-            }
-        );
-
-        eventBus_.subscribe<DeleteGroupEventMessage, DeleteGroupResponseMessage>(HandlerID::StorageHandler,
-            [this](const DeleteGroupEventMessage& msg) -> DeleteGroupResponseMessage {
-                return handleDeleteGroupEvent(msg);
-            }
-        );
+        if (writeBehind.enabled) {
+            writeBehind_ = std::make_unique<WriteBehindQueue>(eventBus_, writeBehind);
+        }
 
-        eventBus_.subscribe<ListEventMessage, ListEventReponseMessage>(HandlerID::StorageHandler,
-            [this](const ListEventMessage& msg) -> ListEventReponseMessage {
-                return handleListEvent(msg);
-            }
-        );
+        // Register the handler functions for Storage events with the EventBus. They run inline
+        // and co_await the write-behind flush; only SET / MSET may wait in enqueue() while the
+        // queue is full, which is the backpressure maxPendingEntries asks for.
+        subscribe<SetEventMessage, SetResponseMessage>(&StorageHandler::handleSetEvent);
+        subscribe<GetKeyEventMessage, GetKeyResponseMessage>(&StorageHandler::handleGetKeyEvent);
+        subscribe<GetGroupEventMessage, GetGroupResponseMessage>(&StorageHandler::handleGetGroupEvent);
+        subscribe<DeleteKeyEventMessage, DeleteKeyResponseMessage>(&StorageHandler::handleDeleteKeyEvent);
+        subscribe<DeleteGroupEventMessage, DeleteGroupResponseMessage>(&StorageHandler::handleDeleteGroupEvent);
+        subscribe<ListEventMessage, ListEventReponseMessage>(&StorageHandler::handleListEvent);
+        subscribe<ScanEventMessage, ScanResponseMessage>(&StorageHandler::handleScanEvent);
+        subscribe<RangeEventMessage, RangeResponseMessage>(&StorageHandler::handleRangeEvent);
+        subscribe<MSetEventMessage, MSetResponseMessage>(&StorageHandler::handleMSetEvent);
+        subscribe<MGetEventMessage, MGetResponseMessage>(&StorageHandler::handleMGetEvent);
+        subscribe<MDeleteEventMessage, MDeleteResponseMessage>(&StorageHandler::handleMDeleteEvent);
 
         LOG_INFO("StorageHandler", "Initialized and subscribed to events.");
     }
 
+    // Unsubscribes first, so no new event reaches the handler while the write-behind queue
+    // is flushed and destroyed.
+    ~StorageHandler() {
+        eventBus_.unsubscribeAll(HandlerID::StorageHandler);
+    }
+
+    StorageHandler(const StorageHandler&) = delete;
+    StorageHandler& operator=(const StorageHandler&) = delete;
+
     // SET event: Forwards the request to RAM or Disk depending on persistence flag.
-    SetResponseMessage handleSetEvent(const SetEventMessage& msg) {
+    EventBusResult<SetResponseMessage> handleSetEvent(const SetEventMessage& msg) {
         if (msg.key.empty() || msg.value.empty()) {
             LOG_ERROR("StorageHandler", "SetEventMessage received empty event.");
             throw std::runtime_error("Invalid key or value.");
         }
 
-        if (msg.persistent) {
-            LOG_INFO("StorageHandler", "Forwarding SET request to DiskHandler for key: " << msg.key);
-            // Send request to DiskHandler.
-            auto diskResult = eventBus_.send<SetResponseMessage>(HandlerID::DiskHandler, msg);
-            SetResponseMessage diskResp = diskResult.get();
-            diskResp.id = msg.id;
-            return diskResp;
-        } else {
-            LOG_INFO("StorageHandler", "Forwarding SET request to RamHandler for key: " << msg.key);
-            // Send request to RamHandler.
-            auto ramResult = eventBus_.send<SetResponseMessage>(HandlerID::RamHandler, msg);
-            SetResponseMessage ramResp = ramResult.get();
-            ramResp.id = msg.id;
-            return ramResp;
+        // A queue that is shutting down rejects the SET, which is then written through.
+        if (msg.persistent && writeBehind_ && writeBehind_->enqueue(msg)) {
+            LOG_INFO("StorageHandler", "Queued write-behind SET for key: " << msg.key);
+            SetResponseMessage resp;
+            resp.id = msg.id;
+            resp.response = true;
+            co_return resp;
         }
+
+        LOG_INFO("StorageHandler", "Forwarding SET request to " << (msg.persistent ? "DiskHandler" : "RamHandler")
+                 << " for key: " << msg.key);
+        SetResponseMessage resp = co_await eventBus_.send<SetResponseMessage>(
+            msg.persistent ? HandlerID::DiskHandler : HandlerID::RamHandler, msg);
+        resp.id = msg.id;
+        co_return resp;
     }
 
     // GET KEY event: First searches in RAM; if not found, then queries the DiskHandler.
-    GetKeyResponseMessage handleGetKeyEvent(const GetKeyEventMessage& msg) {
+    EventBusResult<GetKeyResponseMessage> handleGetKeyEvent(const GetKeyEventMessage& msg) {
         if (msg.key.empty()) {
             LOG_ERROR("StorageHandler", "GetKeyResponseMessage key is empty.");
             throw std::invalid_argument("Invalid key name");
         }
 
-        auto ramResult = eventBus_.send<GetKeyResponseMessage>(HandlerID::RamHandler, msg);
-        GetKeyResponseMessage ramResp = ramResult.get();
+        GetKeyResponseMessage ramResp = co_await eventBus_.send<GetKeyResponseMessage>(HandlerID::RamHandler, msg);
         if (!ramResp.response.empty()) {
             LOG_INFO("StorageHandler", "Key '" << msg.key << "' found in RamHandler.");
-            return ramResp;
+            co_return ramResp;
+        } else if (writeBehind_ && writeBehind_->lookup(msg.key, ramResp.response)) {
+            LOG_INFO("StorageHandler", "Key '" << msg.key << "' found in write-behind queue.");
+            ramResp.id = msg.id;
+            co_return ramResp;
+        }
+        LOG_INFO("StorageHandler", "Key '" << msg.key << "' not found in RAM; querying DiskHandler.");
+
+        // Fallback: query DiskHandler.
+        GetKeyResponseMessage diskResp = co_await eventBus_.send<GetKeyResponseMessage>(HandlerID::DiskHandler, msg);
+        if (!diskResp.response.empty()) {
+            LOG_INFO("StorageHandler", "Key '" << msg.key << "' found in DiskHandler.");
         } else {
-            LOG_INFO("StorageHandler", "Key '" << msg.key << "' not found in RAM; querying DiskHandler.");
-            // Fallback: query DiskHandler.
-            auto diskResult = eventBus_.send<GetKeyResponseMessage>(HandlerID::DiskHandler, msg);
-            GetKeyResponseMessage diskResp = diskResult.get();
-            if (!diskResp.response.empty()) {
-                LOG_INFO("StorageHandler", "Key '" << msg.key << "' found in DiskHandler.");
-            } else {
-                LOG_INFO("StorageHandler", "Key '" << msg.key << "' not found in DiskHandler either.");
-            }
-            return diskResp;
+            LOG_INFO("StorageHandler", "Key '" << msg.key << "' not found in DiskHandler either.");
         }
+        co_return diskResp;
     }
 
     // GET GROUP event: Searches both RAM and Disk and combines the results.
-    GetGroupResponseMessage handleGetGroupEvent(const GetGroupEventMessage& msg) {
+    EventBusResult<GetGroupResponseMessage> handleGetGroupEvent(const GetGroupEventMessage& msg) {
         if (msg.group.empty()) {
             LOG_ERROR("StorageHandler", "GetGroupResponseMessage group is empty.");
             throw std::invalid_argument("Invalid group name");
         }
 
-        auto ramResult = eventBus_.send<GetGroupResponseMessage>(HandlerID::RamHandler, msg);
-        auto diskResult = eventBus_.send<GetGroupResponseMessage>(HandlerID::DiskHandler, msg);
-
-        GetGroupResponseMessage ramResp = ramResult.get();
-        GetGroupResponseMessage diskResp = diskResult.get();
+        auto [ramResp, diskResp] = co_await whenAll(eventBus_.send<GetGroupResponseMessage>(HandlerID::RamHandler, msg),
+                                                    eventBus_.send<GetGroupResponseMessage>(HandlerID::DiskHandler, msg));
+        if (writeBehind_) {
+            writeBehind_->mergeGroup(msg.group, diskResp.response);
+        }
 
         GetGroupResponseMessage result;
         result.id = msg.id;
         // Combine results: prepend RAM entries to the disk entries.
         diskResp.response.insert(diskResp.response.begin(), ramResp.response.begin(), ramResp.response.end());
-        result.response = diskResp.response;
+        result.response = std::move(diskResp.response);
 
         LOG_INFO("StorageHandler", "GET GROUP for '" << msg.group << "' returned "
                  << result.response.size() << " total entries.");
-        return result;
+        co_return result;
+    }
+
+    // MSET event: Splits the batch by persistence flag and sends one message per tier;
+    // persistent entries go to the write-behind queue instead if it is enabled.
+    EventBusResult<MSetResponseMessage> handleMSetEvent(const MSetEventMessage& msg) {
+        MSetEventMessage ramMsg;
+        MSetEventMessage diskMsg;
+        ramMsg.id = diskMsg.id = msg.id;
+        for (const auto& entry : msg.entries) {
+            if (entry.key.empty() || entry.value.empty()) {
+                LOG_ERROR("StorageHandler", "MSetEventMessage contains an empty key or value.");
+                throw std::runtime_error("Invalid key or value.");
+            }
+            (entry.persistent ? diskMsg : ramMsg).entries.push_back(entry);
+        }
+
+        if (writeBehind_) {
+            // Entries the queue rejects (it is shutting down) stay in diskMsg and are written through.
+            std::vector<MSetEntry> rejected;
+            for (auto& entry : diskMsg.entries) {
+                SetEventMessage setMsg;
+                setMsg.id = msg.id;
+                setMsg.persistent = true;
+                setMsg.ttl = entry.ttl;
+                setMsg.key = entry.key;
+                setMsg.value = entry.value;
+                setMsg.group = entry.group;
+                if (!writeBehind_->enqueue(setMsg)) {
+                    rejected.push_back(std::move(entry));
+                }
+            }
+            diskMsg.entries = std::move(rejected);
+        }
+
+        // A tier without entries is skipped; the EventBus takes each part over.
+        auto sendPart = [this](HandlerID tier, MSetEventMessage&& part) {
+            if (part.entries.empty()) {
+                MSetResponseMessage skipped;
+                skipped.response = true;
+                return makeReadyResult(std::move(skipped));
+            }
+            return eventBus_.send<MSetResponseMessage>(tier, std::move(part));
+        };
+        const size_t ramEntries = ramMsg.entries.size();
+        auto [ramResp, diskResp] = co_await whenAll(sendPart(HandlerID::RamHandler, std::move(ramMsg)),
+                                                    sendPart(HandlerID::DiskHandler, std::move(diskMsg)));
+        MSetResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = ramResp.response && diskResp.response;
+        LOG_INFO("StorageHandler", "MSET stored " << ramEntries << " entries in RAM and "
+                 << msg.entries.size() - ramEntries << " persistent entries.");
+        co_return resp;
+    }
+
+    // MGET event: Looks the whole batch up in RAM, then the keys RAM did not have in the
+    // write-behind queue and finally in one batch on disk.
+    EventBusResult<MGetResponseMessage> handleMGetEvent(const MGetEventMessage& msg) {
+        for (const auto& key : msg.keys) {
+            if (key.empty()) {
+                LOG_ERROR("StorageHandler", "MGetEventMessage contains an empty key.");
+                throw std::invalid_argument("Invalid key name");
+            }
+        }
+
+        MGetResponseMessage result = co_await eventBus_.send<MGetResponseMessage>(HandlerID::RamHandler, msg);
+        result.id = msg.id;
+
+        MGetEventMessage diskMsg;
+        diskMsg.id = msg.id;
+        std::vector<size_t> diskPositions;
+        std::string pending;
+        for (size_t i = 0; i < msg.keys.size(); ++i) {
+            if (result.response[i]) {
+                continue;
+            }
+            if (writeBehind_ && writeBehind_->lookup(msg.keys[i], pending)) {
+                result.response[i] = pending;
+            } else {
+                diskMsg.keys.push_back(msg.keys[i]);
+                diskPositions.push_back(i);
+            }
+        }
+        LOG_INFO("StorageHandler", "MGET for " << msg.keys.size() << " keys: "
+                 << msg.keys.size() - diskMsg.keys.size() << " answered without the DiskHandler.");
+        if (diskMsg.keys.empty()) {
+            co_return result;
+        }
+
+        MGetResponseMessage diskResp = co_await eventBus_.send<MGetResponseMessage>(HandlerID::DiskHandler, std::move(diskMsg));
+        for (size_t j = 0; j < diskPositions.size(); ++j) {
+            result.response[diskPositions[j]] = std::move(diskResp.response[j]);
+        }
+        co_return result;
+    }
+
+    // MDELETE event: Sends the batch to both storages at once and sums the removed entries.
+    EventBusResult<MDeleteResponseMessage> handleMDeleteEvent(const MDeleteEventMessage& msg) {
+        for (const auto& key : msg.keys) {
+            if (key.empty()) {
+                LOG_ERROR("StorageHandler", "MDeleteEventMessage contains an empty key.");
+                throw std::invalid_argument("Invalid key name");
+            }
+        }
+
+        // Pending writes of these keys are committed first, so each persistent key counts once.
+        if (writeBehind_) {
+            std::string pending;
+            if (std::any_of(msg.keys.begin(), msg.keys.end(),
+                            [&](const std::string& key) { return writeBehind_->lookup(key, pending); })) {
+                co_await writeBehind_->flush();
+            }
+        }
+
+        auto [ramResp, diskResp] = co_await whenAll(eventBus_.send<MDeleteResponseMessage>(HandlerID::RamHandler, msg),
+                                                    eventBus_.send<MDeleteResponseMessage>(HandlerID::DiskHandler, msg));
+        MDeleteResponseMessage resp;
+        resp.id = msg.id;
+        resp.response = ramResp.response + diskResp.response;
+        LOG_INFO("StorageHandler", "MDELETE removed " << resp.response << " entries for " << msg.keys.size() << " keys.");
+        co_return resp;
     }
 
     // DELETE KEY event: Forwards the deletion request to both storages.
-    DeleteKeyResponseMessage handleDeleteKeyEvent(const DeleteKeyEventMessage& msg) {
+    EventBusResult<DeleteKeyResponseMessage> handleDeleteKeyEvent(const DeleteKeyEventMessage& msg) {
         if (msg.key.empty()) {
             LOG_ERROR("StorageHandler", "DeleteKeyResponseMessage key is empty.");
             throw std::invalid_argument("Invalid key name");
         }
 
-        auto ramResult = eventBus_.send<DeleteKeyResponseMessage>(HandlerID::RamHandler, msg);
-        auto diskResult = eventBus_.send<DeleteKeyResponseMessage>(HandlerID::DiskHandler, msg);
+        // A pending write-behind entry must be dropped before the disk DELETE is issued.
+        int pendingRemoved = 0;
+        if (writeBehind_) {
+            pendingRemoved = co_await writeBehind_->erase(msg.key);
+        }
 
-        DeleteKeyResponseMessage ramResp = ramResult.get();
+        auto [ramResp, diskResp] = co_await whenAll(eventBus_.send<DeleteKeyResponseMessage>(HandlerID::RamHandler, msg),
+                                                    eventBus_.send<DeleteKeyResponseMessage>(HandlerID::DiskHandler, msg));
         if (ramResp.response != 0) {
             LOG_INFO("StorageHandler", "Key '" << msg.key << "' deleted in RamHandler.");
         }
-        DeleteKeyResponseMessage diskResp = diskResult.get();
         if (diskResp.response != 0) {
             LOG_INFO("StorageHandler", "Key '" << msg.key << "' deleted in DiskHandler.");
         }
+        // A pending write and an older committed version count as one persistent key.
+        if (pendingRemoved != 0) {
+            diskResp.response = 1;
+        }
 
         DeleteKeyResponseMessage resp;
         resp.id = msg.id;
         // Report success only if both storages confirm deletion (1 = success).
         resp.response = ramResp.response + diskResp.response;
-        return resp;
+        co_return resp;
     }
 
     // DELETE GROUP event: Forwards the request to both storages and aggregates the results.
-    DeleteGroupResponseMessage handleDeleteGroupEvent(const DeleteGroupEventMessage& msg) {
+    EventBusResult<DeleteGroupResponseMessage> handleDeleteGroupEvent(const DeleteGroupEventMessage& msg) {
         if (msg.group.empty()) {
             LOG_ERROR("StorageHandler", "DeleteGroupResponseMessage group is empty.");
             throw std::invalid_argument("Invalid group name");
         }
 
-        auto ramResult = eventBus_.send<DeleteGroupResponseMessage>(HandlerID::RamHandler, msg);
-        auto diskResult = eventBus_.send<DeleteGroupResponseMessage>(HandlerID::DiskHandler, msg);
+        // Group membership of pending writes is only known after they are committed.
+        if (writeBehind_) {
+            co_await writeBehind_->flush();
+        }
 
-        DeleteGroupResponseMessage ramResp = ramResult.get();
+        auto [ramResp, diskResp] = co_await whenAll(eventBus_.send<DeleteGroupResponseMessage>(HandlerID::RamHandler, msg),
+                                                    eventBus_.send<DeleteGroupResponseMessage>(HandlerID::DiskHandler, msg));
         if (ramResp.response != 0) {
             LOG_INFO("StorageHandler", "Group '" << msg.group << "' deleted in RamHandler.");
         }
-        DeleteGroupResponseMessage diskResp = diskResult.get();
         if (diskResp.response != 0) {
             LOG_INFO("StorageHandler", "Group '" << msg.group << "' deleted in DiskHandler.");
         }
@@ -190,30 +325,157 @@ public:
         resp.id = msg.id;
         // Here we sum the number of deleted entries (alternative strategies are possible).
         resp.response = ramResp.response + diskResp.response;
-        return resp;
+        co_return resp;
     }
 
-    // LIST event: Retrieves entries from both storages and merges them.
-    ListEventReponseMessage handleListEvent(const ListEventMessage& msg) {
-        auto diskResult = eventBus_.send<ListEventReponseMessage>(HandlerID::DiskHandler, msg);
-        auto ramResult = eventBus_.send<ListEventReponseMessage>(HandlerID::RamHandler, msg);
+    // LIST event: Retrieves entries from both storages and merges them. With a limit,
+    // one chunk is returned per call: first the RAM entries, then the disk entries,
+    // each tier in key order. The cursor in next/after is "r<key>" or "d<key>".
+    EventBusResult<ListEventReponseMessage> handleListEvent(const ListEventMessage& msg) {
+        if (msg.limit > 0) {
+            co_return co_await handleListChunk(msg);
+        }
+
+        // Pending writes must be visible in the listing.
+        if (writeBehind_) {
+            co_await writeBehind_->flush();
+        }
 
-        ListEventReponseMessage ramResp = ramResult.get();
+        auto [ramResp, diskResp] = co_await whenAll(eventBus_.send<ListEventReponseMessage>(HandlerID::RamHandler, msg),
+                                                    eventBus_.send<ListEventReponseMessage>(HandlerID::DiskHandler, msg));
         LOG_INFO("StorageHandler", "Found " << ramResp.response.size() << " entries in RamHandler.");
-        ListEventReponseMessage diskResp = diskResult.get();
         LOG_INFO("StorageHandler", "Found " << diskResp.response.size() << " entries in DiskHandler.");
 
         ListEventReponseMessage result;
         result.id = msg.id;
         diskResp.response.insert(diskResp.response.begin(), ramResp.response.begin(), ramResp.response.end());
-        result.response = diskResp.response;
+        result.response = std::move(diskResp.response);
 
         LOG_INFO("StorageHandler", "LIST event returned " << result.response.size() << " total entries.");
-        return result;
+        co_return result;
+    }
+
+    // SCAN event: one step over RAM, then disk. Each step examines at most msg.count keys
+    // of one tier, so the tier locks are only held briefly. The cursor is "0" at the
+    // start and end, otherwise "r<key>" / "d<key>" like the LIST cursor.
+    EventBusResult<ScanResponseMessage> handleScanEvent(const ScanEventMessage& msg) {
+        const bool start = msg.cursor.empty() || msg.cursor == "0";
+        if (msg.count == 0 || (!start && msg.cursor[0] != 'r' && msg.cursor[0] != 'd')) {
+            LOG_ERROR("StorageHandler", "ScanEventMessage has an invalid cursor or count.");
+            throw std::invalid_argument("Invalid SCAN cursor or count");
+        }
+        if (start && writeBehind_) {
+            co_await writeBehind_->flush();
+        }
+
+        const bool disk = !start && msg.cursor[0] == 'd';
+        ScanEventMessage tierMsg;
+        tierMsg.id = msg.id;
+        tierMsg.cursor = start ? "" : msg.cursor.substr(1);
+        tierMsg.count = msg.count;
+        tierMsg.group = msg.group;
+        tierMsg.prefix = msg.prefix;
+        ScanResponseMessage result = co_await eventBus_.send<ScanResponseMessage>(
+            disk ? HandlerID::DiskHandler : HandlerID::RamHandler, std::move(tierMsg));
+        if (!result.cursor.empty()) {
+            result.cursor.insert(0, 1, disk ? 'd' : 'r');
+        } else {
+            result.cursor = disk ? "0" : "d";
+        }
+        co_return result;
+    }
+
+    // RANGE event: Queries both tiers in parallel and merges their sorted results.
+    // A key present in both tiers is reported once, with the RAM value (as GET does).
+    EventBusResult<RangeResponseMessage> handleRangeEvent(const RangeEventMessage& msg) {
+        if (msg.limit == 0) {
+            LOG_ERROR("StorageHandler", "RangeEventMessage limit is zero.");
+            throw std::invalid_argument("Invalid RANGE limit");
+        }
+        if (writeBehind_) {
+            co_await writeBehind_->flush();
+        }
+
+        RangeEventMessage tierMsg;
+        tierMsg.id = msg.id;
+        tierMsg.limit = msg.limit;
+        tierMsg.start = std::max(msg.start, msg.prefix);
+        tierMsg.end = msg.end;
+        const std::string prefixEnd = StorageEngine::prefixEnd(msg.prefix);
+        if (!prefixEnd.empty() && (tierMsg.end.empty() || prefixEnd < tierMsg.end)) {
+            tierMsg.end = prefixEnd;
+        }
+
+        RangeResponseMessage result;
+        result.id = msg.id;
+        if (!tierMsg.end.empty() && tierMsg.start >= tierMsg.end) {
+            co_return result;
+        }
+
+        // Both tiers read tierMsg, which lives in this coroutine until they have answered.
+        auto [ramResp, diskResp] = co_await whenAll(eventBus_.send<RangeResponseMessage>(HandlerID::RamHandler, tierMsg),
+                                                    eventBus_.send<RangeResponseMessage>(HandlerID::DiskHandler, tierMsg));
+        auto ram = ramResp.response.begin();
+        auto disk = diskResp.response.begin();
+        while (result.response.size() < tierMsg.limit && (ram != ramResp.response.end() || disk != diskResp.response.end())) {
+            if (disk == diskResp.response.end() || (ram != ramResp.response.end() && ram->key <= disk->key)) {
+                if (disk != diskResp.response.end() && disk->key == ram->key) {
+                    ++disk;
+                }
+                result.response.push_back(std::move(*ram++));
+            } else {
+                result.response.push_back(std::move(*disk++));
+            }
+        }
+        // More entries may follow if a tier filled its page or the merge left entries over.
+        const bool more = !ramResp.next.empty() || !diskResp.next.empty() ||
+                          ram != ramResp.response.end() || disk != diskResp.response.end();
+        if (more && !result.response.empty()) {
+            result.next = StorageEngine::scanSuccessor(result.response.back().key);
+        }
+        LOG_INFO("StorageHandler", "RANGE event returned " << result.response.size() << " entries.");
+        co_return result;
     }
 
 private:
+    // Subscribes one of the handle*Event members as an async handler.
+    template <typename TMsg, typename RetMsg>
+    void subscribe(EventBusResult<RetMsg> (StorageHandler::*handler)(const TMsg&)) {
+        eventBus_.subscribeAsync<TMsg, RetMsg>(HandlerID::StorageHandler,
+            [this, handler](const TMsg& msg) -> EventBusResult<RetMsg> {
+                return (this->*handler)(msg);
+            }
+        );
+    }
+
+    // Serves one chunk of a chunked LIST.
+    EventBusResult<ListEventReponseMessage> handleListChunk(const ListEventMessage& msg) {
+        if (!msg.after.empty() && msg.after[0] != 'r' && msg.after[0] != 'd') {
+            throw std::invalid_argument("Invalid LIST cursor");
+        }
+        if (msg.after.empty() && writeBehind_) {
+            co_await writeBehind_->flush();
+        }
+
+        const bool disk = !msg.after.empty() && msg.after[0] == 'd';
+        ListEventMessage tierMsg;
+        tierMsg.id = msg.id;
+        tierMsg.after = msg.after.empty() ? "" : msg.after.substr(1);
+        tierMsg.limit = msg.limit;
+        ListEventReponseMessage result = co_await eventBus_.send<ListEventReponseMessage>(
+            disk ? HandlerID::DiskHandler : HandlerID::RamHandler, std::move(tierMsg));
+        if (!result.next.empty()) {
+            result.next.insert(0, 1, disk ? 'd' : 'r');
+        } else if (!disk) {
+            // RAM is done; the next call starts on disk.
+            result.next = "d";
+        }
+        co_return result;
+    }
+
     EventBus& eventBus_;
+    // Only set when write-behind is enabled for persistent SETs.
+    std::unique_ptr<WriteBehindQueue> writeBehind_;
 };
 
 #endif // STORAGEHANDLER_H
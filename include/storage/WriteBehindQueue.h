@@ -0,0 +1,338 @@
+#ifndef WRITEBEHINDQUEUE_H
+#define WRITEBEHINDQUEUE_H
+
+#include "eventbus/EventBus.h"
+#include "storage/Message.h"
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+
+// Logging macros with a consistent layout.
+#define LOG_INFO(component, message) \
+std::cout <<"[INFO]" << " [" << component << "] " << message << std::endl;
+
+#define LOG_ERROR(component, message) \
+std::cout <<"[ERROR]" << " [" << component << "] " << message << std::endl;
+
+// Settings for the asynchronous write-behind path of persistent SETs.
+struct WriteBehindOptions {
+    // Disabled by default: persistent SETs block until the DiskHandler has committed.
+    bool enabled = false;
+    // Upper bound (in milliseconds) an acknowledged write may wait before a flush is started.
+    int maxLagMs = 100;
+    // Producers block once this many writes are pending, which bounds the durability window.
+    size_t maxPendingEntries = 10000;
+};
+
+/*
+  WriteBehindQueue buffers persistent SETs in RAM, acknowledges them immediately
+  and flushes them to the DiskHandler from a background writer thread.
+  Pending entries stay visible for reads until the DiskHandler has committed them,
+  and everything still pending is flushed when the queue is destroyed. Once the
+  queue is stopping it accepts no more writes; callers write those through instead.
+  Only the writer thread talks to the DiskHandler. flush() and erase() hand their
+  request to it and return an EventBusResult, so coroutine handlers can co_await
+  them instead of blocking on a flush.
+*/
+class WriteBehindQueue {
+public:
+    WriteBehindQueue(EventBus& eventBus, const WriteBehindOptions& options)
+        : eventBus_(eventBus)
+        , options_(options)
+        , stopThread_(false)
+        , flushing_(false)
+        , writerDone_(false)
+        , sequence_(0)
+    {
+        writerThread_ = std::thread(&WriteBehindQueue::writerLoop, this);
+        LOG_INFO("WriteBehindQueue", "Started with max lag " << options_.maxLagMs
+                 << " ms and at most " << options_.maxPendingEntries << " pending entries.");
+    }
+
+    ~WriteBehindQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopThread_ = true;
+        }
+        flushCv_.notify_all();
+        spaceCv_.notify_all();
+        if (writerThread_.joinable()) {
+            writerThread_.join();
+        }
+        LOG_INFO("WriteBehindQueue", "Writer thread stopped after final flush.");
+    }
+
+    // Buffers a SET; blocks while the queue is full. Returns false without buffering once the
+    // queue is stopping, because the final flush may already have taken its snapshot; the
+    // caller then has to write the SET to the DiskHandler itself before acknowledging it.
+    bool enqueue(const SetEventMessage& msg) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        spaceCv_.wait(lock, [this, &msg] {
+            return stopThread_ || pending_.size() < options_.maxPendingEntries || pending_.count(msg.key) > 0;
+        });
+        if (stopThread_) {
+            return false;
+        }
+
+        PendingWrite& entry = pending_[msg.key];
+        entry.value = msg.value;
+        entry.group = msg.group;
+        entry.sequence = ++sequence_;
+
+        if (pending_.size() >= options_.maxPendingEntries) {
+            flushCv_.notify_one();
+        }
+        return true;
+    }
+
+    // Returns true and fills value if the key has a pending (not yet committed) write.
+    bool lookup(const std::string& key, std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(key);
+        if (it == pending_.end()) {
+            return false;
+        }
+        value = it->second.value;
+        return true;
+    }
+
+    // Replaces disk entries that have a newer pending write and appends pending entries of the group.
+    void mergeGroup(const std::string& group, std::vector<KeyValue>& diskEntries) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty()) {
+            return;
+        }
+        diskEntries.erase(std::remove_if(diskEntries.begin(), diskEntries.end(),
+            [this](const KeyValue& kv) { return pending_.count(kv.key) > 0; }), diskEntries.end());
+        for (const auto& [key, entry] : pending_) {
+            if (entry.group == group) {
+                diskEntries.push_back({ key, entry.value });
+            }
+        }
+    }
+
+    // Drops a pending write; yields the number of removed entries. While a flush is in flight
+    // the removal is applied once it has finished, so a later disk DELETE cannot be overtaken.
+    EventBusResult<int> erase(const std::string& key) {
+        EventBusPromise<int> done;
+        int removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (flushing_) {
+                deferredErases_.emplace_back(key, done);
+                return done.result();
+            }
+            removed = static_cast<int>(pending_.erase(key));
+        }
+        if (removed) {
+            spaceCv_.notify_all();
+        }
+        done.setValue(removed);
+        return done.result();
+    }
+
+    // Ready once every entry pending at the time of the call has been written to the DiskHandler
+    // (or the attempt failed; such entries stay pending and readable). The writer thread does
+    // the flush and completes the result.
+    EventBusResult<void> flush() {
+        EventBusPromise<void> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!writerDone_) {
+                flushWaiters_.push_back(done);
+                flushCv_.notify_one();
+                return done.result();
+            }
+        }
+        done.setValue();
+        return done.result();
+    }
+
+private:
+    struct PendingWrite {
+        std::string value;
+        std::string group;
+        // Distinguishes a rewrite of the same key that arrived while a flush was in progress.
+        uint64_t sequence;
+    };
+
+    EventBus& eventBus_;
+    WriteBehindOptions options_;
+
+    std::unordered_map<std::string, PendingWrite> pending_;
+    // Protects pending_, the flush state below, sequence_ and stopThread_.
+    std::mutex mutex_;
+    std::condition_variable flushCv_;
+    std::condition_variable spaceCv_;
+    // flush() callers waiting for the next flush of the writer thread.
+    std::vector<EventBusPromise<void>> flushWaiters_;
+    // erase() calls that arrived while a flush was in flight.
+    std::vector<std::pair<std::string, EventBusPromise<int>>> deferredErases_;
+
+    std::thread writerThread_;
+    bool stopThread_;
+    // Set while the writer thread has a snapshot of pending_ on its way to the DiskHandler.
+    bool flushing_;
+    // Set after the final flush; later flush() calls are ready right away.
+    bool writerDone_;
+    uint64_t sequence_;
+
+    // Batch attempts of the final flush before falling back to single writes.
+    static constexpr int kFinalFlushAttempts = 3;
+
+    void writerLoop() {
+        const std::chrono::milliseconds interval(options_.maxLagMs);
+
+        while (true) {
+            bool stopping;
+            std::vector<EventBusPromise<void>> waiters;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                flushCv_.wait_for(lock, interval, [this] {
+                    return stopThread_ || pending_.size() >= options_.maxPendingEntries || !flushWaiters_.empty();
+                });
+                stopping = stopThread_;
+                waiters.swap(flushWaiters_);
+                flushing_ = true;
+            }
+
+            if (stopping) {
+                finalFlush();
+            } else {
+                flushPending();
+            }
+            finishFlush(waiters, stopping);
+            if (stopping) {
+                break;
+            }
+        }
+        LOG_INFO("WriteBehindQueue", "Writer thread exiting.");
+    }
+
+    // Applies the erases that waited for the flush and completes the waiting results. They
+    // continue on this thread, so they are completed outside the lock.
+    void finishFlush(std::vector<EventBusPromise<void>>& waiters, bool last) {
+        std::vector<std::pair<std::string, EventBusPromise<int>>> erases;
+        std::vector<int> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            erases.swap(deferredErases_);
+            for (const auto& [key, done] : erases) {
+                removed.push_back(static_cast<int>(pending_.erase(key)));
+            }
+            flushing_ = false;
+            if (last) {
+                writerDone_ = true;
+                waiters.insert(waiters.end(), flushWaiters_.begin(), flushWaiters_.end());
+                flushWaiters_.clear();
+            }
+        }
+        spaceCv_.notify_all();
+        for (size_t i = 0; i < erases.size(); ++i) {
+            erases[i].second.setValue(removed[i]);
+        }
+        for (auto& done : waiters) {
+            done.setValue();
+        }
+    }
+
+    // Every pending entry was acknowledged to a client, so the last flush does not give up
+    // after one failed batch: it retries the batch, then writes the entries one by one, and
+    // reports every entry that still could not be committed.
+    void finalFlush() {
+        for (int attempt = 1; attempt <= kFinalFlushAttempts && flushPending() > 0; ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100 * attempt));
+        }
+
+        // Still flushing_, so a concurrent erase() waits for these single writes as well.
+        std::vector<std::pair<std::string, PendingWrite>> remaining;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            remaining.assign(pending_.begin(), pending_.end());
+        }
+        size_t lost = 0;
+        for (auto& [key, entry] : remaining) {
+            SetEventMessage msg;
+            msg.id = "write-behind";
+            msg.persistent = true;
+            msg.ttl = 0;
+            msg.key = key;
+            msg.value = std::move(entry.value);
+            msg.group = std::move(entry.group);
+            try {
+                eventBus_.send<SetResponseMessage>(HandlerID::DiskHandler, std::move(msg)).get();
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_.erase(key);
+            } catch (const std::exception& e) {
+                ++lost;
+                LOG_ERROR("WriteBehindQueue", "Acknowledged write for key '" << key << "' is lost: " << e.what());
+            }
+        }
+        if (lost > 0) {
+            LOG_ERROR("WriteBehindQueue", "Final flush failed: " << lost << " acknowledged writes were not persisted.");
+        }
+    }
+
+    // Writes all pending entries as one batch; returns the number of entries that are still
+    // pending because the batch failed.
+    // Runs on the writer thread while flushing_ is set.
+    size_t flushPending() {
+        std::vector<std::pair<std::string, PendingWrite>> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.reserve(pending_.size());
+            for (const auto& entry : pending_) {
+                batch.emplace_back(entry);
+            }
+        }
+        if (batch.empty()) {
+            return 0;
+        }
+
+        // Entries stay in pending_ (and thus readable) until the DiskHandler has committed them.
+        // The batch goes out as one EventBus task, which the DiskHandler writes with one
+        // putBatch (one sync / transaction); the values are moved, not copied.
+        std::vector<SetEventMessage> messages(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            messages[i].id = "write-behind";
+            messages[i].persistent = true;
+            messages[i].ttl = 0;
+            messages[i].key = batch[i].first;
+            messages[i].value = std::move(batch[i].second.value);
+            messages[i].group = std::move(batch[i].second.group);
+        }
+
+        std::vector<const std::pair<std::string, PendingWrite>*> committed;
+        try {
+            eventBus_.sendBatch<SetResponseMessage>(HandlerID::DiskHandler, std::move(messages)).get();
+            committed.reserve(batch.size());
+            for (const auto& item : batch) {
+                committed.push_back(&item);
+            }
+        } catch (const std::exception& e) {
+            // Keep the entries pending; they are retried with the next flush.
+            LOG_ERROR("WriteBehindQueue", "Flushing " << batch.size() << " entries failed: " << e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto* item : committed) {
+                auto it = pending_.find(item->first);
+                if (it != pending_.end() && it->second.sequence == item->second.sequence) {
+                    pending_.erase(it);
+                }
+            }
+        }
+        spaceCv_.notify_all();
+        LOG_INFO("WriteBehindQueue", "Flushed " << committed.size() << " of " << batch.size() << " pending entries.");
+        return batch.size() - committed.size();
+    }
+};
+
+#endif // WRITEBEHINDQUEUE_H
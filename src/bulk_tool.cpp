@@ -0,0 +1,85 @@
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <string>
+#include <chrono>
+#include "config/ConfigHandler.h"
+#include "storage/DiskHandler.h"
+#include "storage/DumpFile.h"
+
+namespace fs = std::filesystem;
+
+// Offline-Werkzeug zum Exportieren/Importieren des persistenten Speichers.
+// Der Server darf währenddessen nicht auf denselben Speicher zugreifen.
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <export|import> <dumpFile> [configFile] [--batch N]" << std::endl;
+}
+
+static void printStats(const char* label, const BulkTransferStats& stats) {
+    const double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    std::cout << label << std::fixed << std::setprecision(1)
+              << stats.entries << " entries, "
+              << stats.bytes / (1024.0 * 1024.0) << " MB in " << stats.seconds << " s ("
+              << stats.entries / seconds << " entries/s, "
+              << stats.bytes / (1024.0 * 1024.0) / seconds << " MB/s)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    fs::path configFile = fs::absolute("etc/AdvancedCacheManager/config.json");
+    size_t batchSize = 10000;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--batch" && i + 1 < argc) {
+            batchSize = std::stoul(argv[++i]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() < 2 || positional.size() > 3 || batchSize == 0 ||
+        (positional[0] != "export" && positional[0] != "import")) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (positional.size() == 3) {
+        configFile = fs::absolute(positional[2]);
+    }
+    const std::string& mode = positional[0];
+    const std::string dumpFile = fs::absolute(positional[1]).string();
+
+    try {
+        ConfigHandler configHandler(configFile.string());
+        const Config& config = configHandler.getConfig();
+        auto engine = DiskHandler::openEngine(config.diskBackend, config.dbFile, static_cast<size_t>(config.diskShards));
+
+        // Fortschritt höchstens einmal pro Sekunde ausgeben
+        auto lastReport = std::chrono::steady_clock::now();
+        auto progress = [&lastReport](const BulkTransferStats& stats) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::seconds(1)) {
+                lastReport = now;
+                printStats("  ... ", stats);
+            }
+        };
+
+        if (mode == "export") {
+            std::cout << "Exportiere '" << config.dbFile << "' (" << config.diskBackend << ") nach " << dumpFile << std::endl;
+            printStats("Export: ", BulkTransfer::exportDump(*engine, dumpFile, true, progress));
+        } else {
+            std::cout << "Importiere " << dumpFile << " nach '" << config.dbFile << "' (" << config.diskBackend
+                      << "), Batchgröße " << batchSize << std::endl;
+            const BulkTransferStats stats = BulkTransfer::importDump(dumpFile, engine.get(), nullptr, batchSize, progress);
+            printStats("Import: ", stats);
+            if (stats.skipped > 0) {
+                std::cout << "  " << stats.skipped << " nicht-persistente Einträge übersprungen." << std::endl;
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Fehler: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <filesystem>
+#include <csignal>
 #include "config/ConfigHandler.h"
 #include "eventbus/EventBus.h"
 #include "storage/RamHandler.h"
@@ -9,6 +10,15 @@
 
 namespace fs = std::filesystem;
 
+// Wird vom Signal-Handler gestoppt, damit die Handler regulär abgebaut werden (RAM-Snapshot beim Beenden).
+static SocketHandler* runningSocketHandler = nullptr;
+
+static void handleShutdownSignal(int) {
+    if (runningSocketHandler) {
+        runningSocketHandler->stop();
+    }
+}
+
 int main(int argc, char** argv) {
     // Standard-Konfigurationsdatei ist "config.json"
     fs::path configFile = fs::absolute("etc/AdvancedCacheManager/config.json");
@@ -25,18 +35,50 @@ int main(int argc, char** argv) {
 
         std::cout << "Konfiguration geladen:" << std::endl;
         std::cout << "  RAM max size (MB): " << config.maxSizeMB << std::endl;
+        std::cout << "  RAM snapshot:      " << (!config.ramSnapshotEnabled ? "disabled" : config.ramAppendLogEnabled ? "disabled (append log used)" : config.ramSnapshotFile) << std::endl;
+        std::cout << "  RAM append log:    " << (config.ramAppendLogEnabled ? config.ramAppendLogFile + " (fsync " + config.ramAppendLogFsync + ")" : "disabled") << std::endl;
         std::cout << "  Disk DB file:      " << config.dbFile << std::endl;
+        std::cout << "  Disk backend:      " << config.diskBackend << std::endl;
+        std::cout << "  Disk shards:       " << config.diskShards << std::endl;
         std::cout << "  Socket path:       " << config.socketPath << std::endl;
+        std::cout << "  Write-behind:      " << (config.writeBehindEnabled ? "enabled" : "disabled") << std::endl;
+        std::cout << "  Disk compaction:   " << (config.compactionEnabled ? "enabled" : "disabled") << std::endl;
 
         // Hier startet die Anwendung
         EventBus eventBus;
-        RamHandler ramHandler(eventBus, config.maxSizeMB);
-        DiskHandler diskHandler(eventBus, config.dbFile);
+        RamSnapshotOptions snapshot;
+        snapshot.enabled = config.ramSnapshotEnabled;
+        snapshot.file = config.ramSnapshotFile;
+        snapshot.intervalSeconds = config.ramSnapshotIntervalSeconds;
+        snapshot.loadThreads = static_cast<size_t>(config.ramSnapshotLoadThreads);
+        RamOpLogOptions opLog;
+        opLog.enabled = config.ramAppendLogEnabled;
+        opLog.file = config.ramAppendLogFile;
+        opLog.fsync = config.ramAppendLogFsync == "always" ? OpLogFsync::Always
+                    : config.ramAppendLogFsync == "never" ? OpLogFsync::Never : OpLogFsync::EverySecond;
+        opLog.rewriteMinBytes = static_cast<uint64_t>(config.ramAppendLogRewriteMinBytes);
+        opLog.rewriteGrowthPercent = config.ramAppendLogRewriteGrowthPercent;
+        RamHandler ramHandler(eventBus, config.maxSizeMB, snapshot, opLog);
+        DiskCompactionOptions compaction;
+        compaction.enabled = config.compactionEnabled;
+        compaction.intervalMs = config.compactionIntervalMs;
+        compaction.stepPauseMs = config.compactionStepPauseMs;
+        compaction.maxBytesPerStep = static_cast<uint64_t>(config.compactionMaxBytesPerStep);
+        compaction.convertExisting = config.compactionConvertExisting;
+        DiskHandler diskHandler(eventBus, config.dbFile, config.diskBackend, static_cast<size_t>(config.diskShards), compaction);
         SocketHandler socketHandler(config.socketPath, eventBus);
-        StorageHandler storageHandler(eventBus);
-        socketHandler.run();  // Blockierende Methode, die auf Verbindungen wartet
-
+        WriteBehindOptions writeBehind;
+        writeBehind.enabled = config.writeBehindEnabled;
+        writeBehind.maxLagMs = config.writeBehindMaxLagMs;
+        writeBehind.maxPendingEntries = static_cast<size_t>(config.writeBehindMaxPending);
+        StorageHandler storageHandler(eventBus, writeBehind);
+        runningSocketHandler = &socketHandler;
+        std::signal(SIGINT, handleShutdownSignal);
+        std::signal(SIGTERM, handleShutdownSignal);
         std::cout << "AdvancedCacheManager startet..." << std::endl;
+        socketHandler.run();  // Blockiert bis stop(); kehrt erst zurück, wenn alle Client-Threads beendet sind
+        runningSocketHandler = nullptr;
+        std::cout << "AdvancedCacheManager wird beendet..." << std::endl;
 
     } catch (const std::exception& ex) {
         std::cerr << "Fehler beim Laden der Konfiguration: " << ex.what() << std::endl;
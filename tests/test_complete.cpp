@@ -10,6 +10,15 @@
 #include <cstring>
 #include <nlohmann/json.hpp>
 #include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <functional>
+#include <atomic>
+#include <future>
+#include <queue>
+#include <fstream>
+#include <ctime>
+#include <optional>
 
 // Projekt‑spezifische Header (achte auf korrekte Pfade in deinem Projekt)
 #include "config/ConfigHandler.h"
@@ -17,6 +26,7 @@
 #include "storage/RamHandler.h"
 #include "storage/DiskHandler.h"
 #include "storage/StorageHandler.h"
+#include "storage/DumpFile.h"
 #include "network/UnixSocket.h" // Enthält unter anderem die Definition von SocketHandler
 
 namespace fs = std::filesystem;
@@ -96,7 +106,13 @@ void startServer() {
         // Initialisiere die benötigten Handler
         EventBus eventBus;
         RamHandler ramHandler(eventBus, config.maxSizeMB);
-        DiskHandler diskHandler(eventBus, config.dbFile);
+        DiskCompactionOptions compaction;
+        compaction.enabled = config.compactionEnabled;
+        compaction.intervalMs = config.compactionIntervalMs;
+        compaction.stepPauseMs = config.compactionStepPauseMs;
+        compaction.maxBytesPerStep = static_cast<uint64_t>(config.compactionMaxBytesPerStep);
+        compaction.convertExisting = config.compactionConvertExisting;
+        DiskHandler diskHandler(eventBus, config.dbFile, config.diskBackend, static_cast<size_t>(config.diskShards), compaction);
         StorageHandler storageHandler(eventBus);
         SocketHandler socketHandler(config.socketPath, eventBus);
 
@@ -110,6 +126,198 @@ void startServer() {
     }
 }
 
+// Prüft das gemeinsame Verhalten aller StorageEngine-Implementierungen.
+void checkEngineConformance(StorageEngine& engine) {
+    const std::string prefix = std::string("conf_") + engine.name() + "_";
+    std::string value;
+
+    assert(!engine.get(prefix + "missing", value));
+    assert(engine.erase(prefix + "missing") == 0);
+
+    engine.put(prefix + "a", "1", "confGroupA", 0);
+    engine.put(prefix + "b", "2", "confGroupA", 0);
+    engine.put(prefix + "c", "3", "confGroupB", 0);
+    assert(engine.get(prefix + "a", value) && value == "1");
+
+    // Überschreiben ersetzt Wert und Gruppe.
+    engine.put(prefix + "b", "22", "confGroupB", 0);
+    assert(engine.get(prefix + "b", value) && value == "22");
+    assert(engine.getGroup("confGroupA").size() == 1);
+    assert(engine.getGroup("confGroupB").size() == 2);
+
+    // Leere Werte sind gültige Werte.
+    engine.put(prefix + "empty", "", "confGroupC", 0);
+    assert(engine.get(prefix + "empty", value) && value.empty());
+
+    size_t seen = 0;
+    engine.forEach([&](const StorageEntry& entry) {
+        if (entry.key.rfind(prefix, 0) == 0) {
+            seen++;
+            if (entry.key == prefix + "c") assert(entry.value == "3" && entry.group == "confGroupB");
+        }
+    });
+    assert(seen == 4);
+    assert(engine.stats().entries >= 4);
+
+    // Inkrementeller Scan in Schlüsselreihenfolge mit kleinen Chunks.
+    std::vector<std::string> scanned;
+    std::string from;
+    while (true) {
+        auto chunk = engine.scan(from, 3);
+        for (const auto& entry : chunk) {
+            assert(scanned.empty() || scanned.back() < entry.key);
+            scanned.push_back(entry.key);
+        }
+        if (chunk.size() < 3) break;
+        from = StorageEngine::scanSuccessor(chunk.back().key);
+    }
+    assert(std::count_if(scanned.begin(), scanned.end(), [&](const std::string& key) { return key.rfind(prefix, 0) == 0; }) == 4);
+
+    // Batch-Operationen: Ergebnisse in Anfragereihenfolge, doppelte und fehlende Schlüssel.
+    engine.putBatch({ { prefix + "x", "10", "confGroupD", 0 }, { prefix + "y", "20", "confGroupD", 0 } });
+    const std::vector<std::string> batchKeys = { prefix + "x", prefix + "missing", prefix + "y", prefix + "x" };
+    const auto values = engine.getBatch(batchKeys);
+    assert(values.size() == 4 && values[0] == "10" && !values[1] && values[2] == "20" && values[3] == "10");
+    assert(engine.eraseBatch(batchKeys) == 2);
+    assert(!engine.get(prefix + "x", value) && !engine.get(prefix + "y", value));
+    assert(engine.getBatch({}).empty() && engine.eraseBatch({}) == 0);
+
+    assert(engine.erase(prefix + "a") == 1);
+    assert(!engine.get(prefix + "a", value));
+    assert(engine.getGroup("confGroupA").empty());
+    assert(engine.eraseGroup("confGroupB") == 2);
+    assert(engine.eraseGroup("confGroupB") == 0);
+    assert(engine.erase(prefix + "empty") == 1);
+    std::cout << "  " << engine.name() << ": Konformität OK" << std::endl;
+}
+
+// Misst PUT, GET und ERASE direkt auf einer StorageEngine.
+void benchmarkEngine(StorageEngine& engine, int numEntries) {
+    const std::string prefix = std::string("bench_") + engine.name() + "_";
+
+    auto putStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numEntries; i++) {
+        engine.put(prefix + std::to_string(i), "bench_value_" + std::to_string(i), "benchGroup", 0);
+    }
+    auto getStart = std::chrono::high_resolution_clock::now();
+    std::string value;
+    for (int i = 0; i < numEntries; i++) {
+        assert(engine.get(prefix + std::to_string(i), value) && value == "bench_value_" + std::to_string(i));
+    }
+    StorageStats stats = engine.stats();
+    auto eraseStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numEntries; i++) {
+        assert(engine.erase(prefix + std::to_string(i)) == 1);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "  " << engine.name() << ": PUT " << std::chrono::duration<double>(getStart - putStart).count()
+              << " s, GET " << std::chrono::duration<double>(eraseStart - getStart).count()
+              << " s, ERASE " << std::chrono::duration<double>(end - eraseStart).count()
+              << " s, " << stats.entries << " Einträge / " << stats.bytes << " Bytes" << std::endl;
+}
+
+// Nachrichten für den Dispatch-Benchmark der EventBus (Test 39).
+struct PingMessage : public Message {
+    int value = 0;
+};
+
+struct InlinePingMessage : public Message {
+    int value = 0;
+};
+
+struct PongMessage : public Message {
+    int value = 0;
+};
+
+// Nachricht mit großem Inhalt für das Senden mit Eigentumsübergabe (Test 46).
+struct PayloadMessage : public Message {
+    std::string payload;
+};
+
+// Mittlere Round-Trip-Zeit von send().get() in Mikrosekunden.
+template <typename TMsg>
+double measureRoundTrip(EventBus& eventBus, HandlerID id, int rounds) {
+    TMsg msg;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        msg.value = i;
+        assert(eventBus.send<PongMessage>(id, msg).get().value == i + 1);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+}
+
+// Zählt die Heap-Allokationen aller Threads, die trackAllocations gesetzt haben (Test 43).
+// Global, weil der Server-Thread parallel läuft und nicht mitgezählt werden soll.
+std::atomic<long long> trackedAllocations{0};
+thread_local bool trackAllocations = false;
+
+void* operator new(std::size_t size) {
+    if (trackAllocations) trackedAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+
+// Koroutinen für Test 47: warten auf Ergebnisse, ohne einen Thread zu blockieren.
+EventBusResult<int> doubleLater(EventBusResult<int> input) {
+    const int value = co_await input;
+    co_return value * 2;
+}
+
+EventBusResult<PongMessage> pingTwice(EventBus& eventBus, const PingMessage& msg) {
+    PongMessage first = co_await eventBus.send<PongMessage>(HandlerID::RamHandler, msg);
+    PingMessage next;
+    next.value = first.value;
+    PongMessage second = co_await eventBus.send<PongMessage>(HandlerID::RamHandler, std::move(next));
+    co_return second;
+}
+
+// Durchsatz einer Queue mit producers Erzeugern und consumers Verbrauchern in Mio. Operationen/s.
+// Jedes Element zählt als ein Push und ein Pop; Verbraucher enden bei einem Element 0.
+template <typename Push, typename Pop>
+double measureQueueThroughput(int producers, int consumers, int itemsPerProducer, Push push, Pop pop) {
+    std::vector<long long> sums(consumers, 0);
+    std::vector<std::thread> producerThreads;
+    std::vector<std::thread> consumerThreads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int c = 0; c < consumers; c++) {
+        consumerThreads.emplace_back([&, c] {
+            long long sum = 0;
+            int value = 0;
+            while (true) {
+                if (!pop(value)) {
+                    std::this_thread::yield();
+                } else if (value == 0) {
+                    break;
+                } else {
+                    sum += value;
+                }
+            }
+            sums[c] = sum;
+        });
+    }
+    for (int p = 0; p < producers; p++) {
+        producerThreads.emplace_back([&] {
+            for (int i = 1; i <= itemsPerProducer; i++) {
+                while (!push(i)) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& thread : producerThreads) thread.join();
+    for (int c = 0; c < consumers; c++) {
+        while (!push(0)) std::this_thread::yield();
+    }
+    for (auto& thread : consumerThreads) thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    long long total = 0;
+    for (long long sum : sums) total += sum;
+    assert(total == static_cast<long long>(producers) * itemsPerProducer * (itemsPerProducer + 1) / 2);
+    return 2.0 * producers * itemsPerProducer / seconds / 1e6;
+}
+
 int main() {
     // Starte den Server in einem eigenen Thread.
     std::thread serverThread(startServer);
@@ -769,6 +977,1813 @@ int main() {
             assert(parallelTime > 0);
         }
 
+        // -----------------------------
+        // Test 24: Write-Behind für persistente SETs (eigener EventBus)
+        // -----------------------------
+        {
+            const std::string dbFile = "db/write_behind_test.db";
+            fs::remove(dbFile);
+            {
+                EventBus bus;
+                RamHandler ram(bus, 10);
+                DiskHandler disk(bus, dbFile);
+                WriteBehindOptions options;
+                options.enabled = true;
+                options.maxLagMs = 50;
+                options.maxPendingEntries = 4;
+                StorageHandler storage(bus, options);
+
+                for (int i = 0; i < 10; i++) {
+                    SetEventMessage set;
+                    set.id = "wb_set_" + std::to_string(i);
+                    set.persistent = true;
+                    set.ttl = 0;
+                    set.key = "wb_key_" + std::to_string(i);
+                    set.value = "wb_value_" + std::to_string(i);
+                    set.group = "wbGroup";
+                    auto resp = bus.send<SetResponseMessage>(HandlerID::StorageHandler, set).get();
+                    assert(resp.id == set.id);
+                    assert(resp.response == true);
+                }
+
+                // Sofort lesbar, unabhängig davon, ob bereits geflusht wurde.
+                GetKeyEventMessage get;
+                get.id = "wb_get";
+                get.key = "wb_key_9";
+                assert(bus.send<GetKeyResponseMessage>(HandlerID::StorageHandler, get).get().response == "wb_value_9");
+
+                GetGroupEventMessage group;
+                group.id = "wb_group";
+                group.group = "wbGroup";
+                assert(bus.send<GetGroupResponseMessage>(HandlerID::StorageHandler, group).get().response.size() == 10);
+
+                DeleteKeyEventMessage del;
+                del.id = "wb_del";
+                del.key = "wb_key_0";
+                assert(bus.send<DeleteKeyResponseMessage>(HandlerID::StorageHandler, del).get().response == 1);
+
+                // Letzter SET direkt vor dem Shutdown muss durch den Flush beim Beenden persistiert werden.
+                SetEventMessage last;
+                last.id = "wb_last";
+                last.persistent = true;
+                last.ttl = 0;
+                last.key = "wb_key_last";
+                last.value = "wb_value_last";
+                last.group = "wbGroup";
+                bus.send<SetResponseMessage>(HandlerID::StorageHandler, last).get();
+            }
+            {
+                EventBus bus;
+                DiskHandler disk(bus, dbFile);
+                GetGroupEventMessage group;
+                group.id = "wb_group_after";
+                group.group = "wbGroup";
+                auto resp = bus.send<GetGroupResponseMessage>(HandlerID::DiskHandler, group).get();
+                std::cout << "Test24 - Write-Behind persistierte Einträge: " << resp.response.size() << std::endl;
+                assert(resp.response.size() == 10);
+
+                GetKeyEventMessage get;
+                get.id = "wb_get_after";
+                get.key = "wb_key_last";
+                assert(bus.send<GetKeyResponseMessage>(HandlerID::DiskHandler, get).get().response == "wb_value_last");
+                get.key = "wb_key_0";
+                assert(bus.send<GetKeyResponseMessage>(HandlerID::DiskHandler, get).get().response.empty());
+            }
+            fs::remove(dbFile);
+
+            // SET während des Herunterfahrens und fehlgeschlagener letzter Flush (Disk-Handler als Attrappe)
+            {
+                EventBus bus;
+                std::mutex diskMutex;
+                std::condition_variable diskCv;
+                bool diskBlocked = true;
+                int failures = 0;
+                std::vector<std::string> written;
+                bus.subscribe<SetEventMessage, SetResponseMessage>(HandlerID::DiskHandler,
+                    std::function<SetResponseMessage(const SetEventMessage&)>([&](const SetEventMessage& set) {
+                        std::unique_lock<std::mutex> lock(diskMutex);
+                        diskCv.wait(lock, [&] { return !diskBlocked; });
+                        if (failures > 0) {
+                            failures--;
+                            throw std::runtime_error("Disk nicht erreichbar");
+                        }
+                        written.push_back(set.key);
+                        SetResponseMessage resp;
+                        resp.response = true;
+                        return resp;
+                    }));
+
+                WriteBehindOptions options;
+                options.enabled = true;
+                options.maxLagMs = 10;
+                options.maxPendingEntries = 1;
+                SetEventMessage set;
+                set.persistent = true;
+                set.ttl = 0;
+                set.value = "wb_value";
+                set.group = "wbStop";
+
+                // Der Writer hängt im Flush des ersten Eintrags, der zweite SET wartet auf Platz.
+                auto queue = std::make_unique<WriteBehindQueue>(bus, options);
+                WriteBehindQueue* running = queue.get();
+                set.key = "wb_stop_1";
+                assert(running->enqueue(set));
+                std::promise<bool> accepted;
+                std::thread producer([&accepted, running, set]() mutable {
+                    set.key = "wb_stop_2";
+                    accepted.set_value(running->enqueue(set));
+                });
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                std::thread stopper([&queue] { queue.reset(); });
+                // Beim Herunterfahren wird der wartende SET abgelehnt statt bestätigt und verloren.
+                assert(accepted.get_future().get() == false);
+                {
+                    std::lock_guard<std::mutex> lock(diskMutex);
+                    diskBlocked = false;
+                }
+                diskCv.notify_all();
+                producer.join();
+                stopper.join();
+                assert(written == std::vector<std::string>{"wb_stop_1"});
+
+                // Scheitert der letzte Flush, wird er wiederholt statt die Einträge zu verwerfen.
+                failures = 1;
+                options.maxLagMs = 60000;
+                options.maxPendingEntries = 100;
+                {
+                    WriteBehindQueue last(bus, options);
+                    set.key = "wb_retry";
+                    assert(last.enqueue(set));
+                }
+                assert(failures == 0);
+                assert(written.back() == "wb_retry");
+
+                // flush() und erase() warten nicht auf einen laufenden Flush, sondern werden danach erfüllt.
+                {
+                    std::lock_guard<std::mutex> lock(diskMutex);
+                    diskBlocked = true;
+                }
+                {
+                    WriteBehindQueue async(bus, options);
+                    set.key = "wb_async";
+                    assert(async.enqueue(set));
+                    EventBusResult<void> flushed = async.flush();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    EventBusResult<int> erased = async.erase("wb_async");
+                    assert(!flushed.ready() && !erased.ready());
+                    {
+                        std::lock_guard<std::mutex> lock(diskMutex);
+                        diskBlocked = false;
+                    }
+                    diskCv.notify_all();
+                    flushed.get();
+                    // Der Eintrag war bereits geschrieben, als das Löschen angewendet wurde.
+                    assert(erased.get() == 0);
+                    assert(written.back() == "wb_async");
+                }
+            }
+            std::cout << "Test24 - Write-Behind beim Herunterfahren OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 25: Bitcask-Backend (Neustart über Hint-Dateien, Kompaktierung)
+        // -----------------------------
+        {
+            const std::string dir = "db/bitcask_test";
+            fs::remove_all(dir);
+            BitcaskOptions options;
+            options.maxSegmentBytes = 4096;
+            options.syncOnWrite = false;
+            options.compactionIntervalMs = 50;
+            {
+                BitcaskEngine engine(dir, options);
+                // Viele Überschreibungen erzeugen tote Records in versiegelten Segmenten.
+                for (int round = 0; round < 20; round++) {
+                    for (int i = 0; i < 20; i++) {
+                        engine.put("bc_key_" + std::to_string(i), "bc_value_" + std::to_string(round), "bcGroup", 0);
+                    }
+                }
+                assert(engine.erase("bc_key_0") == 1);
+                assert(engine.erase("bc_key_0") == 0);
+                std::string value;
+                assert(engine.get("bc_key_5", value) && value == "bc_value_19");
+                assert(engine.getGroup("bcGroup").size() == 19);
+                // Der Kompaktierungsthread räumt die versiegelten Segmente im Hintergrund auf.
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            }
+            size_t segmentFiles = 0;
+            for (const auto& file : fs::directory_iterator(dir)) {
+                if (file.path().extension() == ".data") segmentFiles++;
+            }
+            std::cout << "Test25 - Bitcask Segmente nach Kompaktierung: " << segmentFiles << std::endl;
+            assert(segmentFiles < 10);
+            {
+                BitcaskEngine engine(dir, options);
+                std::string value;
+                assert(!engine.get("bc_key_0", value));
+                assert(engine.get("bc_key_19", value) && value == "bc_value_19");
+                assert(engine.getGroup("bcGroup").size() == 19);
+                assert(engine.eraseGroup("bcGroup") == 19);
+            }
+            {
+                BitcaskEngine engine(dir, options);
+                assert(engine.getGroup("bcGroup").empty());
+            }
+            fs::remove_all(dir);
+
+            // Tombstones verschwinden, sobald die Segmente mit den gelöschten Werten kompaktiert sind,
+            // auch wenn ältere, überwiegend lebende Segmente bestehen bleiben.
+            options.compactionIntervalMs = 20;
+            auto tombstonesOnDisk = [&dir]() {
+                for (const auto& file : fs::directory_iterator(dir)) {
+                    if (file.path().extension() != ".data") continue;
+                    std::ifstream in(file.path(), std::ios::binary);
+                    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                    if (data.find("bc_tmp_") != std::string::npos) return true;
+                }
+                return false;
+            };
+            {
+                BitcaskEngine engine(dir, options);
+                // Je vier Werte füllen ein Segment, die später gelöschten Werte liegen also in eigenen Segmenten.
+                for (int i = 0; i < 8; i++) {
+                    engine.put("bc_tmp_" + std::to_string(i), std::string(1000, 't'), "tmp", 0);
+                }
+                for (int i = 0; i < 60; i++) {
+                    engine.put("bc_live_" + std::to_string(i), std::string(100, 'l'), "live", 0);
+                }
+                // Die Tombstones landen in Segmenten, die sonst nur überschriebene Werte enthalten.
+                auto churn = [&engine]() {
+                    for (int i = 0; i < 20; i++) {
+                        engine.put("bc_churn_" + std::to_string(i), std::string(100, 'c'), "churn", 0);
+                    }
+                };
+                for (int round = 0; round < 5; round++) {
+                    churn();
+                }
+                for (int i = 0; i < 8; i++) {
+                    assert(engine.erase("bc_tmp_" + std::to_string(i)) == 1);
+                }
+                bool cleared = false;
+                for (int round = 0; round < 200 && !cleared; round++) {
+                    churn();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    cleared = !tombstonesOnDisk();
+                }
+                assert(cleared);
+                assert(engine.getGroup("live").size() == 60);
+            }
+            {
+                BitcaskEngine engine(dir, options);
+                std::string value;
+                assert(!engine.get("bc_tmp_3", value));
+                assert(engine.getGroup("tmp").empty());
+                assert(engine.getGroup("live").size() == 60);
+            }
+            fs::remove_all(dir);
+            std::cout << "Test25 - Bitcask Tombstones nach Kompaktierung entfernt" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 26: LSM-Backend (Memtable-Flush, Kompaktierung, WAL-Recovery)
+        // -----------------------------
+        {
+            const std::string dir = "db/lsm_test";
+            fs::remove_all(dir);
+            LsmOptions options;
+            options.memtableBytes = 2048;
+            options.syncOnWrite = false;
+            options.level0CompactionTrigger = 2;
+            options.level1Bytes = 1024;
+            {
+                LsmEngine engine(dir, options);
+                for (int round = 0; round < 10; round++) {
+                    for (int i = 0; i < 100; i++) {
+                        engine.put("lsm_key_" + std::to_string(i), "lsm_value_" + std::to_string(round),
+                                   (i % 2 == 0) ? "lsmEven" : "lsmOdd", 0);
+                    }
+                }
+                assert(engine.erase("lsm_key_0") == 1);
+                assert(engine.erase("lsm_key_0") == 0);
+                std::string value;
+                assert(engine.get("lsm_key_42", value) && value == "lsm_value_9");
+                assert(!engine.get("lsm_key_0", value));
+                assert(engine.getGroup("lsmEven").size() == 49);
+                assert(engine.eraseGroup("lsmOdd") == 50);
+                // Letzter Schreibvorgang bleibt nur im WAL und muss beim Neustart wiederhergestellt werden.
+                engine.put("lsm_wal_only", "from_wal", "lsmWal", 0);
+            }
+            {
+                LsmEngine engine(dir, options);
+                std::string value;
+                assert(engine.get("lsm_wal_only", value) && value == "from_wal");
+                assert(engine.get("lsm_key_98", value) && value == "lsm_value_9");
+                assert(!engine.get("lsm_key_1", value));
+                assert(engine.getGroup("lsmEven").size() == 49);
+                assert(engine.getGroup("lsmOdd").empty());
+            }
+            std::cout << "Test26 - LSM Neustart erfolgreich." << std::endl;
+            fs::remove_all(dir);
+        }
+
+        // -----------------------------
+        // Test 27: Gemeinsame Konformitäts- und Performance-Suite für alle StorageEngines
+        // -----------------------------
+        {
+            constexpr int numEntries = 500;
+            const std::string base = "db/engine_suite";
+            fs::remove_all(base);
+            fs::create_directories(base);
+            std::vector<std::unique_ptr<StorageEngine>> engines;
+            engines.push_back(std::make_unique<RamEngine>(64 * 1024 * 1024));
+            engines.push_back(std::make_unique<SqliteEngine>(base + "/suite.db"));
+            engines.push_back(std::make_unique<BitcaskEngine>(base + "/bitcask"));
+            engines.push_back(std::make_unique<LsmEngine>(base + "/lsm"));
+            engines.push_back(std::make_unique<MmapHashEngine>(base + "/mmap"));
+
+            std::cout << "\n=== StorageEngine-Benchmark (" << numEntries << " PUT / GET / ERASE) ===" << std::endl;
+            for (auto& engine : engines) {
+                checkEngineConformance(*engine);
+                benchmarkEngine(*engine, numEntries);
+            }
+            std::cout << "=============================\n" << std::endl;
+            engines.clear();
+            fs::remove_all(base);
+        }
+
+        // -----------------------------
+        // Test 28: mmap-Hash-Backend (Tabellenwachstum, Redo-Log-Recovery)
+        // -----------------------------
+        {
+            const std::string dir = "db/mmap_test";
+            const std::string crashDir = "db/mmap_crash_test";
+            fs::remove_all(dir);
+            fs::remove_all(crashDir);
+            MmapHashOptions options;
+            options.initialCapacity = 16;
+            options.syncOnWrite = false;
+            {
+                MmapHashEngine engine(dir, options);
+                // Mehr Schlüssel als Slots erzwingen mehrere Neuaufbauten der Tabelle.
+                for (int i = 0; i < 300; i++) {
+                    engine.put("mh_key_" + std::to_string(i), "mh_value_" + std::to_string(i), "mhGroup", 0);
+                }
+                assert(engine.stats().entries == 300);
+            }
+            fs::path tableFile;
+            for (const auto& file : fs::directory_iterator(dir)) {
+                if (file.path().extension() == ".mht") tableFile = file.path();
+            }
+            assert(!tableFile.empty());
+            // Stand des letzten Checkpoints sichern: simuliert einen Absturz, bei dem
+            // keine der späteren Seiten des Mappings auf die Platte gelangt ist.
+            fs::create_directories(crashDir);
+            fs::copy_file(tableFile, fs::path(crashDir) / tableFile.filename());
+            {
+                MmapHashEngine engine(dir, options);
+                std::string value;
+                assert(engine.get("mh_key_299", value) && value == "mh_value_299");
+                engine.put("mh_key_0", "mh_updated", "mhGroup", 0);
+                assert(engine.erase("mh_key_1") == 1);
+                engine.put("mh_new", "mh_new_value", "mhOther", 0);
+                fs::copy_file(fs::path(dir) / "redo.log", fs::path(crashDir) / "redo.log");
+            }
+            for (const std::string& path : { dir, crashDir }) {
+                MmapHashEngine engine(path, options);
+                std::string value;
+                assert(engine.get("mh_key_0", value) && value == "mh_updated");
+                assert(!engine.get("mh_key_1", value));
+                assert(engine.get("mh_new", value) && value == "mh_new_value");
+                assert(engine.getGroup("mhGroup").size() == 299);
+                assert(engine.eraseGroup("mhGroup") == 299);
+                assert(engine.stats().entries == 1);
+            }
+            std::cout << "Test28 - mmap-Hash Redo-Log-Recovery erfolgreich." << std::endl;
+            fs::remove_all(dir);
+            fs::remove_all(crashDir);
+        }
+
+        // -----------------------------
+        // Test 29: IoRing (io_uring bzw. Thread-Pool-Fallback) und Bitcask darauf
+        // -----------------------------
+        {
+            const std::string file = "db/io_ring_test.dat";
+            for (bool useIoUring : { true, false }) {
+                IoRing io(64, 4, useIoUring);
+                int fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+                assert(fd >= 0);
+                // Viele gleichzeitig ausstehende Schreib- und Leseoperationen.
+                constexpr int blocks = 200;
+                std::vector<std::string> data(blocks);
+                std::vector<std::future<ssize_t>> pending;
+                for (int i = 0; i < blocks; i++) {
+                    data[i] = std::string(64, static_cast<char>('a' + i % 26));
+                    pending.push_back(io.write(fd, data[i].data(), data[i].size(), uint64_t(i) * 64));
+                }
+                for (auto& f : pending) assert(f.get() == 64);
+                assert(io.fsync(fd).get() == 0);
+                pending.clear();
+                std::vector<std::string> readBack(blocks, std::string(64, '\0'));
+                for (int i = 0; i < blocks; i++) {
+                    pending.push_back(io.read(fd, readBack[i].data(), 64, uint64_t(i) * 64));
+                }
+                for (auto& f : pending) assert(f.get() == 64);
+                assert(readBack == data);
+                assert(io.read(-1, readBack[0].data(), 64, 0).get() == -EBADF);
+                ::close(fd);
+                std::cout << "Test29 - IoRing (" << io.backend() << ") erfolgreich." << std::endl;
+            }
+            fs::remove(file);
+
+            const std::string dir = "db/bitcask_io_test";
+            fs::remove_all(dir);
+            BitcaskOptions options;
+            options.useIoUring = false;
+            options.ioQueueDepth = 8;
+            {
+                BitcaskEngine engine(dir, options);
+                checkEngineConformance(engine);
+                for (int i = 0; i < 50; i++) {
+                    engine.put("io_key_" + std::to_string(i), "io_value_" + std::to_string(i), "ioGroup", 0);
+                }
+                assert(engine.getGroup("ioGroup").size() == 50);
+            }
+            fs::remove_all(dir);
+        }
+
+        // -----------------------------
+        // Test 30: Nach Key-Hash geshardete SQLite-Datenbanken
+        // -----------------------------
+        {
+            const std::string dir = "db/shard_test";
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+            auto openShards = [&](size_t count, const std::string& name) {
+                std::vector<std::unique_ptr<StorageEngine>> shards;
+                for (size_t i = 0; i < count; i++) {
+                    shards.push_back(std::make_unique<SqliteEngine>(dir + "/" + name + "-shard" + std::to_string(i) + ".db"));
+                }
+                return std::make_unique<ShardedEngine>(std::move(shards));
+            };
+            {
+                auto engine = openShards(4, "store");
+                checkEngineConformance(*engine);
+                std::vector<int> perShard(4, 0);
+                for (int i = 0; i < 100; i++) {
+                    const std::string key = "shard_key_" + std::to_string(i);
+                    engine->put(key, "shard_value_" + std::to_string(i), (i % 2 == 0) ? "shardEven" : "shardOdd", 0);
+                    perShard[engine->shardOf(key)]++;
+                }
+                for (int count : perShard) assert(count > 0);
+                assert(engine->stats().entries == 100);
+            }
+            {
+                // Neu geöffnet landet jeder Schlüssel wieder im selben Shard.
+                auto engine = openShards(4, "store");
+                std::string value;
+                assert(engine->get("shard_key_42", value) && value == "shard_value_42");
+                assert(engine->getGroup("shardEven").size() == 50);
+                assert(engine->eraseGroup("shardOdd") == 50);
+                assert(engine->stats().entries == 50);
+            }
+
+            // Parallele Schreiber: ein Writer-Lock vs. vier Shards.
+            constexpr int writers = 4;
+            constexpr int perWriter = 100;
+            for (size_t shardCount : { size_t(1), size_t(4) }) {
+                auto engine = openShards(shardCount, "bench" + std::to_string(shardCount));
+                auto start = std::chrono::high_resolution_clock::now();
+                std::vector<std::thread> threads;
+                for (int w = 0; w < writers; w++) {
+                    threads.emplace_back([&engine, w] {
+                        for (int i = 0; i < perWriter; i++) {
+                            engine->put("w" + std::to_string(w) + "_" + std::to_string(i), "value", "benchGroup", 0);
+                        }
+                    });
+                }
+                for (auto& t : threads) t.join();
+                auto end = std::chrono::high_resolution_clock::now();
+                assert(engine->getGroup("benchGroup").size() == writers * perWriter);
+                std::cout << "Test30 - " << shardCount << " SQLite-Shard(s): " << writers * perWriter << " parallele SETs in "
+                          << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+            }
+            fs::remove_all(dir);
+        }
+
+        // -----------------------------
+        // Test 31: Inkrementelles Vacuum nach DELETE GROUP (Hintergrund-Kompaktierung im DiskHandler)
+        // -----------------------------
+        {
+            const std::string dbFile = "db/vacuum_test.db";
+            fs::remove(dbFile);
+            {
+                EventBus bus;
+                DiskCompactionOptions compaction;
+                compaction.intervalMs = 20;
+                compaction.stepPauseMs = 1;
+                compaction.maxBytesPerStep = 64 * 1024;
+                DiskHandler disk(bus, dbFile, "sqlite", 1, compaction);
+
+                const std::string bigValue(2048, 'v');
+                for (int i = 0; i < 300; i++) {
+                    SetEventMessage set;
+                    set.id = "vacuum_set";
+                    set.persistent = true;
+                    set.ttl = 0;
+                    set.key = "vacuum_key_" + std::to_string(i);
+                    set.value = bigValue;
+                    set.group = "vacuumGroup";
+                    assert(bus.send<SetResponseMessage>(HandlerID::DiskHandler, set).get().response);
+                }
+                const auto sizeBefore = fs::file_size(dbFile);
+                DeleteGroupEventMessage delGroup;
+                delGroup.id = "vacuum_del";
+                delGroup.group = "vacuumGroup";
+                assert(bus.send<DeleteGroupResponseMessage>(HandlerID::DiskHandler, delGroup).get().response == 300);
+
+                // Die Datei schrumpft schrittweise, Anfragen laufen währenddessen weiter.
+                for (int i = 0; i < 200 && disk.compactionMetrics().reclaimedBytes < sizeBefore / 2; i++) {
+                    GetKeyEventMessage get;
+                    get.id = "vacuum_get";
+                    get.key = "vacuum_key_1";
+                    assert(bus.send<GetKeyResponseMessage>(HandlerID::DiskHandler, get).get().response.empty());
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                const DiskCompactionMetrics metrics = disk.compactionMetrics();
+                std::cout << "Test31 - Vacuum: " << sizeBefore << " -> " << fs::file_size(dbFile) << " Bytes, "
+                          << metrics.reclaimedBytes << " Bytes in " << metrics.steps << " Schritten ("
+                          << metrics.timeSpentUs << " us)" << std::endl;
+                assert(metrics.steps > 1);
+                assert(metrics.reclaimedBytes >= sizeBefore / 2);
+                assert(fs::file_size(dbFile) < sizeBefore / 2);
+            }
+            fs::remove(dbFile);
+
+            // Eine bestehende Datenbank ohne inkrementelles Vacuum wird nur auf Wunsch umgestellt
+            auto autoVacuumMode = [&dbFile] {
+                sqlite3* db = nullptr;
+                assert(sqlite3_open(dbFile.c_str(), &db) == SQLITE_OK);
+                sqlite3_stmt* stmt = nullptr;
+                assert(sqlite3_prepare_v2(db, "PRAGMA auto_vacuum;", -1, &stmt, nullptr) == SQLITE_OK);
+                assert(sqlite3_step(stmt) == SQLITE_ROW);
+                const int mode = sqlite3_column_int(stmt, 0);
+                sqlite3_finalize(stmt);
+                sqlite3_close(db);
+                return mode;
+            };
+            {
+                sqlite3* db = nullptr;
+                assert(sqlite3_open(dbFile.c_str(), &db) == SQLITE_OK);
+                assert(sqlite3_exec(db, "CREATE TABLE store (key TEXT PRIMARY KEY, value TEXT, group_name TEXT);"
+                                        "INSERT INTO store VALUES ('alt', 'wert', 'g');", nullptr, nullptr, nullptr) == SQLITE_OK);
+                sqlite3_close(db);
+            }
+            assert(autoVacuumMode() == 0);
+            DiskCompactionOptions convert;
+            convert.convertExisting = true;
+            convert.enabled = false;
+            {
+                EventBus bus;
+                DiskHandler disk(bus, dbFile, "sqlite", 1);
+            }
+            {
+                EventBus bus;
+                DiskHandler disk(bus, dbFile, "sqlite", 1, convert);
+            }
+            assert(autoVacuumMode() == 0);
+            convert.enabled = true;
+            {
+                EventBus bus;
+                DiskHandler disk(bus, dbFile, "sqlite", 1, convert);
+                GetKeyEventMessage get;
+                get.id = "vacuum_get";
+                get.key = "alt";
+                assert(bus.send<GetKeyResponseMessage>(HandlerID::DiskHandler, get).get().response == "wert");
+            }
+            assert(autoVacuumMode() == 2);
+            fs::remove(dbFile);
+        }
+
+        // -----------------------------
+        // Test 32: Bulk-Export/-Import über das Dump-Format (putBatch auf allen Backends)
+        // -----------------------------
+        {
+            const std::string dumpFile = "db/bulk_test.dump";
+            const int numEntries = 20000;
+            {
+                auto source = DiskHandler::openEngine("sqlite", "db/bulk_source.db", 1);
+                std::vector<BatchEntry> batch;
+                for (int i = 0; i < numEntries; i++) {
+                    batch.push_back({"bulk_key_" + std::to_string(i), "bulk_value_" + std::to_string(i),
+                                     i % 2 ? "bulkOdd" : "bulkEven"});
+                }
+                source->putBatch(batch);
+                assert(source->stats().entries == static_cast<uint64_t>(numEntries));
+
+                const BulkTransferStats exported = BulkTransfer::exportDump(*source, dumpFile, true);
+                assert(exported.entries == static_cast<uint64_t>(numEntries));
+                assert(exported.bytes == fs::file_size(dumpFile));
+            }
+
+            for (const std::string backend : {"sqlite", "bitcask", "lsm", "mmap"}) {
+                const std::string dbFile = "db/bulk_target_" + backend + ".db";
+                {
+                    auto target = DiskHandler::openEngine(backend, dbFile, 2);
+                    const BulkTransferStats imported = BulkTransfer::importDump(dumpFile, target.get(), nullptr, 4096);
+                    std::cout << "Test32 - Import (" << backend << "): " << imported.entries << " Einträge in "
+                              << imported.seconds * 1000 << " ms (" << imported.entries / imported.seconds << " Einträge/s)" << std::endl;
+                    assert(imported.entries == static_cast<uint64_t>(numEntries));
+                    assert(imported.skipped == 0);
+                    assert(target->getGroup("bulkOdd").size() == static_cast<size_t>(numEntries / 2));
+                }
+                {
+                    // Nach dem Wiederöffnen sind die Batches dauerhaft vorhanden
+                    auto reopened = DiskHandler::openEngine(backend, dbFile, 2);
+                    std::string value;
+                    assert(reopened->get("bulk_key_12345", value) && value == "bulk_value_12345");
+                    assert(reopened->stats().entries == static_cast<uint64_t>(numEntries));
+                }
+            }
+
+            // Nicht-persistente Einträge ohne Ziel werden übersprungen
+            {
+                RamEngine ram(1024 * 1024);
+                ram.put("volatile_key", "volatile_value", "", 0);
+                BulkTransfer::exportDump(ram, "db/bulk_volatile.dump", false);
+                auto target = DiskHandler::openEngine("sqlite", "db/bulk_volatile.db", 1);
+                const BulkTransferStats stats = BulkTransfer::importDump("db/bulk_volatile.dump", target.get(), nullptr);
+                assert(stats.entries == 0 && stats.skipped == 1);
+            }
+
+            // Abgeschnittene oder beschädigte Dumps werden erkannt
+            const auto size = fs::file_size(dumpFile);
+            fs::resize_file(dumpFile, size - 20);
+            RamEngine sink(64 * 1024 * 1024);
+            bool truncatedDetected = false;
+            try {
+                BulkTransfer::importDump(dumpFile, &sink, &sink);
+            } catch (const std::runtime_error&) {
+                truncatedDetected = true;
+            }
+            assert(truncatedDetected);
+            {
+                std::fstream file(dumpFile, std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(100);
+                file.put('#');
+            }
+            bool corruptDetected = false;
+            try {
+                BulkTransfer::importDump(dumpFile, &sink, &sink);
+            } catch (const std::runtime_error&) {
+                corruptDetected = true;
+            }
+            assert(corruptDetected);
+            std::cout << "Test32 - Bulk-Export/-Import erfolgreich." << std::endl;
+        }
+
+        // -----------------------------
+        // Test 33: RAM-Snapshot und Warmstart (TTL und Gruppe bleiben erhalten)
+        // -----------------------------
+        {
+            RamSnapshotOptions snapshot;
+            snapshot.enabled = true;
+            snapshot.file = "db/ram_snapshot_test.acmdump";
+            snapshot.intervalSeconds = 0;
+            snapshot.loadThreads = 4;
+            fs::remove(snapshot.file);
+            const int numEntries = 50000;
+            {
+                EventBus bus;
+                RamHandler ram(bus, 64, snapshot);
+                std::vector<BatchEntry> batch;
+                for (int i = 0; i < numEntries; i++) {
+                    batch.push_back({"snap_key_" + std::to_string(i), "snap_value_" + std::to_string(i), "snapGroup", 0});
+                }
+                ram.engine().putBatch(batch);
+                ram.engine().put("snap_short", "kurz", "snapTtl", 1);
+                ram.engine().put("snap_long", "lang", "snapTtl", 3600);
+            } // Destruktor schreibt den Snapshot
+            assert(fs::exists(snapshot.file));
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+            {
+                EventBus bus;
+                const auto start = std::chrono::steady_clock::now();
+                RamHandler ram(bus, 64, snapshot);
+                const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Test33 - Warmstart: " << ram.engine().stats().entries << " Einträge in " << loadMs << " ms geladen" << std::endl;
+
+                GetKeyEventMessage get;
+                get.id = "snap_get";
+                get.key = "snap_key_4711";
+                assert(bus.send<GetKeyResponseMessage>(HandlerID::RamHandler, get).get().response == "snap_value_4711");
+                GetGroupEventMessage getGroup;
+                getGroup.id = "snap_group";
+                getGroup.group = "snapGroup";
+                assert(bus.send<GetGroupResponseMessage>(HandlerID::RamHandler, getGroup).get().response.size() == static_cast<size_t>(numEntries));
+
+                // Der während der Downtime abgelaufene Eintrag fehlt, die Rest-TTL des anderen bleibt erhalten
+                std::string value;
+                assert(!ram.engine().get("snap_short", value));
+                bool foundLong = false;
+                for (const auto& entry : ram.engine().snapshot()) {
+                    if (entry.key == "snap_long") {
+                        foundLong = true;
+                        assert(entry.ttlSeconds > 3590 && entry.ttlSeconds <= 3600);
+                    }
+                }
+                assert(foundLong);
+                assert(ram.saveSnapshot() == static_cast<uint64_t>(numEntries + 1));
+            }
+
+            // Ein beschädigter Snapshot wird ignoriert, der Handler startet leer
+            {
+                std::fstream file(snapshot.file, std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(200);
+                file.put('#');
+            }
+            {
+                EventBus bus;
+                RamHandler ram(bus, 64, snapshot);
+                assert(ram.engine().stats().entries == 0);
+            }
+            fs::remove(snapshot.file);
+            std::cout << "Test33 - RAM-Snapshot erfolgreich." << std::endl;
+        }
+
+        // -----------------------------
+        // Test 34: Append-Log für den RAM-Speicher (Replay, abgeschnittenes Ende, Rewrite)
+        // -----------------------------
+        {
+            RamOpLogOptions opLog;
+            opLog.enabled = true;
+            opLog.file = "db/ram_oplog_test.aof";
+            opLog.fsync = OpLogFsync::Always;
+            fs::remove(opLog.file);
+
+            auto sendSet = [](EventBus& bus, const std::string& key, const std::string& value, const std::string& group, int ttl) {
+                SetEventMessage set;
+                set.id = "aof_set";
+                set.persistent = false;
+                set.ttl = ttl;
+                set.key = key;
+                set.value = value;
+                set.group = group;
+                assert(bus.send<SetResponseMessage>(HandlerID::RamHandler, set).get().response);
+            };
+            auto getValue = [](RamHandler& ram, const std::string& key) {
+                std::string value;
+                return ram.engine().get(key, value) ? value : std::string("<fehlt>");
+            };
+
+            {
+                EventBus bus;
+                RamHandler ram(bus, 64, {}, opLog);
+                for (int i = 0; i < 1000; i++) {
+                    sendSet(bus, "aof_key_" + std::to_string(i), "v1_" + std::to_string(i), i < 100 ? "aofDrop" : "aofKeep", 0);
+                }
+                // Überschreiben, löschen, Gruppe löschen, kurze TTL
+                sendSet(bus, "aof_key_500", "v2_500", "aofKeep", 0);
+                DeleteKeyEventMessage delKey;
+                delKey.id = "aof_del";
+                delKey.key = "aof_key_501";
+                assert(bus.send<DeleteKeyResponseMessage>(HandlerID::RamHandler, delKey).get().response == 1);
+                DeleteGroupEventMessage delGroup;
+                delGroup.id = "aof_delgroup";
+                delGroup.group = "aofDrop";
+                assert(bus.send<DeleteGroupResponseMessage>(HandlerID::RamHandler, delGroup).get().response == 100);
+                sendSet(bus, "aof_short", "kurz", "aofKeep", 1);
+            }
+
+            // Abgerissener Schreibvorgang am Ende des Logs
+            const auto intactSize = fs::file_size(opLog.file);
+            {
+                std::ofstream file(opLog.file, std::ios::binary | std::ios::app);
+                file << "abgerissen";
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+            {
+                EventBus bus;
+                RamHandler ram(bus, 64, {}, opLog);
+                assert(fs::file_size(opLog.file) == intactSize);
+                assert(ram.engine().stats().entries == 899);
+                assert(getValue(ram, "aof_key_500") == "v2_500");
+                assert(getValue(ram, "aof_key_501") == "<fehlt>");
+                assert(getValue(ram, "aof_key_50") == "<fehlt>");
+                assert(getValue(ram, "aof_short") == "<fehlt>");
+
+                // Rewrite bei laufenden Schreibzugriffen
+                for (int round = 0; round < 20; round++) {
+                    for (int i = 100; i < 1000; i++) {
+                        sendSet(bus, "aof_key_" + std::to_string(i), "r" + std::to_string(round) + "_" + std::to_string(i), "aofKeep", 0);
+                    }
+                }
+                const uint64_t sizeBefore = ram.opLog()->logSize();
+                std::thread writer([&bus, &sendSet] {
+                    for (int i = 0; i < 2000; i++) {
+                        sendSet(bus, "aof_new_" + std::to_string(i), "neu", "aofNew", 0);
+                    }
+                });
+                const uint64_t sizeAfter = ram.opLog()->rewrite();
+                writer.join();
+                std::cout << "Test34 - Append-Log Rewrite: " << sizeBefore << " -> " << sizeAfter << " Bytes" << std::endl;
+                assert(sizeAfter < sizeBefore / 4);
+            }
+            {
+                // Mit aktivem Append-Log wird kein Snapshot geschrieben, den ohnehin nichts liest
+                RamSnapshotOptions snapshot;
+                snapshot.enabled = true;
+                snapshot.file = "db/ram_snapshot_aof_test.acmdump";
+                fs::remove(snapshot.file);
+                {
+                    EventBus bus;
+                    RamHandler ram(bus, 64, snapshot, opLog);
+                }
+                assert(!fs::exists(snapshot.file));
+            }
+            {
+                EventBus bus;
+                RamHandler ram(bus, 64, {}, opLog);
+                // aof_key_501 wurde in den Runden wieder angelegt
+                assert(ram.engine().stats().entries == 900 + 2000);
+                assert(getValue(ram, "aof_key_500") == "r19_500");
+                assert(getValue(ram, "aof_new_1999") == "neu");
+            }
+            fs::remove(opLog.file);
+            std::cout << "Test34 - Append-Log erfolgreich." << std::endl;
+        }
+
+        // -----------------------------
+        // Test 35: LIST über RAM und Disk, in Chunks bis zum Socket gestreamt
+        // -----------------------------
+        {
+            for (int i = 0; i < 25; i++) {
+                json req = {
+                    {"id", "list_set_" + std::to_string(i)},
+                    {"event", "SET"},
+                    {"flags", {{"persistent", i % 2 == 0}, {"ttl", 3600}}},
+                    {"key", "list_key_" + std::to_string(i)},
+                    {"value", "list_value_" + std::to_string(i)},
+                    {"group", "listGroup"}
+                };
+                assert(json::parse(sendRequest(socketPath, req.dump()))["response"] == true);
+            }
+
+            auto listKeys = [&socketPath](int chunkSize) {
+                json req = { {"id", "list_" + std::to_string(chunkSize)}, {"event", "LIST"}, {"chunkSize", chunkSize} };
+                json resp = json::parse(sendRequest(socketPath, req.dump()));
+                assert(resp["id"] == "list_" + std::to_string(chunkSize));
+                std::vector<std::string> keys;
+                for (const auto& entry : resp["response"]) {
+                    keys.push_back(entry["key"].get<std::string>());
+                    if (keys.back() == "list_key_4") {
+                        assert(entry["value"] == "list_value_4" && entry["group"] == "listGroup");
+                    }
+                }
+                std::sort(keys.begin(), keys.end());
+                return keys;
+            };
+            const auto small = listKeys(7);
+            const auto large = listKeys(100000);
+            std::cout << "Test35 - LIST: " << small.size() << " Einträge (Chunks zu 7 und 100000)" << std::endl;
+            assert(small == large);
+            for (int i = 0; i < 25; i++) {
+                assert(std::binary_search(small.begin(), small.end(), "list_key_" + std::to_string(i)));
+            }
+
+            json badChunk = { {"id", "list_bad"}, {"event", "LIST"}, {"chunkSize", 0} };
+            assert(json::parse(sendRequest(socketPath, badChunk.dump())).contains("error"));
+        }
+
+        // -----------------------------
+        // Test 36: SCAN mit Cursor, Count-Hinweis und Gruppen-/Präfix-Filter über beide Ebenen
+        // -----------------------------
+        {
+            for (int i = 0; i < 50; i++) {
+                json req = {
+                    {"id", "scan_set_" + std::to_string(i)},
+                    {"event", "SET"},
+                    {"flags", {{"persistent", i % 3 == 0}, {"ttl", 3600}}},
+                    {"key", "scan:user:" + std::to_string(i)},
+                    {"value", "profil_" + std::to_string(i)},
+                    {"group", i % 2 ? "scanOdd" : "scanEven"}
+                };
+                assert(json::parse(sendRequest(socketPath, req.dump()))["response"] == true);
+            }
+
+            auto scanAll = [&socketPath](const std::string& prefix, const std::string& group, int count, int& steps) {
+                std::vector<std::string> keys;
+                std::string cursor = "0";
+                steps = 0;
+                do {
+                    json req = { {"id", "scan"}, {"event", "SCAN"}, {"cursor", cursor}, {"count", count} };
+                    if (!prefix.empty()) req["prefix"] = prefix;
+                    if (!group.empty()) req["group"] = group;
+                    json resp = json::parse(sendRequest(socketPath, req.dump()));
+                    assert(resp["response"].size() <= static_cast<size_t>(count));
+                    for (const auto& entry : resp["response"]) {
+                        keys.push_back(entry["key"].get<std::string>());
+                    }
+                    cursor = resp["cursor"].get<std::string>();
+                    steps++;
+                } while (cursor != "0");
+                std::sort(keys.begin(), keys.end());
+                return keys;
+            };
+
+            int steps = 0;
+            const auto all = scanAll("scan:", "", 10, steps);
+            std::cout << "Test36 - SCAN: " << all.size() << " Schlüssel in " << steps << " Schritten" << std::endl;
+            assert(all.size() == 50);
+            assert(std::adjacent_find(all.begin(), all.end()) == all.end());
+            assert(steps >= 5);
+
+            const auto odd = scanAll("scan:", "scanOdd", 7, steps);
+            assert(odd.size() == 25);
+            const auto ones = scanAll("scan:user:1", "", 4, steps);
+            assert(ones.size() == 11);  // 1 und 10-19
+
+            // Ohne Filter enthält der Scan alle Einträge des LIST
+            json listReq = { {"id", "scan_list"}, {"event", "LIST"} };
+            const size_t listed = json::parse(sendRequest(socketPath, listReq.dump()))["response"].size();
+            assert(scanAll("", "", 100, steps).size() == listed);
+
+            json badCursor = { {"id", "scan_bad"}, {"event", "SCAN"}, {"cursor", "x"} };
+            assert(json::parse(sendRequest(socketPath, badCursor.dump())).contains("error"));
+            // Negative Anzahl wird abgelehnt statt als riesiger size_t-Wert durchzulaufen
+            json badCount = { {"id", "scan_bad"}, {"event", "SCAN"}, {"count", -1} };
+            assert(json::parse(sendRequest(socketPath, badCount.dump())).contains("error"));
+        }
+
+        // -----------------------------
+        // Test 37: RANGE und Präfix-Abfragen, sortiert und seitenweise über beide Ebenen
+        // -----------------------------
+        {
+            auto rangeKey = [](int i) {
+                return std::string("range:k:") + (i < 10 ? "0" : "") + std::to_string(i);
+            };
+            for (int i = 0; i < 30; i++) {
+                json req = {
+                    {"id", "range_set_" + std::to_string(i)},
+                    {"event", "SET"},
+                    {"flags", {{"persistent", i % 2 == 0}, {"ttl", 3600}}},
+                    {"key", rangeKey(i)},
+                    {"value", "wert_" + std::to_string(i)},
+                    {"group", "rangeGroup"}
+                };
+                assert(json::parse(sendRequest(socketPath, req.dump()))["response"] == true);
+            }
+
+            auto rangeAll = [&socketPath](json req, size_t limit, int& pages) {
+                std::vector<std::string> keys;
+                pages = 0;
+                req["id"] = "range";
+                req["event"] = "RANGE";
+                req["limit"] = limit;
+                while (true) {
+                    json resp = json::parse(sendRequest(socketPath, req.dump()));
+                    assert(resp["response"].size() <= limit);
+                    for (const auto& entry : resp["response"]) {
+                        keys.push_back(entry["key"].get<std::string>());
+                    }
+                    pages++;
+                    const std::string next = resp["next"].get<std::string>();
+                    if (next.empty()) break;
+                    req["start"] = next;
+                }
+                return keys;
+            };
+
+            int pages = 0;
+            const auto range = rangeAll({ {"start", rangeKey(5)}, {"end", rangeKey(25)} }, 7, pages);
+            std::cout << "Test37 - RANGE: " << range.size() << " Schlüssel in " << pages << " Seiten" << std::endl;
+            assert(range.size() == 20);
+            assert(std::is_sorted(range.begin(), range.end()));
+            assert(std::adjacent_find(range.begin(), range.end()) == range.end());
+            assert(range.front() == rangeKey(5) && range.back() == rangeKey(24));
+            assert(pages >= 3);
+
+            const auto tens = rangeAll({ {"prefix", "range:k:1"} }, 100, pages);
+            assert(tens.size() == 10 && tens.front() == rangeKey(10) && tens.back() == rangeKey(19));
+            assert(pages == 1);
+
+            // Präfix und Bereich werden geschnitten
+            const auto cut = rangeAll({ {"prefix", "range:k:2"}, {"start", rangeKey(15)}, {"end", rangeKey(23)} }, 2, pages);
+            assert(cut.size() == 3 && cut.front() == rangeKey(20));
+
+            json first = { {"id", "range_first"}, {"event", "RANGE"}, {"prefix", "range:"}, {"limit", 1} };
+            json firstResp = json::parse(sendRequest(socketPath, first.dump()));
+            assert(firstResp["response"].size() == 1 && firstResp["response"][0]["key"] == rangeKey(0));
+            assert(firstResp["response"][0]["value"] == "wert_0");
+
+            json badLimit = { {"id", "range_bad"}, {"event", "RANGE"}, {"limit", 0} };
+            assert(json::parse(sendRequest(socketPath, badLimit.dump())).contains("error"));
+            badLimit["limit"] = -1;
+            assert(json::parse(sendRequest(socketPath, badLimit.dump())).contains("error"));
+
+            // scan() der persistenten Backends: geordnete Seiten, auch nach dem Wiederöffnen
+            // (Bitcask über den geordneten Index, LSM über den Merge ab dem Startschlüssel,
+            // mmap über den Schlüsselindex im Speicher)
+            LsmOptions lsmOptions;
+            lsmOptions.memtableBytes = 2048;
+            lsmOptions.syncOnWrite = false;
+            BitcaskOptions bitcaskOptions;
+            bitcaskOptions.syncOnWrite = false;
+            auto openScanEngine = [&](const std::string& backend) -> std::unique_ptr<StorageEngine> {
+                if (backend == "bitcask") return std::make_unique<BitcaskEngine>("db/scan_test.bitcask", bitcaskOptions);
+                if (backend == "lsm") return std::make_unique<LsmEngine>("db/scan_test.lsm", lsmOptions);
+                return std::make_unique<MmapHashEngine>("db/scan_test.mmap");
+            };
+            for (const std::string backend : {"bitcask", "lsm", "mmap"}) {
+                fs::remove_all("db/scan_test." + backend);
+                std::vector<std::string> expected;
+                {
+                    auto engine = openScanEngine(backend);
+                    for (int i = 0; i < 300; i++) {
+                        engine->put(rangeKey(i % 100) + "_" + std::to_string(i / 100), "alt", "scanTest", 0);
+                    }
+                    for (int i = 0; i < 300; i++) {
+                        const std::string key = rangeKey(i % 100) + "_" + std::to_string(i / 100);
+                        if (i % 10 == 0) {
+                            assert(engine->erase(key) == 1);
+                        } else {
+                            engine->put(key, "neu_" + key, "scanTest", 0);
+                            if (key >= rangeKey(20) && key < rangeKey(80)) {
+                                expected.push_back(key);
+                            }
+                        }
+                    }
+                    std::sort(expected.begin(), expected.end());
+                }
+                auto engine = openScanEngine(backend);
+                std::vector<std::string> scanned;
+                int chunks = 0;
+                std::string from = rangeKey(20);
+                while (true) {
+                    const auto chunk = engine->scan(from, 7, rangeKey(80));
+                    for (const auto& entry : chunk) {
+                        assert(entry.value == "neu_" + entry.key && entry.group == "scanTest");
+                        scanned.push_back(entry.key);
+                    }
+                    chunks++;
+                    if (chunk.size() < 7) break;
+                    from = StorageEngine::scanSuccessor(chunk.back().key);
+                }
+                assert(scanned == expected);
+                assert(chunks == static_cast<int>(expected.size() / 7 + 1));
+                engine.reset();
+                fs::remove_all("db/scan_test." + backend);
+            }
+        }
+
+        // -----------------------------
+        // Test 38: MSET / MGET / MDELETE über beide Ebenen und Benchmark nach Batchgröße
+        // -----------------------------
+        {
+            json mset = {
+                {"id", "mset1"},
+                {"event", "MSET"},
+                {"flags", {{"persistent", false}, {"ttl", 3600}}},
+                {"entries", {
+                    {{"key", "batch:ram"}, {"value", "r1"}, {"group", "batchGroup"}},
+                    {{"key", "batch:disk"}, {"value", "d1"}, {"group", "batchGroup"}, {"flags", {{"persistent", true}, {"ttl", 0}}}}
+                }}
+            };
+            json msetResp = json::parse(sendRequest(socketPath, mset.dump()));
+            assert(msetResp["id"] == "mset1" && msetResp["response"] == true);
+
+            json mget = { {"id", "mget1"}, {"event", "MGET"}, {"keys", {"batch:disk", "batch:missing", "batch:ram"}} };
+            json mgetResp = json::parse(sendRequest(socketPath, mget.dump()));
+            std::cout << "Test38 - MGET Response: " << mgetResp.dump() << std::endl;
+            assert(mgetResp["response"] == json::parse(R"(["d1", null, "r1"])"));
+
+            json getGroup = { {"id", "mget_group"}, {"event", "GET GROUP"}, {"group", "batchGroup"} };
+            assert(json::parse(sendRequest(socketPath, getGroup.dump()))["response"].size() == 2);
+
+            json mdel = { {"id", "mdel1"}, {"event", "MDELETE"}, {"keys", {"batch:ram", "batch:disk", "batch:missing"}} };
+            assert(json::parse(sendRequest(socketPath, mdel.dump()))["response"] == 2);
+            assert(json::parse(sendRequest(socketPath, mget.dump()))["response"] == json::parse("[null, null, null]"));
+
+            json badMset = { {"id", "mset_bad"}, {"event", "MSET"}, {"entries", {{{"key", ""}, {"value", "x"}, {"group", "g"}}}} };
+            assert(json::parse(sendRequest(socketPath, badMset.dump())).contains("error"));
+
+            // Gleiche Schlüsselmenge, unterschiedliche Batchgrößen: MSET, MGET, MDELETE.
+            constexpr int numKeys = 1000;
+            std::cout << "\n=== Batch-Benchmark (" << numKeys << " Schlüssel, halb RAM / halb Disk) ===" << std::endl;
+            for (int batchSize : {1, 10, 100, 1000}) {
+                std::vector<std::string> keys;
+                for (int i = 0; i < numKeys; i++) {
+                    keys.push_back("mbench:" + std::to_string(batchSize) + ":" + std::to_string(i));
+                }
+                auto forEachBatch = [&](const std::function<void(int, int)>& fn) {
+                    for (int begin = 0; begin < numKeys; begin += batchSize) {
+                        fn(begin, std::min(numKeys, begin + batchSize));
+                    }
+                };
+
+                auto setStart = std::chrono::high_resolution_clock::now();
+                forEachBatch([&](int begin, int end) {
+                    json req = { {"id", "mbench_set"}, {"event", "MSET"}, {"entries", json::array()} };
+                    for (int i = begin; i < end; i++) {
+                        req["entries"].push_back({ {"key", keys[i]}, {"value", "wert_" + std::to_string(i)}, {"group", "mbench"},
+                                                   {"flags", {{"persistent", i % 2 == 0}, {"ttl", 3600}}} });
+                    }
+                    assert(json::parse(sendRequest(socketPath, req.dump()))["response"] == true);
+                });
+                auto getStart = std::chrono::high_resolution_clock::now();
+                forEachBatch([&](int begin, int end) {
+                    json req = { {"id", "mbench_get"}, {"event", "MGET"}, {"keys", std::vector<std::string>(keys.begin() + begin, keys.begin() + end)} };
+                    json resp = json::parse(sendRequest(socketPath, req.dump()));
+                    for (int i = begin; i < end; i++) {
+                        assert(resp["response"][i - begin] == "wert_" + std::to_string(i));
+                    }
+                });
+                auto delStart = std::chrono::high_resolution_clock::now();
+                forEachBatch([&](int begin, int end) {
+                    json req = { {"id", "mbench_del"}, {"event", "MDELETE"}, {"keys", std::vector<std::string>(keys.begin() + begin, keys.begin() + end)} };
+                    assert(json::parse(sendRequest(socketPath, req.dump()))["response"] == end - begin);
+                });
+                auto end = std::chrono::high_resolution_clock::now();
+
+                auto perKeyUs = [](auto from, auto to) {
+                    return std::chrono::duration<double, std::micro>(to - from).count() / numKeys;
+                };
+                std::cout << "  Batchgröße " << std::setw(4) << batchSize << ": MSET " << perKeyUs(setStart, getStart)
+                          << " us/Schlüssel, MGET " << perKeyUs(getStart, delStart)
+                          << " us/Schlüssel, MDELETE " << perKeyUs(delStart, end) << " us/Schlüssel" << std::endl;
+            }
+            std::cout << "=============================\n" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 39: Inline-Dispatch in der EventBus (Ergebnis, Ausnahmen, Latenz gegenüber dem ThreadPool)
+        // -----------------------------
+        {
+            EventBus eventBus;
+            const std::thread::id caller = std::this_thread::get_id();
+            std::atomic<bool> pooledOnCaller{false};
+            std::atomic<bool> inlineOnCaller{true};
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::EventBus,
+                [&](const PingMessage& msg) -> PongMessage {
+                    if (std::this_thread::get_id() == caller) pooledOnCaller = true;
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                });
+            eventBus.subscribe<InlinePingMessage, PongMessage>(HandlerID::EventBus,
+                [&](const InlinePingMessage& msg) -> PongMessage {
+                    if (std::this_thread::get_id() != caller) inlineOnCaller = false;
+                    if (msg.value < 0) throw std::runtime_error("negativer Wert");
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                },
+                DispatchMode::Inline);
+
+            // Ausnahmen eines Inline-Handlers kommen wie beim ThreadPool erst bei get() an.
+            InlinePingMessage negative;
+            negative.value = -1;
+            auto failed = eventBus.send<PongMessage>(HandlerID::EventBus, negative);
+            bool thrown = false;
+            try {
+                failed.get();
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+
+            constexpr int rounds = 20000;
+            const double pooled = measureRoundTrip<PingMessage>(eventBus, HandlerID::EventBus, rounds);
+            const double inlined = measureRoundTrip<InlinePingMessage>(eventBus, HandlerID::EventBus, rounds);
+            assert(!pooledOnCaller && inlineOnCaller);
+            std::cout << "\n=== EventBus-Dispatch (" << rounds << " Round-Trips) ===" << std::endl;
+            std::cout << "  ThreadPool: " << pooled << " us, Inline: " << inlined << " us pro send().get()" << std::endl;
+            std::cout << "=============================\n" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 40: Fortsetzungen (then / whenAll) und mehr gleichzeitige Anfragen als Pool-Threads
+        // -----------------------------
+        {
+            // then() verkettet, reicht Ausnahmen weiter und entpackt verschachtelte Ergebnisse.
+            EventBusPromise<int> first;
+            EventBusResult<std::string> chained = first.result()
+                .then([](int value) { return value * 2; })
+                .then([](int value) { return makeReadyResult(std::to_string(value)); });
+            assert(!chained.ready());
+            first.setValue(21);
+            assert(chained.ready() && chained.get() == "42");
+
+            EventBusPromise<int> failing;
+            bool called = false;
+            auto failed = failing.result().then([&called](int) { called = true; return 0; });
+            failing.setException(std::make_exception_ptr(std::runtime_error("fehler")));
+            bool thrown = false;
+            try { failed.get(); } catch (const std::runtime_error&) { thrown = true; }
+            assert(thrown && !called);
+
+            EventBusPromise<int> a;
+            EventBusPromise<std::string> b;
+            auto both = whenAll(a.result(), b.result());
+            b.setValue("b");
+            assert(!both.ready());
+            a.setValue(1);
+            auto [aValue, bValue] = both.get();
+            assert(aValue == 1 && bValue == "b");
+
+            // Zwei Pool-Threads, 64 Clients: mit blockierendem get() in den StorageHandler-Handlern
+            // würden alle Worker auf Kind-Aufgaben warten, die keinen Thread mehr bekommen.
+            const std::string dbFile = "db/continuation_test.db";
+            fs::remove(dbFile);
+            {
+                EventBus bus(2);
+                RamHandler ram(bus, 10);
+                DiskHandler disk(bus, dbFile);
+                StorageHandler storage(bus);
+
+                constexpr int clients = 64;
+                constexpr int rounds = 25;
+                auto run = std::async(std::launch::async, [&bus] {
+                    std::vector<std::thread> threads;
+                    for (int c = 0; c < clients; c++) {
+                        threads.emplace_back([&bus, c] {
+                            for (int r = 0; r < rounds; r++) {
+                                const std::string key = "cont_" + std::to_string(c) + "_" + std::to_string(r);
+                                SetEventMessage set;
+                                set.id = key;
+                                set.persistent = r % 2 == 0;
+                                set.ttl = 0;
+                                set.key = key;
+                                set.value = "wert_" + key;
+                                set.group = "contGroup_" + std::to_string(c);
+                                assert(bus.send<SetResponseMessage>(HandlerID::StorageHandler, set).get().response);
+
+                                GetKeyEventMessage get;
+                                get.id = key;
+                                get.key = key;
+                                assert(bus.send<GetKeyResponseMessage>(HandlerID::StorageHandler, get).get().response == "wert_" + key);
+
+                                GetGroupEventMessage group;
+                                group.id = key;
+                                group.group = set.group;
+                                assert(bus.send<GetGroupResponseMessage>(HandlerID::StorageHandler, group).get().response.size() ==
+                                       static_cast<size_t>(r + 1));
+                            }
+                            DeleteGroupEventMessage del;
+                            del.id = "cont_del";
+                            del.group = "contGroup_" + std::to_string(c);
+                            assert(bus.send<DeleteGroupResponseMessage>(HandlerID::StorageHandler, del).get().response == rounds);
+                        });
+                    }
+                    for (auto& thread : threads) {
+                        thread.join();
+                    }
+                });
+                const bool finished = run.wait_for(std::chrono::seconds(120)) == std::future_status::ready;
+                std::cout << "Test40 - " << clients << " Clients auf 2 Pool-Threads: "
+                          << (finished ? "abgeschlossen" : "hängt") << std::endl;
+                assert(finished);
+                run.get();
+            }
+            fs::remove(dbFile);
+        }
+
+        // -----------------------------
+        // Test 41: Lock-freie MPMC-Queue des ThreadPools (Korrektheit, volle Queue, Durchsatz)
+        // -----------------------------
+        {
+            MpmcQueue<int> small(3);
+            assert(small.capacity() == 4 && small.empty());
+            for (int i = 0; i < 4; i++) assert(small.tryPush(int(i)));
+            int overflow = 99;
+            assert(!small.tryPush(std::move(overflow)) && overflow == 99);
+            int value = -1;
+            for (int i = 0; i < 4; i++) assert(small.tryPop(value) && value == i);
+            assert(!small.tryPop(value) && small.empty());
+
+            // Volle Queue: externe Erzeuger warten, Folgeaufgaben der Worker landen in deren eigener Deque.
+            {
+                ThreadPool pool(2, 4);
+                std::atomic<int> done{0};
+                std::vector<std::future<void>> futures;
+                for (int i = 0; i < 200; i++) {
+                    futures.push_back(pool.enqueue([&pool, &done] {
+                        for (int j = 0; j < 10; j++) pool.post([&done] { done++; });
+                        done++;
+                    }));
+                }
+                for (auto& future : futures) future.get();
+                while (done.load() < 200 * 11) std::this_thread::yield();
+            }
+
+            // Bei voller Queue parken externe Erzeuger nach kurzem Warten, statt einen Kern zu belegen.
+            {
+                ThreadPool pool(1, 4);
+                std::promise<void> release;
+                std::shared_future<void> released = release.get_future().share();
+                std::atomic<int> done{0};
+                pool.post([released] { released.wait(); });
+                for (int i = 0; i < 4; i++) pool.post([&done] { done++; });
+                constexpr int producers = 4;
+                std::vector<std::thread> blocked;
+                const std::clock_t cpuStart = std::clock();
+                for (int i = 0; i < producers; i++) {
+                    blocked.emplace_back([&pool, &done] { pool.post([&done] { done++; }); });
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                const double cpuMs = 1000.0 * double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+                std::cout << "Test41 - CPU-Zeit wartender Erzeuger in 300 ms: " << cpuMs << " ms" << std::endl;
+                assert(cpuMs < 150);
+                release.set_value();
+                for (auto& thread : blocked) thread.join();
+                while (done.load() < 4 + producers) std::this_thread::yield();
+            }
+
+            constexpr int itemsPerProducer = 200000;
+            std::cout << "\n=== Queue-Durchsatz (Mio. Push+Pop pro Sekunde) ===" << std::endl;
+            for (int threads : {1, 2, 4, 8}) {
+                MpmcQueue<int> ring(1024);
+                const double lockFree = measureQueueThroughput(threads, threads, itemsPerProducer,
+                    [&ring](int item) { return ring.tryPush(std::move(item)); },
+                    [&ring](int& item) { return ring.tryPop(item); });
+
+                std::mutex mutex;
+                std::queue<int> locked;
+                const double mutexQueue = measureQueueThroughput(threads, threads, itemsPerProducer,
+                    [&](int item) { std::lock_guard<std::mutex> lock(mutex); if (locked.size() >= 1024) return false; locked.push(item); return true; },
+                    [&](int& item) { std::lock_guard<std::mutex> lock(mutex); if (locked.empty()) return false; item = locked.front(); locked.pop(); return true; });
+
+                std::cout << "  " << threads << " Erzeuger / " << threads << " Verbraucher: MPMC-Ring "
+                          << lockFree << ", std::queue + Mutex " << mutexQueue << std::endl;
+            }
+            std::cout << "=============================\n" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 42: Work-Stealing im ThreadPool (lokale LIFO-Deque, Stehlen durch freie Worker)
+        // -----------------------------
+        {
+            // Ein Worker arbeitet seine eigenen Folgeaufgaben neueste zuerst ab.
+            {
+                ThreadPool pool(1);
+                std::vector<int> order;
+                std::mutex orderMutex;
+                pool.enqueue([&] {
+                    for (int i = 1; i <= 5; i++) {
+                        pool.post([&, i] { std::lock_guard<std::mutex> lock(orderMutex); order.push_back(i); });
+                    }
+                }).get();
+                while (true) {
+                    std::lock_guard<std::mutex> lock(orderMutex);
+                    if (order.size() == 5) break;
+                }
+                assert((order == std::vector<int>{5, 4, 3, 2, 1}));
+            }
+
+            // Wartet ein Worker auf seine eigene Folgeaufgabe, muss ein anderer Worker sie stehlen.
+            {
+                ThreadPool pool(2);
+                std::atomic<bool> childRan{false};
+                std::thread::id parentThread;
+                std::thread::id childThread;
+                pool.enqueue([&] {
+                    parentThread = std::this_thread::get_id();
+                    pool.post([&] { childThread = std::this_thread::get_id(); childRan = true; });
+                    while (!childRan) std::this_thread::yield();
+                }).get();
+                assert(childRan && childThread != parentThread);
+            }
+
+            // Viele verschachtelte Aufgaben über alle Worker hinweg.
+            {
+                ThreadPool pool(4);
+                std::atomic<int> done{0};
+                std::vector<std::future<void>> futures;
+                for (int i = 0; i < 100; i++) {
+                    futures.push_back(pool.enqueue([&] {
+                        for (int j = 0; j < 100; j++) pool.post([&done] { done++; });
+                    }));
+                }
+                for (auto& future : futures) future.get();
+                while (done.load() < 100 * 100) std::this_thread::yield();
+            }
+            std::cout << "Test42 - Work-Stealing OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 43: Dispatch ohne Heap-Allokationen (ThreadPool und Inline, kleine Nachrichten)
+        // -----------------------------
+        {
+            EventBus eventBus(1);
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::EventBus,
+                [](const PingMessage& msg) -> PongMessage {
+                    // Der Worker zählt ab jetzt mit.
+                    trackAllocations = true;
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                });
+            eventBus.subscribe<InlinePingMessage, PongMessage>(HandlerID::EventBus,
+                [](const InlinePingMessage& msg) -> PongMessage {
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                },
+                DispatchMode::Inline);
+
+            // Aufwärmen: füllt den BlockPool und die Queues.
+            measureRoundTrip<PingMessage>(eventBus, HandlerID::EventBus, 2000);
+            measureRoundTrip<InlinePingMessage>(eventBus, HandlerID::EventBus, 2000);
+
+            constexpr int rounds = 10000;
+            trackAllocations = true;
+            long long before = trackedAllocations.load();
+            const double pooledUs = measureRoundTrip<PingMessage>(eventBus, HandlerID::EventBus, rounds);
+            const long long pooled = trackedAllocations.load() - before;
+            before = trackedAllocations.load();
+            const double inlineUs = measureRoundTrip<InlinePingMessage>(eventBus, HandlerID::EventBus, rounds);
+            const long long inlined = trackedAllocations.load() - before;
+            trackAllocations = false;
+
+            std::cout << "\n=== Allokationen pro Dispatch (" << rounds << " Round-Trips) ===" << std::endl;
+            std::cout << "  ThreadPool: " << static_cast<double>(pooled) / rounds << " (" << pooledUs
+                      << " us), Inline: " << static_cast<double>(inlined) / rounds << " (" << inlineUs << " us)" << std::endl;
+            std::cout << "=============================\n" << std::endl;
+            assert(pooled == 0 && inlined == 0);
+
+            // Falscher Antworttyp wird schon beim Senden erkannt.
+            PingMessage ping;
+            bool thrown = false;
+            try {
+                eventBus.send<PingMessage>(HandlerID::EventBus, ping);
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+
+        // -----------------------------
+        // Test 44: Routing über HandlerID und TypeIndex (ohne RTTI)
+        // -----------------------------
+        {
+            assert(TypeIndex::of<PingMessage>() != TypeIndex::of<PongMessage>());
+            assert(TypeIndex::of<PingMessage>() == TypeIndex::of<PingMessage>());
+            assert(TypeIndex::name<PingMessage>() == "PingMessage");
+
+            EventBus eventBus(1);
+            auto reply = [](int value) {
+                PongMessage pong;
+                pong.value = value;
+                return pong;
+            };
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::RamHandler,
+                [&](const PingMessage& msg) { return reply(msg.value + 1); });
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::DiskHandler,
+                [&](const PingMessage& msg) { return reply(msg.value + 3); });
+            eventBus.subscribe<InlinePingMessage, PongMessage>(HandlerID::DiskHandler,
+                [&](const InlinePingMessage& msg) { return reply(msg.value + 2); }, DispatchMode::Inline);
+
+            PingMessage ping;
+            InlinePingMessage inlinePing;
+            assert(eventBus.send<PongMessage>(HandlerID::RamHandler, ping).get().value == 1);
+            assert(eventBus.send<PongMessage>(HandlerID::DiskHandler, ping).get().value == 3);
+            assert(eventBus.send<PongMessage>(HandlerID::DiskHandler, inlinePing).get().value == 2);
+
+            auto throws = [](auto&& fn) {
+                try {
+                    fn();
+                } catch (const std::runtime_error&) {
+                    return true;
+                }
+                return false;
+            };
+            // Nachrichtentyp ohne Handler unter dieser ID bzw. ID ganz ohne Handler.
+            assert(throws([&] { eventBus.send<PongMessage>(HandlerID::RamHandler, inlinePing); }));
+            assert(throws([&] { eventBus.send<PongMessage>(HandlerID::SocketHandler, ping); }));
+
+            assert(eventBus.unsubscribe<PingMessage>(HandlerID::RamHandler));
+            assert(!eventBus.unsubscribe<PingMessage>(HandlerID::RamHandler));
+            assert(throws([&] { eventBus.send<PongMessage>(HandlerID::RamHandler, ping); }));
+            assert(eventBus.send<PongMessage>(HandlerID::DiskHandler, ping).get().value == 3);
+            std::cout << "Test44 - Routing ohne RTTI OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 45: Handler-Tabelle als Snapshot (Senden während An- und Abmeldungen)
+        // -----------------------------
+        {
+            EventBus eventBus(1);
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::RamHandler,
+                [](const PingMessage& msg) -> PongMessage {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(msg.value == 0 ? 50 : 0));
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                });
+
+            // Eine wartende Pool-Aufgabe läuft auch nach dem Abmelden ihres Handlers noch.
+            PingMessage slow;
+            PingMessage queued;
+            queued.value = 7;
+            auto first = eventBus.send<PongMessage>(HandlerID::RamHandler, slow);
+            auto second = eventBus.send<PongMessage>(HandlerID::RamHandler, queued);
+            assert(eventBus.unsubscribe<PingMessage>(HandlerID::RamHandler));
+            assert(first.get().value == 1 && second.get().value == 8);
+
+            // Inline-Sender laufen ohne Sperre, während ein anderer Thread ständig an- und abmeldet.
+            eventBus.subscribe<InlinePingMessage, PongMessage>(HandlerID::RamHandler,
+                [](const InlinePingMessage& msg) -> PongMessage {
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                },
+                DispatchMode::Inline);
+            std::atomic<bool> stopChurn{false};
+            std::thread churn([&] {
+                // Begrenzt, weil jede Änderung eine Tabelle bis zum Ende der EventBus belegt.
+                for (int i = 0; i < 200 && !stopChurn; i++) {
+                    eventBus.subscribe<PingMessage, PongMessage>(HandlerID::DiskHandler,
+                        [](const PingMessage& msg) -> PongMessage {
+                            PongMessage pong;
+                            pong.value = msg.value;
+                            return pong;
+                        });
+                    assert(eventBus.unsubscribe<PingMessage>(HandlerID::DiskHandler));
+                }
+            });
+            std::vector<std::thread> senders;
+            for (int t = 0; t < 4; t++) {
+                senders.emplace_back([&] {
+                    InlinePingMessage msg;
+                    for (int i = 0; i < 500; i++) {
+                        msg.value = i;
+                        assert(eventBus.send<PongMessage>(HandlerID::RamHandler, msg).get().value == i + 1);
+                    }
+                });
+            }
+            for (auto& sender : senders) sender.join();
+            stopChurn = true;
+            churn.join();
+            std::cout << "Test45 - Handler-Snapshot OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 46: send() mit Eigentumsübergabe (verschieben statt kopieren, Fire-and-Forget)
+        // -----------------------------
+        {
+            EventBus eventBus(2);
+            std::atomic<const char*> seenBuffer{nullptr};
+            std::atomic<int> handled{0};
+            eventBus.subscribe<PayloadMessage, PongMessage>(HandlerID::DiskHandler,
+                [&](const PayloadMessage& msg) -> PongMessage {
+                    seenBuffer = msg.payload.data();
+                    handled++;
+                    PongMessage pong;
+                    pong.value = static_cast<int>(msg.payload.size());
+                    return pong;
+                });
+
+            // Der Puffer des Werts kommt unverändert beim Handler an.
+            PayloadMessage big;
+            big.payload.assign(1 << 20, 'x');
+            const char* buffer = big.payload.data();
+            auto result = eventBus.send<PongMessage>(HandlerID::DiskHandler, std::move(big));
+            assert(result.get().value == (1 << 20));
+            assert(seenBuffer.load() == buffer);
+
+            // Fire-and-Forget: Ergebnisse werden sofort verworfen, die Nachrichten leben trotzdem lange genug.
+            constexpr int messages = 1000;
+            for (int i = 0; i < messages; i++) {
+                PayloadMessage msg;
+                msg.payload = "wert_" + std::to_string(i) + std::string(64, 'y');
+                eventBus.send<PongMessage>(HandlerID::DiskHandler, std::move(msg));
+            }
+            while (handled.load() < messages + 1) std::this_thread::yield();
+
+            // Lvalues werden weiterhin nur referenziert und bleiben beim Aufrufer.
+            PayloadMessage kept;
+            kept.payload = "bleibt";
+            assert(eventBus.send<PongMessage>(HandlerID::DiskHandler, kept).get().value == 6);
+            assert(kept.payload == "bleibt");
+            std::cout << "Test46 - send() mit Eigentumsübergabe OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 47: Koroutinen (co_await auf EventBusResult, Koroutine als Handler)
+        // -----------------------------
+        {
+            // Die Koroutine hält an, bis das Ergebnis vorliegt, und läuft dann auf dem erfüllenden Thread weiter.
+            EventBusPromise<int> input;
+            EventBusResult<int> doubled = doubleLater(input.result());
+            assert(!doubled.ready());
+            std::thread([input] { input.setValue(21); }).join();
+            assert(doubled.ready() && doubled.get() == 42);
+
+            // Bereits erfüllte Ergebnisse laufen ohne Unterbrechung durch; Ausnahmen kommen beim Aufrufer an.
+            assert(doubleLater(makeReadyResult(5)).get() == 10);
+            EventBusPromise<int> failing;
+            EventBusResult<int> failed = doubleLater(failing.result());
+            failing.setException(std::make_exception_ptr(std::runtime_error("fehlgeschlagen")));
+            bool thrown = false;
+            try {
+                failed.get();
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+
+            // Eine Koroutine als asynchroner Handler, die zweimal einen Pool-Handler befragt.
+            EventBus eventBus(1);
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::RamHandler,
+                [](const PingMessage& msg) -> PongMessage {
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                });
+            eventBus.subscribeAsync<PingMessage, PongMessage>(HandlerID::StorageHandler,
+                [&](const PingMessage& msg) { return pingTwice(eventBus, msg); });
+            for (int i = 0; i < 100; i++) {
+                PingMessage ping;
+                ping.value = i;
+                assert(eventBus.send<PongMessage>(HandlerID::StorageHandler, ping).get().value == i + 2);
+            }
+            std::cout << "Test47 - Koroutinen OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 48: sendBatch (eine Pool-Aufgabe pro Batch, Batch-Callbacks der Speicherebenen)
+        // -----------------------------
+        {
+            EventBus eventBus(2);
+            std::atomic<int> singleCalls{0};
+            std::atomic<int> batchCalls{0};
+            eventBus.subscribe<PingMessage, PongMessage>(HandlerID::RamHandler,
+                [&](const PingMessage& msg) -> PongMessage {
+                    singleCalls++;
+                    PongMessage pong;
+                    pong.value = msg.value + 1;
+                    return pong;
+                });
+            eventBus.subscribeAsync<PingMessage, PongMessage>(HandlerID::StorageHandler,
+                [&](const PingMessage& msg) { return pingTwice(eventBus, msg); });
+
+            std::vector<PingMessage> pings(50);
+            for (int i = 0; i < 50; i++) pings[i].value = i;
+
+            // Ohne Batch-Callback läuft der Einzel-Handler je Nachricht, Antworten in Reihenfolge.
+            std::vector<PongMessage> pongs = eventBus.sendBatch<PongMessage>(HandlerID::RamHandler, pings).get();
+            assert(pongs.size() == 50 && singleCalls == 50);
+            for (int i = 0; i < 50; i++) assert(pongs[i].value == i + 1);
+
+            // Asynchrone Handler (Koroutine) werden je Nachricht gestartet und zusammengeführt.
+            pongs = eventBus.sendBatch<PongMessage>(HandlerID::StorageHandler, std::span<const PingMessage>(pings)).get();
+            for (int i = 0; i < 50; i++) assert(pongs[i].value == i + 2);
+
+            // Mit Batch-Callback kommt der ganze Batch in einem Aufruf an; send() bleibt beim Einzel-Handler.
+            eventBus.subscribeBatch<PingMessage, PongMessage>(HandlerID::RamHandler,
+                [&](std::span<const PingMessage> msgs) {
+                    batchCalls++;
+                    std::vector<PongMessage> responses(msgs.size());
+                    for (size_t i = 0; i < msgs.size(); i++) responses[i].value = msgs[i].value + 10;
+                    return responses;
+                });
+            pongs = eventBus.sendBatch<PongMessage>(HandlerID::RamHandler, std::move(pings)).get();
+            assert(batchCalls == 1 && pongs.size() == 50 && pongs[49].value == 59);
+            PingMessage single;
+            assert(eventBus.send<PongMessage>(HandlerID::RamHandler, single).get().value == 1);
+            assert(eventBus.sendBatch<PongMessage>(HandlerID::RamHandler, std::vector<PingMessage>()).get().empty());
+
+            // Speicherebene: SET/GET KEY als Batch gegen einzelne Sends (SQLite, ein Commit pro Batch).
+            const std::string dir = "db/send_batch";
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+            {
+                EventBus tierBus(4);
+                SqliteEngine engine(dir + "/batch.db");
+                StorageEngineBinding binding(tierBus, HandlerID::DiskHandler, engine, "BatchTest");
+                constexpr int entries = 500;
+                auto makeSets = [](const std::string& prefix) {
+                    std::vector<SetEventMessage> sets(entries);
+                    for (int i = 0; i < entries; i++) {
+                        sets[i].id = "b" + std::to_string(i);
+                        sets[i].persistent = true;
+                        sets[i].ttl = 0;
+                        sets[i].key = prefix + std::to_string(i);
+                        sets[i].value = "wert_" + std::to_string(i);
+                        sets[i].group = "batch";
+                    }
+                    return sets;
+                };
+
+                std::vector<SetEventMessage> singles = makeSets("single_");
+                auto singleStart = std::chrono::high_resolution_clock::now();
+                for (const auto& msg : singles) {
+                    assert(tierBus.send<SetResponseMessage>(HandlerID::DiskHandler, msg).get().response);
+                }
+                auto batchStart = std::chrono::high_resolution_clock::now();
+                std::vector<SetResponseMessage> stored =
+                    tierBus.sendBatch<SetResponseMessage>(HandlerID::DiskHandler, makeSets("batch_")).get();
+                auto end = std::chrono::high_resolution_clock::now();
+                assert(stored.size() == entries && stored[7].id == "b7" && stored[7].response);
+
+                std::vector<GetKeyEventMessage> gets(3);
+                gets[0].key = "batch_0";
+                gets[1].key = "fehlt";
+                gets[2].key = "single_499";
+                std::vector<GetKeyResponseMessage> values = tierBus.sendBatch<GetKeyResponseMessage>(HandlerID::DiskHandler, gets).get();
+                assert(values[0].response == "wert_0" && values[1].response.empty() && values[2].response == "wert_499");
+
+                std::cout << "\n=== sendBatch (" << entries << " SETs, SQLite) ===" << std::endl;
+                std::cout << "  Einzeln: " << std::chrono::duration<double, std::milli>(batchStart - singleStart).count()
+                          << " ms, Batch: " << std::chrono::duration<double, std::milli>(end - batchStart).count() << " ms" << std::endl;
+                std::cout << "=============================\n" << std::endl;
+            }
+            fs::remove_all(dir);
+            std::cout << "Test48 - sendBatch OK" << std::endl;
+        }
+
+        // -----------------------------
+        // Test 49: Herunterfahren des SocketHandlers mit offenen Verbindungen (eigener EventBus)
+        // -----------------------------
+        {
+            const std::string dir = "db/shutdown_test";
+            const std::string socketPath = dir + "/shutdown.sock";
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+            auto connectClient = [&socketPath]() {
+                int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+                assert(sock >= 0);
+                sockaddr_un addr;
+                std::memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+                // Der Server-Thread legt den Socket erst nach dem Start an.
+                for (int attempt = 0; connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0; attempt++) {
+                    assert(attempt < 100);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+                return sock;
+            };
+
+            // Der EventBus wird zuerst angelegt, damit er die Handler überlebt.
+            EventBus bus;
+            std::optional<RamHandler> ram(std::in_place, bus, 10);
+            std::optional<DiskHandler> disk(std::in_place, bus, dir + "/shutdown.db");
+            std::optional<StorageHandler> storage(std::in_place, bus);
+            {
+                SocketHandler server(socketPath, bus);
+                std::thread serverThread([&server]() { server.run(); });
+
+                int idleClient = connectClient();
+                int activeClient = connectClient();
+                json req = {
+                    {"id", "shutdown_set"},
+                    {"event", "SET"},
+                    {"flags", {{"persistent", true}, {"ttl", 0}}},
+                    {"key", "shutdownKey"},
+                    {"value", "shutdownValue"},
+                    {"group", "shutdownGroup"}
+                };
+                std::string line = req.dump() + "\n";
+                assert(write(activeClient, line.data(), line.size()) == static_cast<ssize_t>(line.size()));
+                std::string response;
+                char buffer[1024];
+                ssize_t n;
+                while (response.find('\n') == std::string::npos &&
+                       (n = read(activeClient, buffer, sizeof(buffer))) > 0) {
+                    response.append(buffer, n);
+                }
+                assert(json::parse(response.substr(0, response.find('\n')))["response"] == true);
+
+                // run() kehrt erst zurück, wenn alle Client-Threads beendet sind; die Clients sehen EOF.
+                server.stop();
+                serverThread.join();
+                assert(read(idleClient, buffer, sizeof(buffer)) == 0);
+                assert(read(activeClient, buffer, sizeof(buffer)) == 0);
+                close(idleClient);
+                close(activeClient);
+            }
+
+            // Nach dem Abbau sind die Handler abgemeldet; Anfragen erreichen keine zerstörten Objekte.
+            storage.reset();
+            disk.reset();
+            ram.reset();
+            GetKeyEventMessage get;
+            get.id = "shutdown_get";
+            get.key = "shutdownKey";
+            for (HandlerID id : {HandlerID::StorageHandler, HandlerID::DiskHandler, HandlerID::RamHandler}) {
+                bool rejected = false;
+                try {
+                    bus.send<GetKeyResponseMessage>(id, get).get();
+                } catch (const std::exception&) {
+                    rejected = true;
+                }
+                assert(rejected);
+            }
+            fs::remove_all(dir);
+            std::cout << "Test49 - Herunterfahren mit offenen Verbindungen OK" << std::endl;
+        }
+
         std::cout << "Alle erweiterten Client-Tests erfolgreich bestanden!" << std::endl;
     }
     catch (const std::exception& ex) {